@@ -0,0 +1,199 @@
+// Converts utterance recordings from AudioRecorder back to WAV for the replay
+// harness, and makes such recordings from WAV files to check the encoder.
+//
+//   adpcm_wav decode <recording> <out.wav> [-split]
+//   adpcm_wav encode <in.wav> <recording>
+//
+// decode reads the binary stream (a file from flush() or the recording
+// partition read back with parttool.py) or a serial log holding "ADPCM <hex>"
+// lines, taking the last recording in it. Utterances are joined with 300 ms
+// of silence; -split writes out_1.wav, out_2.wav, ... instead.
+//
+// encode runs the file through the VAD gate and the recorder as the capture
+// task would, writes the recording and reports the encoder's cost per frame
+// and the decoded audio's SNR against the input.
+#include "audio_recorder.h"
+#include "vad.h"
+#include "wav_capture.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace Audio;
+
+namespace {
+
+constexpr int GapFrames = 30; // silence between joined utterances
+
+bool readFile(const char *path, std::vector<uint8_t> &bytes) {
+    FILE *f = std::fopen(path, "rb");
+    if (!f) return false;
+    uint8_t buf[4096];
+    for (size_t n; (n = std::fread(buf, 1, sizeof(buf), f)) > 0; ) bytes.insert(bytes.end(), buf, buf + n);
+    std::fclose(f);
+    return true;
+}
+
+// hex payloads of the ADPCM lines in a serial log, from the last header on
+bool fromSerialLog(const std::vector<uint8_t> &text, std::vector<uint8_t> &bytes) {
+    std::string log(text.begin(), text.end());
+    bytes.clear();
+    size_t pos = 0;
+    for (size_t p; (p = log.find("ADPCM ", pos)) != std::string::npos; ) {
+        size_t end = log.find_first_of("\r\n", p);
+        if (end == std::string::npos) end = log.size();
+        std::vector<uint8_t> line;
+        for (size_t i=p + 6; i + 1 < end; i+=2) line.push_back((uint8_t)std::strtoul(log.substr(i, 2).c_str(), nullptr, 16));
+        uint32_t magic = 0;
+        if (line.size() >= 4) std::memcpy(&magic, line.data(), 4);
+        if (magic == AudioRecorder::Magic && line.size() == AudioRecorder::HeaderSize) bytes.clear(); // a later dump
+        bytes.insert(bytes.end(), line.begin(), line.end());
+        pos = end;
+    }
+    return !bytes.empty();
+}
+
+// frames of a recording stream; false if it has no valid header
+bool parse(const std::vector<uint8_t> &bytes, std::vector<RecordedFrame> &frames) {
+    uint32_t magic;
+    uint16_t fields[3];
+    if (bytes.size() < AudioRecorder::HeaderSize) return false;
+    std::memcpy(&magic, bytes.data(), 4);
+    std::memcpy(fields, bytes.data() + 4, sizeof(fields));
+    if (magic != AudioRecorder::Magic || fields[0] != AudioRecorder::Version || fields[1] != SampleRate ||
+        fields[2] != FrameSamples)
+        return false;
+    for (size_t off=AudioRecorder::HeaderSize; off + sizeof(RecordedFrame) <= bytes.size(); off+=sizeof(RecordedFrame)) {
+        RecordedFrame f;
+        std::memcpy(&f, bytes.data() + off, sizeof(f));
+        if (f.sequence == 0xffffffffu && f.flags == 0xff) break; // erased flash after the last frame
+        frames.push_back(f);
+    }
+    return true;
+}
+
+// utterances as PCM: a new one at each First flag or sequence jump
+std::vector<std::vector<int16_t>> decode(const std::vector<RecordedFrame> &frames) {
+    std::vector<std::vector<int16_t>> utterances;
+    for (size_t i=0; i<frames.size(); ++i) {
+        const RecordedFrame &f = frames[i];
+        if (utterances.empty() || (f.flags & SpeechFrame::First) || f.sequence != frames[i - 1].sequence + 1)
+            utterances.emplace_back();
+        AdpcmState st;
+        st.predictor = f.predictor;
+        st.index = f.index;
+        std::vector<int16_t> &pcm = utterances.back();
+        pcm.resize(pcm.size() + FrameSamples);
+        adpcmDecode(f.data, FrameSamples, pcm.data() + pcm.size() - FrameSamples, st);
+    }
+    return utterances;
+}
+
+int decodeCommand(const char *in, const std::string &out, bool split) {
+    std::vector<uint8_t> bytes;
+    if (!readFile(in, bytes)) { std::perror(in); return 1; }
+    std::vector<RecordedFrame> frames;
+    std::vector<uint8_t> fromLog;
+    if (!parse(bytes, frames) && !(fromSerialLog(bytes, fromLog) && parse(fromLog, frames))) {
+        std::fprintf(stderr, "%s: no recording found\n", in);
+        return 1;
+    }
+    std::vector<std::vector<int16_t>> utterances = decode(frames);
+    if (split) {
+        std::string stem = out.size() > 4 && out.compare(out.size() - 4, 4, ".wav") == 0 ? out.substr(0, out.size() - 4) : out;
+        for (size_t i=0; i<utterances.size(); ++i) {
+            std::string path = stem + "_" + std::to_string(i + 1) + ".wav";
+            if (!saveWav(path, utterances[i].data(), utterances[i].size())) { std::perror(path.c_str()); return 1; }
+        }
+    } else {
+        std::vector<int16_t> pcm;
+        for (const std::vector<int16_t> &u : utterances) {
+            if (!pcm.empty()) pcm.resize(pcm.size() + GapFrames * FrameSamples, 0);
+            pcm.insert(pcm.end(), u.begin(), u.end());
+        }
+        if (!saveWav(out, pcm.data(), pcm.size())) { std::perror(out.c_str()); return 1; }
+    }
+    std::printf("%zu frames (%.2f s of speech) in %zu utterances -> %s%s\n", frames.size(),
+                frames.size() * (double)FrameSamples / SampleRate, utterances.size(), out.c_str(), split ? " (split)" : "");
+    return 0;
+}
+
+int encodeCommand(const char *in, const char *out) {
+    std::vector<int16_t> input;
+    std::string err;
+    if (!loadWav(in, input, err)) { std::fprintf(stderr, "%s: %s\n", in, err.c_str()); return 1; }
+    size_t frameCount = input.size() / FrameSamples;
+    AudioRecorder recorder((uint32_t)frameCount + 1);
+    SpeechRing speech;
+    VadGate gate(speech);
+    gate.setRecorder(&recorder);
+    Frame f;
+    for (size_t i=0; i<frameCount; ++i) {
+        f.sequence = (uint32_t)i;
+        std::memcpy(f.samples, &input[i * FrameSamples], sizeof(f.samples));
+        gate.push(f);
+        while (speech.readSlot()) speech.releaseRead();
+    }
+
+    // the encoder alone, over every frame of the file
+    std::vector<uint8_t> coded(FrameSamples / 2);
+    AdpcmState st;
+    int rounds = 0;
+    auto start = std::chrono::steady_clock::now();
+    double secs = 0;
+    do {
+        for (size_t i=0; i<frameCount; ++i) adpcmEncode(&input[i * FrameSamples], FrameSamples, coded.data(), st);
+        ++rounds;
+        secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (secs < 0.2 && frameCount);
+
+    FILE *file = std::fopen(out, "wb");
+    if (!file) { std::perror(out); return 1; }
+    size_t bytes = 0;
+    recorder.flush([&](const void *data, size_t len) {
+        bytes += len;
+        return std::fwrite(data, 1, len, file) == len;
+    });
+    std::fclose(file);
+
+    // decode the recording again and compare with the frames it came from
+    std::vector<uint8_t> stream;
+    std::vector<RecordedFrame> frames;
+    readFile(out, stream);
+    parse(stream, frames);
+    double signal = 0, noise = 0;
+    for (const RecordedFrame &r : frames) {
+        int16_t pcm[FrameSamples];
+        AdpcmState s;
+        s.predictor = r.predictor;
+        s.index = r.index;
+        adpcmDecode(r.data, FrameSamples, pcm, s);
+        for (int i=0; i<FrameSamples; ++i) {
+            double x = input[r.sequence * FrameSamples + i], e = pcm[i] - x;
+            signal += x * x;
+            noise += e * e;
+        }
+    }
+    std::printf("%zu of %zu frames recorded as speech, %zu bytes (%.2f:1 against 16-bit PCM)\n", frames.size(), frameCount,
+                bytes, frames.empty() ? 0.0 : frames.size() * FrameSamples * 2.0 / bytes);
+    std::printf("encode: %.2f us per 10 ms frame (%.3f%% of real time on this host)\n",
+                frameCount ? secs * 1e6 / (rounds * frameCount) : 0.0,
+                frameCount ? 100 * secs / (rounds * frameCount * 0.01) : 0.0);
+    std::printf("decoded SNR %.1f dB\n", noise > 0 ? 10 * std::log10(signal / noise) : 99.0);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc >= 4 && !std::strcmp(argv[1], "decode"))
+        return decodeCommand(argv[2], argv[3], argc > 4 && !std::strcmp(argv[4], "-split"));
+    if (argc >= 4 && !std::strcmp(argv[1], "encode")) return encodeCommand(argv[2], argv[3]);
+    std::fprintf(stderr, "usage: adpcm_wav decode <recording> <out.wav> [-split]\n"
+                         "       adpcm_wav encode <in.wav> <recording>\n");
+    return 2;
+}
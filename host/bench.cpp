@@ -0,0 +1,198 @@
+// Micro-benchmarks for the chess core. Prints a table and writes the results
+// as JSON (default bench_results.json) so runs can be diffed between commits.
+//
+//   chess_bench [output.json] [min-seconds-per-benchmark] [threads]
+//
+// With more than one thread (default: all hardware threads) split-at-root
+// perft and Lazy SMP search are also run at 1, 2, 4, ... threads, followed by
+// a table of speedup and scaling efficiency against one thread.
+#include "board.h"
+#include "eval.h"
+#include "game.h"
+#include "search.h"
+#include "positions.h"
+#include "bench_util.h"
+#include "parallel_perft.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Chess;
+
+namespace {
+
+volatile uint64_t sink; // keeps results observable so loops are not optimized away
+
+uint64_t perft(Board &b, int depth) {
+    MoveList moves;
+    b.generateLegal(b.sideToMove, moves);
+    if (depth == 1) return moves.size();
+    uint64_t nodes = 0;
+    for (const Move &m : moves) {
+        b.makeMove(m);
+        nodes += perft(b, depth - 1);
+        b.undoMove();
+    }
+    return nodes;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const char *outPath = argc > 1 ? argv[1] : "bench_results.json";
+    double minSeconds = argc > 2 ? std::atof(argv[2]) : 0.5;
+    int maxThreads = argc > 3 ? std::atoi(argv[3]) : (int)std::thread::hardware_concurrency();
+
+    std::vector<Board> boards;
+    for (const PerftPosition &p : PerftSuite) {
+        boards.emplace_back();
+        boards.back().loadFEN(p.fen);
+    }
+    std::vector<MoveList> legal(boards.size());
+    for (size_t i=0; i<boards.size(); ++i) boards[i].generateLegal(boards[i].sideToMove, legal[i]);
+
+    std::vector<BenchResult> results;
+    results.push_back(measure("make_undo", minSeconds, [&]() {
+        uint64_t n = 0;
+        for (size_t i=0; i<boards.size(); ++i)
+            for (const Move &m : legal[i]) { boards[i].makeMove(m); boards[i].undoMove(); ++n; }
+        return n;
+    }));
+    results.push_back(measure("is_square_attacked", minSeconds, [&]() {
+        uint64_t n = 0, hits = 0;
+        for (const Board &b : boards)
+            for (int sq=0; sq<64; ++sq) {
+                hits += b.isSquareAttacked(sq, Color::White) + b.isSquareAttacked(sq, Color::Black);
+                n += 2;
+            }
+        sink = hits;
+        return n;
+    }));
+    results.push_back(measure("evaluate", minSeconds, [&]() {
+        int sum = 0;
+        for (const Board &b : boards) sum += evaluate(b);
+        sink = (uint64_t)sum;
+        return (uint64_t)boards.size();
+    }));
+    results.push_back(measure("evaluate_full", minSeconds, [&]() {
+        int sum = 0;
+        for (const Board &b : boards) sum += evaluateFull(b);
+        sink = (uint64_t)sum;
+        return (uint64_t)boards.size();
+    }));
+    results.push_back(measure("generate_pseudo_legal", minSeconds, [&]() {
+        MoveList moves;
+        uint64_t total = 0;
+        for (const Board &b : boards) { b.generatePseudoLegal(b.sideToMove, moves); total += moves.size(); }
+        sink = total;
+        return (uint64_t)boards.size();
+    }));
+    results.push_back(measure("generate_legal", minSeconds, [&]() {
+        MoveList moves;
+        uint64_t total = 0;
+        for (Board &b : boards) { b.generateLegal(b.sideToMove, moves); total += moves.size(); }
+        sink = total;
+        return (uint64_t)boards.size();
+    }));
+    results.push_back(measure("generate_legal_filtered", minSeconds, [&]() {
+        MoveList moves;
+        uint64_t total = 0;
+        for (Board &b : boards) { b.generateLegalFiltered(b.sideToMove, moves); total += moves.size(); }
+        sink = total;
+        return (uint64_t)boards.size();
+    }));
+    Game game;
+    const char *queries[] = {"e2e4", "g1f3", "e2e5", "a7a6", "b1c3", "e1g1", "d2d4", "h2h3"};
+    results.push_back(measure("game_is_legal_uci", minSeconds, [&]() {
+        // cached legal list: repeated queries against one position
+        uint64_t hits = 0;
+        for (const char *q : queries) hits += game.isLegalUCI(q);
+        sink = hits;
+        return (uint64_t)(sizeof(queries) / sizeof(queries[0]));
+    }));
+    const char *phrases[] = {"knight to f3", "e four", "Nc3", "bishop takes e5", "castle kingside", "pawn d4"};
+    results.push_back(measure("game_resolve_move", minSeconds, [&]() {
+        uint64_t ok = 0;
+        for (const char *p : phrases) ok += game.resolveMove(p).status == Resolution::Status::Ok;
+        sink = ok;
+        return (uint64_t)(sizeof(phrases) / sizeof(phrases[0]));
+    }));
+    Game saved;
+    for (const char *m : {"e2e4", "e7e5", "g1f3", "b8c6", "f1b5", "a7a6", "b5a4", "g8f6", "e1g1", "f8e7"}) saved.playMoveUCI(m);
+    std::vector<uint8_t> snapshot = saved.saveSnapshot();
+    results.push_back(measure("game_save_snapshot", minSeconds, [&]() {
+        sink = saved.saveSnapshot().size();
+        return (uint64_t)1;
+    }));
+    results.push_back(measure("game_load_snapshot", minSeconds, [&]() {
+        sink = game.loadSnapshot(snapshot.data(), snapshot.size());
+        return (uint64_t)1;
+    }));
+    results.push_back(measure("fen_round_trip", minSeconds, [&]() {
+        Board b;
+        uint64_t n = 0;
+        for (const PerftPosition &p : PerftSuite) { b.loadFEN(p.fen); sink = b.toFEN().size(); ++n; }
+        return n;
+    }));
+    game.newGame();
+    results.push_back(measure("perft_startpos_d4", minSeconds, [&]() {
+        Board b;
+        return perft(b, 4);
+    }));
+
+    Search search(16 << 20);
+    results.push_back(measure("search_nodes", minSeconds, [&]() {
+        // fixed-depth search from every suite position; one op per node
+        uint64_t n = 0;
+        SearchLimits limits;
+        limits.maxDepth = 5;
+        for (const Board &b : boards) { search.clear(); n += search.think(b, limits).nodes; }
+        return n;
+    }));
+
+    // thread scaling: perft nodes/s, and time to a fixed search depth (Lazy SMP
+    // searches more nodes than one thread would, so nodes/s overstates it; the
+    // nodes per position show by how much)
+    struct Scaling { int threads; BenchResult perft, search; double searchNodes; };
+    std::vector<Scaling> scaling;
+    for (int t=1; maxThreads > 1 && t <= maxThreads; t = t * 2 > maxThreads && t < maxThreads ? maxThreads : t * 2) {
+        std::string suffix = "_t" + std::to_string(t);
+        BenchResult p = measure("perft_startpos_d5" + suffix, minSeconds, [&]() {
+            Board b;
+            return parallelPerft(b, 5, t, perft);
+        });
+        Search smp(64 << 20);
+        smp.setThreads(t);
+        uint64_t smpNodes = 0;
+        BenchResult s = measure("search_smp_d7" + suffix, minSeconds, [&]() {
+            SearchLimits limits;
+            limits.maxDepth = 7;
+            for (const Board &b : boards) { smp.clear(); smpNodes += smp.think(b, limits).nodes; }
+            return (uint64_t)boards.size();
+        });
+        results.push_back(p);
+        results.push_back(s);
+        // measure's warm-up round searched the positions once more
+        scaling.push_back({t, p, s, (double)smpNodes / (s.ops + boards.size())});
+    }
+
+    printResults(results);
+    if (!scaling.empty()) {
+        std::printf("\n%-8s %12s %8s %10s %14s %14s %8s %10s\n", "threads", "perft Mnps", "speedup", "efficiency",
+                    "search ms/pos", "knodes/pos", "speedup", "efficiency");
+        const Scaling &one = scaling.front();
+        for (const Scaling &s : scaling) {
+            double perftSpeedup = one.perft.nsPerOp() / s.perft.nsPerOp();
+            double searchSpeedup = one.search.nsPerOp() / s.search.nsPerOp();
+            std::printf("%-8d %12.2f %8.2f %9.0f%% %14.1f %14.1f %8.2f %9.0f%%\n", s.threads, 1e3 / s.perft.nsPerOp(),
+                        perftSpeedup, 100 * perftSpeedup / s.threads, s.search.nsPerOp() / 1e6, s.searchNodes / 1e3,
+                        searchSpeedup, 100 * searchSpeedup / s.threads);
+        }
+        if ((int)std::thread::hardware_concurrency() < maxThreads)
+            std::printf("(only %u hardware threads)\n", std::thread::hardware_concurrency());
+    }
+    if (!writeJson(outPath, results)) return 1;
+    return 0;
+}
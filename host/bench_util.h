@@ -0,0 +1,50 @@
+#pragma once
+// Timing loop and JSON output shared by the host benchmarks.
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+struct BenchResult {
+    std::string name;
+    uint64_t ops;
+    double seconds;
+    double nsPerOp() const { return seconds * 1e9 / ops; }
+};
+
+// Runs body (which performs and returns some number of operations) until
+// minSeconds have elapsed.
+inline BenchResult measure(const std::string &name, double minSeconds, const std::function<uint64_t()> &body) {
+    body(); // warm-up
+    uint64_t ops = 0;
+    auto start = std::chrono::steady_clock::now();
+    double secs = 0;
+    do {
+        ops += body();
+        secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    } while (secs < minSeconds);
+    return {name, ops, secs};
+}
+
+inline void printResults(const std::vector<BenchResult> &results) {
+    std::printf("%-24s %14s %12s\n", "benchmark", "ops", "ns/op");
+    for (const BenchResult &r : results) std::printf("%-24s %14llu %12.2f\n", r.name.c_str(), (unsigned long long)r.ops, r.nsPerOp());
+}
+
+// {"benchmarks": [{name, ops, seconds, ns_per_op}, ...]}, so runs can be diffed between commits
+inline bool writeJson(const char *path, const std::vector<BenchResult> &results) {
+    FILE *f = std::fopen(path, "w");
+    if (!f) { std::perror(path); return false; }
+    std::fprintf(f, "{\n  \"benchmarks\": [\n");
+    for (size_t i=0; i<results.size(); ++i) {
+        const BenchResult &r = results[i];
+        std::fprintf(f, "    {\"name\": \"%s\", \"ops\": %llu, \"seconds\": %.6f, \"ns_per_op\": %.3f}%s\n",
+                     r.name.c_str(), (unsigned long long)r.ops, r.seconds, r.nsPerOp(), i+1<results.size() ? "," : "");
+    }
+    std::fprintf(f, "  ]\n}\n");
+    std::fclose(f);
+    std::printf("wrote %s\n", path);
+    return true;
+}
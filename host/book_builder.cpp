@@ -0,0 +1,183 @@
+// Compiles an opening book for OpeningBook from PGN games.
+//
+//   book_builder <out.bin> <games.pgn>... [-plies N] [-min N]
+//
+// The first plies of every game are counted per (position, move). A move is
+// weighted by the results it led to for the side playing it: 2 for a win, 1
+// for a draw, 0 for a loss, so lines that only ever lost stay in the book
+// with weight 0 and are never picked. Pairs seen in fewer than -min games
+// are dropped. Weights are scaled into 16 bits and the records written
+// sorted by key, heaviest move first within a position.
+#include "game.h"
+#include "opening_book.h"
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace Chess;
+
+namespace {
+
+struct Tally {
+    uint32_t games = 0;
+    uint32_t score = 0; // in half points for the mover
+};
+
+struct Builder {
+    int maxPlies = 24;
+    uint32_t minGames = 1;
+    std::map<std::pair<uint64_t, uint16_t>, Tally> tallies;
+    int games = 0, badMoves = 0;
+
+    // result: 2 White won, 0 Black won, 1 draw, -1 unknown
+    void addGame(const std::vector<std::string> &sans, int result) {
+        if (result < 0) return;
+        Game game;
+        int ply = 0;
+        for (const std::string &san : sans) {
+            if (ply >= maxPlies) break;
+            Resolution r = game.resolveMove(san);
+            if (r.status != Resolution::Status::Ok) { ++badMoves; break; }
+            bool white = game.position().sideToMove == Color::White;
+            Tally &t = tallies[{game.position().key, OpeningBook::encodeMove(r.move)}];
+            ++t.games;
+            t.score += (uint32_t)(white ? result : 2 - result);
+            game.playMove(r.move);
+            ++ply;
+        }
+        ++games;
+    }
+
+    size_t write(const char *path) const {
+        struct Record { uint64_t key; uint16_t move; uint32_t score; };
+        std::vector<Record> records;
+        uint32_t top = 1;
+        for (const auto &kv : tallies) {
+            if (kv.second.games < minGames) continue;
+            records.push_back({kv.first.first, kv.first.second, kv.second.score});
+            top = std::max(top, kv.second.score);
+        }
+        std::sort(records.begin(), records.end(), [](const Record &a, const Record &b) {
+            return a.key != b.key ? a.key < b.key : a.score > b.score;
+        });
+        FILE *f = std::fopen(path, "wb");
+        if (!f) return 0;
+        for (const Record &r : records) {
+            uint8_t e[OpeningBook::EntrySize];
+            // keep proportions within a position; anything that scored stays above 0
+            uint32_t w = top > 0xffff ? (uint32_t)((uint64_t)r.score * 0xffff / top) : r.score;
+            if (r.score && !w) w = 1;
+            OpeningBook::writeEntry(e, r.key, r.move, (uint16_t)w);
+            std::fwrite(e, 1, sizeof(e), f);
+        }
+        std::fclose(f);
+        return records.size();
+    }
+};
+
+int parseResult(const std::string &s) {
+    if (s == "1-0") return 2;
+    if (s == "0-1") return 0;
+    if (s == "1/2-1/2") return 1;
+    return -1;
+}
+
+// movetext tokens: drops comments, variations, NAGs, move numbers and annotations
+void readPgn(std::istream &in, Builder &builder) {
+    std::vector<std::string> sans;
+    int result = -1, depth = 0;
+    bool inComment = false, inGame = false;
+    std::string line;
+    auto finish = [&]() {
+        if (inGame) builder.addGame(sans, result);
+        sans.clear();
+        result = -1;
+        inGame = false;
+    };
+    while (std::getline(in, line)) {
+        if (!inComment && !depth && !line.empty() && line[0] == '[') {
+            if (inGame && !sans.empty()) finish(); // a game without a result token
+            if (line.compare(0, 8, "[Result ") == 0) {
+                size_t q = line.find('"');
+                result = parseResult(line.substr(q + 1, line.find('"', q + 1) - q - 1));
+            }
+            inGame = true;
+            continue;
+        }
+        if (!line.empty() && line[0] == '%') continue; // escape line
+        std::string token;
+        auto flush = [&]() {
+            if (token.empty()) return;
+            std::string t;
+            t.swap(token);
+            if (t == "*" || parseResult(t) >= 0) {
+                if (parseResult(t) >= 0) result = parseResult(t);
+                finish();
+                return;
+            }
+            if (t[0] == '$') return;
+            size_t dot = t.find_last_of('.');
+            if (dot != std::string::npos) t = t.substr(dot + 1); // "12." or "12...e5"
+            while (!t.empty() && std::strchr("!?+#", t.back())) t.pop_back();
+            if (t.empty() || std::isdigit((unsigned char)t[0])) return;
+            if (!depth) sans.push_back(t);
+        };
+        for (size_t i=0; i<line.size(); ++i) {
+            char c = line[i];
+            if (inComment) { if (c == '}') inComment = false; continue; }
+            if (c == ';') break; // comment to end of line
+            if (c == '{') { flush(); inComment = true; continue; }
+            if (c == '(') { flush(); ++depth; continue; }
+            if (c == ')') { flush(); if (depth) --depth; continue; }
+            if (std::isspace((unsigned char)c)) { flush(); continue; }
+            token += c;
+            inGame = true;
+        }
+        flush();
+    }
+    finish();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    Builder builder;
+    const char *out = nullptr;
+    std::vector<const char *> inputs;
+    for (int i=1; i<argc; ++i) {
+        if (!std::strcmp(argv[i], "-plies") && i + 1 < argc) builder.maxPlies = std::atoi(argv[++i]);
+        else if (!std::strcmp(argv[i], "-min") && i + 1 < argc) builder.minGames = (uint32_t)std::atoi(argv[++i]);
+        else if (!out) out = argv[i];
+        else inputs.push_back(argv[i]);
+    }
+    if (!out || inputs.empty()) {
+        std::fprintf(stderr, "usage: book_builder <out.bin> <games.pgn>... [-plies N] [-min N]\n");
+        return 2;
+    }
+    for (const char *path : inputs) {
+        std::ifstream in(path);
+        if (!in) { std::perror(path); return 1; }
+        readPgn(in, builder);
+    }
+    size_t records = builder.write(out);
+    std::printf("%d games (%d stopped at an unreadable move), %zu positions/moves, %zu records to %s\n",
+                builder.games, builder.badMoves, builder.tallies.size(), records, out);
+
+    // read it back the way the engine will
+    OpeningBook book;
+    if (!book.open(out)) { std::fprintf(stderr, "cannot map %s\n", out); return 1; }
+    Game game;
+    BookMove moves[8];
+    int n = book.lookup(game.position(), moves, 8);
+    std::printf("start position:");
+    for (int i=0; i<n; ++i) std::printf(" %s (%u)", game.toSAN(moves[i].move).c_str(), (unsigned)moves[i].weight);
+    std::printf("%s\n", n ? "" : " not in book");
+    return records == book.size() ? 0 : 1;
+}
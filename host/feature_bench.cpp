@@ -0,0 +1,191 @@
+// Feature front end: checks every optimized kernel against its scalar
+// reference, compares the fixed-point log-mel output with a double-precision
+// computation, then times each kernel (reference and optimized) and a whole
+// 10 ms hop.
+//
+//   feature_bench [output.json] [min-seconds-per-benchmark]
+//
+// Exits 1 if an optimized kernel differs from the reference.
+#include "feature_extractor.h"
+#include "bench_util.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Audio;
+using namespace Audio::FeatureTables;
+
+namespace {
+
+volatile uint64_t sink; // keeps results observable so loops are not optimized away
+
+// one second of a few harmonics plus noise, then one of quiet noise
+std::vector<int16_t> testSignal() {
+    std::mt19937 rng(7);
+    std::normal_distribution<double> noise(0, 1);
+    std::vector<int16_t> pcm(2 * SampleRate);
+    for (int i=0; i<SampleRate; ++i) {
+        double t = (double)i / SampleRate, v = 0;
+        for (int h=1; h<=6; ++h) v += std::sin(2 * M_PI * 180 * h * t) / h;
+        pcm[i] = (int16_t)std::lrint(6000 * v + 300 * noise(rng));
+        pcm[SampleRate + i] = (int16_t)std::lrint(40 * noise(rng));
+    }
+    return pcm;
+}
+
+template<typename T>
+bool same(const T *a, const T *b, int n) { return std::memcmp(a, b, n * sizeof(T)) == 0; }
+
+int checkKernels(const std::vector<int16_t> &pcm) {
+    int failures = 0;
+    auto report = [&](const char *name, bool ok) {
+        std::printf("  %-14s %s\n", name, ok ? "ok" : "MISMATCH");
+        failures += !ok;
+    };
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> any(-32768, 32767), half(-16384, 16383);
+
+    int16_t a[FftSize], b[FftSize], c[FftSize], d[FftSize];
+    for (int i=0; i<WindowSamples; ++i) a[i] = (int16_t)any(rng);
+    Dsp::Ref::window(a, hamming, b, WindowSamples);
+    Dsp::window(a, hamming, c, WindowSamples);
+    report("window", same(b, c, WindowSamples));
+
+    a[123] = -32768;
+    report("peakAbs", Dsp::Ref::peakAbs(a, 397) == Dsp::peakAbs(a, 397) && Dsp::peakAbs(a, 397) == 32768);
+
+    for (int i=0; i<FftSize; ++i) a[i] = (int16_t)(half(rng) >> 3);
+    std::memcpy(b, a, sizeof(a));
+    Dsp::Ref::shiftLeft(a, 333, 3);
+    Dsp::shiftLeft(b, 333, 3);
+    report("shiftLeft", same(a, b, FftSize));
+
+    bool fftOk = true;
+    for (int round=0; round<2; ++round) {
+        // random points and a real windowed frame
+        if (round == 0) for (int i=0; i<FftSize; ++i) a[i] = (int16_t)(half(rng) / 2);
+        else { Dsp::Ref::window(pcm.data() + 1000, hamming, a, WindowSamples); std::memset(a + WindowSamples, 0, 224); }
+        std::memcpy(b, a, sizeof(a));
+        Dsp::Ref::fft(a, FftSize / 2, fftTwiddles);
+        Dsp::fft(b, FftSize / 2, fftTwiddles);
+        fftOk &= same(a, b, FftSize);
+    }
+    report("fft", fftOk);
+
+    int16_t bins[2 * SpectrumBins];
+    realSpectrum(a, bins);
+    int32_t p1[SpectrumBins], p2[SpectrumBins];
+    Dsp::Ref::power(bins, p1, SpectrumBins);
+    Dsp::power(bins, p2, SpectrumBins);
+    report("power", same(p1, p2, SpectrumBins));
+
+    for (int i=0; i<SpectrumBins; ++i) p1[i] = (int32_t)(rng() >> 2); // full 30-bit range
+    uint64_t m1[MelBands], m2[MelBands];
+    Dsp::Ref::melEnergies(p1, melFilters, melWeights, m1, MelBands);
+    Dsp::melEnergies(p1, melFilters, melWeights, m2, MelBands);
+    report("melEnergies", same(m1, m2, MelBands));
+
+    alignas(32) int16_t x[DctStride] = {};
+    for (int i=0; i<MelBands; ++i) x[i] = (int16_t)(rng() % 3840);
+    Dsp::Ref::matVec(&dct[0][0], x, c, CepstralCoeffs, DctStride);
+    Dsp::matVec(&dct[0][0], x, d, CepstralCoeffs, DctStride);
+    report("matVec", same(c, d, CepstralCoeffs));
+    return failures;
+}
+
+// log-mel of one window in double precision, same units as Features::logMel
+void referenceLogMel(const int16_t *window, double *out) {
+    std::vector<double> re(FftSize, 0.0), im(FftSize, 0.0);
+    for (int i=0; i<WindowSamples; ++i) re[i] = window[i] * (0.54 - 0.46 * std::cos(2 * M_PI * i / (WindowSamples - 1)));
+    std::vector<double> power(SpectrumBins);
+    for (int k=0; k<SpectrumBins; ++k) {
+        double sr = 0, si = 0;
+        for (int n=0; n<WindowSamples; ++n) { sr += re[n] * std::cos(2 * M_PI * k * n / FftSize); si -= re[n] * std::sin(2 * M_PI * k * n / FftSize); }
+        power[k] = sr * sr + si * si;
+    }
+    for (int f=0; f<MelBands; ++f) {
+        double e = 0;
+        for (int i=0; i<melFilters[f].bins; ++i) e += power[melFilters[f].firstBin + i] * melWeights[melFilters[f].weightOffset + i] / 32768.0;
+        out[f] = e > 1 ? std::log2(e) * LogScale : 0;
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const char *outPath = argc > 1 ? argv[1] : "feature_bench.json";
+    double minSeconds = argc > 2 ? std::atof(argv[2]) : 0.3;
+    FeatureTables::init();
+    std::vector<int16_t> pcm = testSignal();
+
+    std::printf("kernels (%s) against the scalar reference:\n", Dsp::backend());
+    int failures = checkKernels(pcm);
+
+    // fixed point against double precision, on the same pre-emphasized windows
+    FeatureExtractor fx;
+    Features feat;
+    double sumErr = 0, maxErr = 0;
+    int count = 0;
+    std::vector<int16_t> emphasized(pcm.size());
+    for (size_t i=0; i<pcm.size(); ++i) {
+        int32_t v = pcm[i] - (i ? (31785 * pcm[i-1] + (1 << 14)) >> 15 : 0);
+        emphasized[i] = (int16_t)std::max(-32768, std::min(32767, v));
+    }
+    for (size_t start=0; start+WindowSamples<=pcm.size(); start+=7*FrameSamples) {
+        FeatureExtractor::compute(emphasized.data() + start, feat);
+        double ref[MelBands];
+        referenceLogMel(emphasized.data() + start, ref);
+        for (int f=0; f<MelBands; ++f) {
+            if (ref[f] < 4 * LogScale) continue; // bands with almost no energy
+            double err = std::fabs(feat.logMel[f] - ref[f]) * 3.0103 / LogScale; // dB
+            sumErr += err; maxErr = std::max(maxErr, err); ++count;
+        }
+    }
+    std::printf("log-mel vs double precision: mean %.3f dB, max %.3f dB over %d band values\n\n", sumErr / count, maxErr, count);
+
+    alignas(32) int16_t frame[FftSize], scratch[FftSize];
+    Dsp::Ref::window(emphasized.data() + 2000, hamming, frame, WindowSamples);
+    std::memset(frame + WindowSamples, 0, (FftSize - WindowSamples) * sizeof(int16_t));
+    alignas(32) int16_t bins[2 * SpectrumBins];
+    alignas(32) int32_t power[SpectrumBins];
+    uint64_t mel[MelBands];
+    alignas(32) int16_t logMel[DctStride] = {}, mfcc[CepstralCoeffs];
+    for (int i=0; i<MelBands; ++i) logMel[i] = (int16_t)(1000 + 40 * i);
+
+    std::vector<BenchResult> results;
+    auto both = [&](const char *name, auto refBody, auto optBody) {
+        results.push_back(measure(std::string(name) + "_ref", minSeconds, [&]() { refBody(); return (uint64_t)1; }));
+        results.push_back(measure(name, minSeconds, [&]() { optBody(); return (uint64_t)1; }));
+    };
+    both("window", [&]() { Dsp::Ref::window(emphasized.data(), hamming, scratch, WindowSamples); sink = scratch[7]; },
+                   [&]() { Dsp::window(emphasized.data(), hamming, scratch, WindowSamples); sink = scratch[7]; });
+    both("peak_abs", [&]() { sink = Dsp::Ref::peakAbs(frame, WindowSamples); },
+                     [&]() { sink = Dsp::peakAbs(frame, WindowSamples); });
+    both("fft256", [&]() { std::memcpy(scratch, frame, sizeof(frame)); Dsp::Ref::fft(scratch, FftSize / 2, fftTwiddles); sink = scratch[3]; },
+                   [&]() { std::memcpy(scratch, frame, sizeof(frame)); Dsp::fft(scratch, FftSize / 2, fftTwiddles); sink = scratch[3]; });
+    results.push_back(measure("real_split", minSeconds, [&]() { realSpectrum(frame, bins); sink = bins[9]; return (uint64_t)1; }));
+    both("power", [&]() { Dsp::Ref::power(bins, power, SpectrumBins); sink = power[5]; },
+                  [&]() { Dsp::power(bins, power, SpectrumBins); sink = power[5]; });
+    both("mel", [&]() { Dsp::Ref::melEnergies(power, melFilters, melWeights, mel, MelBands); sink = mel[3]; },
+                [&]() { Dsp::melEnergies(power, melFilters, melWeights, mel, MelBands); sink = mel[3]; });
+    both("dct", [&]() { Dsp::Ref::matVec(&dct[0][0], logMel, mfcc, CepstralCoeffs, DctStride); sink = mfcc[2]; },
+                [&]() { Dsp::matVec(&dct[0][0], logMel, mfcc, CepstralCoeffs, DctStride); sink = mfcc[2]; });
+    size_t pos = 0;
+    Frame f;
+    results.push_back(measure("extract_hop", minSeconds, [&]() {
+        // one 10 ms frame in, features out: the real-time budget is 10 ms
+        std::memcpy(f.samples, pcm.data() + pos, sizeof(f.samples));
+        pos = (pos + FrameSamples) % (pcm.size() - FrameSamples);
+        sink = fx.push(f, feat) ? feat.mfcc[1] : 0;
+        return (uint64_t)1;
+    }));
+
+    printResults(results);
+    const BenchResult &hop = results.back();
+    std::printf("one hop costs %.4f%% of its 10 ms budget on this machine\n", hop.nsPerOp() / 1e5);
+    if (!writeJson(outPath, results)) return 1;
+    return failures ? 1 : 0;
+}
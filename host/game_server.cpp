@@ -0,0 +1,402 @@
+// Headless game service: many games at once behind a line protocol, for kiosk
+// boards streaming to a backend, bot matches and replay validation.
+//
+//   game_server [-socket path] [-games N] [-threads N]
+//
+// Requests come one per line on stdin (replies on stdout) or from any number
+// of connections to a Unix socket. Replies start with the request's word:
+//
+//   new <tag>            new <tag> <id>            a game from the initial position
+//   move <id> <move>     move <id> <uci> [checkmate|stalemate|draw]
+//                                                  SAN, UCI or a spoken phrase
+//   legal <id>           legal <id> <uci>...
+//   fen <id>             fen <id> <fen>
+//   snapshot <id>        snapshot <id> <hex>       Game::saveSnapshot
+//   load <id> <hex>      load <id>                 Game::loadSnapshot
+//   end <id>             end <id>                  frees the game
+//   stats                stats key=value...        throughput and latency so far
+//   shutdown                                       socket mode: finish and exit
+//
+// and failures as "err <id or tag> <reason>". Replies for one game come in
+// request order; replies for different games interleave.
+//
+// Games live in an arena allocated once at start (-games slots), each reused
+// by the next new game after an end, so serving a game allocates nothing per
+// move beyond the reply. Each slot has an inbox and is a task on a
+// work-stealing pool while the inbox is not empty, so one game's requests run
+// one at a time in order while different games run in parallel. Latency is
+// measured from reading the request to writing its reply.
+#include "game.h"
+#include "line_io.h"
+#include "trace.h"
+#include "work_pool.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_set>
+#include <vector>
+
+using namespace Chess;
+
+namespace {
+
+constexpr int IndexBits = 16; // an id is generation << IndexBits | slot
+constexpr uint32_t MaxGames = 1u << IndexBits;
+constexpr int Batch = 8; // requests run per turn before the slot yields its worker
+
+// Where a client's replies go. A socket is closed when the last reference
+// goes, which may be a request still queued after the client hung up.
+struct Connection {
+    int out;
+    bool owned;
+    std::mutex lock;
+    explicit Connection(int fd, bool owns = false) : out(fd), owned(owns) {}
+    ~Connection() { if (owned) close(out); }
+    Connection(const Connection&) = delete;
+    Connection &operator=(const Connection&) = delete;
+    void reply(std::string line) {
+        line += '\n';
+        std::lock_guard<std::mutex> l(lock);
+        writeAll(out, line.data(), line.size());
+    }
+};
+
+enum class Op : uint8_t { New, Move, Legal, Fen, Snapshot, Load, End };
+
+struct Request {
+    std::shared_ptr<Connection> conn;
+    Op op;
+    uint32_t id;
+    uint32_t startUs;
+    std::string arg; // the tag for New, the move for Move, hex for Load
+};
+
+struct Slot {
+    Game game;
+    uint32_t generation = 0; // strand only: the id's upper bits while live
+    bool live = false;       // strand only
+    std::mutex lock;         // inbox and scheduled
+    std::deque<Request> inbox;
+    bool scheduled = false;  // on the pool, or running
+};
+
+// written by one worker, read by stats
+struct alignas(64) WorkerStats {
+    std::mutex lock;
+    Trace::Histogram latency;
+    uint64_t requests = 0, moves = 0;
+};
+
+std::string toHex(const std::vector<uint8_t> &bytes) {
+    static const char digits[] = "0123456789abcdef";
+    std::string s;
+    s.reserve(bytes.size() * 2);
+    for (uint8_t b : bytes) { s += digits[b >> 4]; s += digits[b & 15]; }
+    return s;
+}
+
+bool fromHex(const std::string &s, std::vector<uint8_t> &out) {
+    if (s.size() % 2) return false;
+    out.clear();
+    for (size_t i=0; i<s.size(); i+=2) {
+        int v = 0;
+        for (int k=0; k<2; ++k) {
+            char c = s[i + k];
+            int d = c >= '0' && c <= '9' ? c - '0' : c >= 'a' && c <= 'f' ? c - 'a' + 10 : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+            if (d < 0) return false;
+            v = v << 4 | d;
+        }
+        out.push_back((uint8_t)v);
+    }
+    return true;
+}
+
+class Server {
+public:
+    Server(uint32_t capacity, int threads)
+        : capacity(capacity), slots(new Slot[capacity]), generations(capacity, 0), workers(threads),
+          pool(threads, [this](uint32_t slot, int worker) { runSlot(slot, worker); }) {
+        freeList.reserve(capacity);
+        for (uint32_t i=capacity; i-- > 0; ) freeList.push_back(i);
+    }
+
+    // reader threads: parse one request line and queue it on its game
+    void handle(const std::string &line, const std::shared_ptr<Connection> &conn) {
+        uint32_t start = Trace::nowUs();
+        char word[16] = {}, idText[24] = {};
+        int used = 0;
+        if (std::sscanf(line.c_str(), "%15s %23s %n", word, idText, &used) < 1) return;
+        std::string rest = used ? line.substr(used) : "";
+        if (!firstUs.load(std::memory_order_relaxed)) firstUs.store(start | 1, std::memory_order_relaxed);
+
+        if (!std::strcmp(word, "stats")) { conn->reply(statsLine()); return; }
+        if (!std::strcmp(word, "new")) {
+            uint32_t index;
+            {
+                std::lock_guard<std::mutex> l(arenaLock);
+                if (freeList.empty()) { conn->reply(std::string("err ") + idText + " full"); return; }
+                index = freeList.back();
+                freeList.pop_back();
+                generations[index] = (generations[index] + 1) & ((1u << (32 - IndexBits)) - 1);
+                uint32_t id = generations[index] << IndexBits | index;
+                enqueue(index, {conn, Op::New, id, start, idText});
+            }
+            return;
+        }
+        static const struct { const char *word; Op op; } ops[] = {
+            {"move", Op::Move}, {"legal", Op::Legal}, {"fen", Op::Fen}, {"snapshot", Op::Snapshot},
+            {"load", Op::Load}, {"end", Op::End},
+        };
+        for (const auto &o : ops) {
+            if (std::strcmp(word, o.word)) continue;
+            char *endp;
+            unsigned long id = std::strtoul(idText, &endp, 10);
+            uint32_t index = (uint32_t)id & (MaxGames - 1);
+            if (!*idText || *endp || index >= capacity) { conn->reply(std::string("err ") + idText + " unknown game"); return; }
+            enqueue(index, {conn, o.op, (uint32_t)id, start, rest});
+            return;
+        }
+        conn->reply(std::string("err - unknown request ") + word);
+    }
+
+    // wait until every queued request has run
+    void drain() {
+        while (inFlight.load(std::memory_order_acquire)) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    std::string statsLine() {
+        Trace::Histogram latency;
+        uint64_t requests = 0, moves = 0;
+        for (WorkerStats &w : workers) {
+            std::lock_guard<std::mutex> l(w.lock);
+            latency.merge(w.latency);
+            requests += w.requests;
+            moves += w.moves;
+        }
+        uint32_t first = firstUs.load(std::memory_order_relaxed);
+        double secs = first ? (uint32_t)(Trace::nowUs() - first) / 1e6 : 0;
+        char buf[320];
+        std::snprintf(buf, sizeof(buf),
+                      "stats requests=%llu moves=%llu seconds=%.3f requests_per_sec=%.0f moves_per_sec=%.0f "
+                      "p50_us=%u p99_us=%u p999_us=%u max_us=%u games=%u threads=%d steals=%llu",
+                      (unsigned long long)requests, (unsigned long long)moves, secs, secs > 0 ? requests / secs : 0.0,
+                      secs > 0 ? moves / secs : 0.0, (unsigned)latency.percentile(0.50), (unsigned)latency.percentile(0.99),
+                      (unsigned)latency.percentile(0.999), (unsigned)latency.max(),
+                      (unsigned)liveGames.load(std::memory_order_relaxed), pool.threads(), (unsigned long long)pool.steals());
+        return buf;
+    }
+
+private:
+    void enqueue(uint32_t index, Request &&r) {
+        inFlight.fetch_add(1, std::memory_order_relaxed);
+        Slot &s = slots[index];
+        bool schedule;
+        {
+            std::lock_guard<std::mutex> l(s.lock);
+            s.inbox.push_back(std::move(r));
+            schedule = !s.scheduled;
+            s.scheduled = true;
+        }
+        if (schedule) pool.submit(index);
+    }
+
+    // a slot's turn on a worker: its requests in order, a batch at a time
+    void runSlot(uint32_t index, int worker) {
+        Slot &s = slots[index];
+        for (int n=0; ; ++n) {
+            Request r;
+            {
+                std::lock_guard<std::mutex> l(s.lock);
+                if (s.inbox.empty()) { s.scheduled = false; return; }
+                if (n == Batch) break;
+                r = std::move(s.inbox.front());
+                s.inbox.pop_front();
+            }
+            bool moved = execute(s, index, r);
+            WorkerStats &w = workers[worker];
+            {
+                std::lock_guard<std::mutex> l(w.lock);
+                w.latency.add(Trace::nowUs() - r.startUs);
+                ++w.requests;
+                w.moves += moved;
+            }
+            inFlight.fetch_sub(1, std::memory_order_release);
+        }
+        pool.submit(index); // still scheduled; let other games have the worker
+    }
+
+    // runs r on its game and replies; true if a move was played
+    bool execute(Slot &s, uint32_t index, Request &r) {
+        std::string id = std::to_string(r.id);
+        if (r.op == Op::New) {
+            s.game.newGame();
+            s.generation = r.id >> IndexBits;
+            s.live = true;
+            liveGames.fetch_add(1, std::memory_order_relaxed);
+            r.conn->reply("new " + r.arg + " " + id);
+            return false;
+        }
+        if (!s.live || s.generation != r.id >> IndexBits) {
+            r.conn->reply("err " + id + " unknown game");
+            return false;
+        }
+        Game &g = s.game;
+        switch (r.op) {
+        case Op::Move: {
+            Resolution res = g.resolveMove(r.arg);
+            if (res.status != Resolution::Status::Ok || !g.playMove(res.move)) {
+                r.conn->reply("err " + id + (res.status == Resolution::Status::Ambiguous ? " ambiguous " : " illegal ") + r.arg);
+                return false;
+            }
+            std::string out = "move " + id + " " + moveToUCI(res.move);
+            const Board &b = g.position();
+            if (g.legalMoves().empty()) {
+                Color them = b.sideToMove == Color::White ? Color::Black : Color::White;
+                out += b.isSquareAttacked(b.findKing(b.sideToMove), them) ? " checkmate" : " stalemate";
+            } else if (b.isFiftyMoveDraw() || b.isThreefoldRepetition()) {
+                out += " draw";
+            }
+            r.conn->reply(out);
+            return true;
+        }
+        case Op::Legal: {
+            std::string out = "legal " + id;
+            out.reserve(out.size() + 6 * g.legalMoves().size());
+            for (const Move &m : g.legalMoves()) { out += ' '; out += moveToUCI(m); }
+            r.conn->reply(out);
+            return false;
+        }
+        case Op::Fen: r.conn->reply("fen " + id + " " + g.toFEN()); return false;
+        case Op::Snapshot: r.conn->reply("snapshot " + id + " " + toHex(g.saveSnapshot())); return false;
+        case Op::Load: {
+            std::vector<uint8_t> bytes;
+            bool ok = fromHex(r.arg, bytes) && g.loadSnapshot(bytes.data(), bytes.size());
+            r.conn->reply(ok ? "load " + id : "err " + id + " bad snapshot");
+            return false;
+        }
+        case Op::End: {
+            s.live = false;
+            liveGames.fetch_sub(1, std::memory_order_relaxed);
+            r.conn->reply("end " + id);
+            std::lock_guard<std::mutex> l(arenaLock);
+            freeList.push_back(index);
+            return false;
+        }
+        case Op::New: break;
+        }
+        return false;
+    }
+
+    uint32_t capacity;
+    std::unique_ptr<Slot[]> slots;
+    std::mutex arenaLock; // freeList and generations
+    std::vector<uint32_t> freeList;
+    std::vector<uint32_t> generations;
+    std::vector<WorkerStats> workers;
+    std::atomic<int64_t> inFlight{0};
+    std::atomic<uint32_t> liveGames{0};
+    std::atomic<uint32_t> firstUs{0};
+    WorkPool pool; // last, so its workers stop before the slots go
+};
+
+void serveStdin(Server &server) {
+    auto conn = std::make_shared<Connection>(STDOUT_FILENO);
+    LineReader in(STDIN_FILENO);
+    for (std::string line; in.next(line); ) server.handle(line, conn);
+}
+
+int serveSocket(Server &server, const char *path) {
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    unlink(path);
+    if (listener < 0 || bind(listener, (sockaddr *)&addr, sizeof(addr)) != 0 || listen(listener, 64) != 0) {
+        std::perror(path);
+        return 1;
+    }
+    std::fprintf(stderr, "listening on %s\n", path);
+    // readers are detached; live holds the sockets of the ones still running
+    // so a shutdown can stop them, and serveSocket waits for it to empty
+    std::mutex connLock;
+    std::condition_variable readersDone;
+    std::unordered_set<int> live;
+    bool stopping = false;
+    for (;;) {
+        int fd = accept(listener, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break; // shut down by a shutdown request
+        }
+        std::lock_guard<std::mutex> l(connLock);
+        if (stopping) { close(fd); break; }
+        live.insert(fd);
+        std::thread([&, fd]() {
+            auto conn = std::make_shared<Connection>(fd, true);
+            LineReader in(fd);
+            for (std::string line; in.next(line); ) {
+                if (line == "shutdown") {
+                    std::lock_guard<std::mutex> l(connLock);
+                    stopping = true;
+                    shutdown(listener, SHUT_RDWR);
+                    for (int other : live) shutdown(other, SHUT_RD);
+                    break;
+                }
+                server.handle(line, conn);
+            }
+            // out of live before the fd can close and its number be reused
+            std::lock_guard<std::mutex> l(connLock);
+            live.erase(fd);
+            conn.reset();
+            readersDone.notify_all();
+        }).detach();
+    }
+    {
+        std::unique_lock<std::mutex> l(connLock);
+        stopping = true;
+        readersDone.wait(l, [&] { return live.empty(); });
+    }
+    server.drain();
+    close(listener);
+    unlink(path);
+    return 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const char *socketPath = nullptr;
+    uint32_t games = 4096;
+    int threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    for (int i=1; i+1<argc; i+=2) {
+        if (!std::strcmp(argv[i], "-socket")) socketPath = argv[i + 1];
+        else if (!std::strcmp(argv[i], "-games")) games = (uint32_t)std::atoi(argv[i + 1]);
+        else if (!std::strcmp(argv[i], "-threads")) threads = std::max(1, std::atoi(argv[i + 1]));
+    }
+    games = std::min(std::max(games, 1u), MaxGames);
+    std::signal(SIGPIPE, SIG_IGN); // a client that goes away only fails its replies
+
+    Server server(games, threads);
+    int rc = 0;
+    if (socketPath) {
+        rc = serveSocket(server, socketPath);
+    } else {
+        serveStdin(server);
+        server.drain();
+    }
+    std::fprintf(stderr, "%s\n", server.statsLine().c_str());
+    return rc;
+}
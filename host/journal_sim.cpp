@@ -0,0 +1,172 @@
+// Plays random games into the move journal while cutting the power at random
+// writes, and checks that every reboot recovers the game.
+//
+//   journal_sim [moves] [cut-every] [journal-file]
+//
+// A cut writes a random prefix of the record or header in flight, then the
+// journal is dropped and a new one recovers from the same file, as after a
+// reset. The recovered position must be the one before or after the move
+// being written. A mock DB takes sync batches every few moves and must end up
+// with the same game. Flash traffic is compared with rewriting the game state
+// on every move: the JSON string the README planned, and Game::saveSnapshot.
+#include "game.h"
+#include "journal.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Chess;
+
+namespace {
+
+constexpr uint32_t JournalBytes = 4 * JournalStorage::SectorSize;
+constexpr int MaxGamePlies = 160;
+constexpr int SyncEvery = 8;
+
+// file storage that fails one write part-way through on request, and every
+// write and erase after it until the reboot, as the power is off by then
+class CuttingStorage : public JournalStorage {
+public:
+    CuttingStorage(const std::string &path, std::mt19937 &rng) : file(path, JournalBytes), rng(rng) {}
+    bool ok() const { return file.ok(); }
+    uint32_t size() const override { return file.size(); }
+    bool read(uint32_t offset, void *dst, size_t len) override { return file.read(offset, dst, len); }
+    bool write(uint32_t offset, const void *src, size_t len) override {
+        if (cut) return false;
+        if (armed) {
+            armed = false;
+            cut = true;
+            size_t part = std::uniform_int_distribution<size_t>(0, len - 1)(rng);
+            if (part) file.write(offset, src, part);
+            return false;
+        }
+        return file.write(offset, src, len);
+    }
+    bool eraseSector(uint32_t offset) override { return !cut && file.eraseSector(offset); }
+
+    FileJournalStorage file;
+    bool armed = false, cut = false;
+
+private:
+    std::mt19937 &rng;
+};
+
+// the DB side: a start position and the moves after it, deduplicated by ply
+struct MockDb {
+    uint8_t start[Board::MaxPackedSize];
+    size_t startSize = 0;
+    uint32_t firstPly = 0;
+    std::vector<Move> moves;
+    uint32_t batches = 0, bytes = 0, gaps = 0;
+
+    void apply(const SyncBatch &b) {
+        ++batches;
+        bytes += 4 + (b.restart ? b.startSize : 0) + 2 * b.count;
+        if (b.restart) {
+            std::memcpy(start, b.start, b.startSize);
+            startSize = b.startSize;
+            firstPly = b.firstPly;
+            moves.clear();
+        }
+        for (int i=0; i<b.count; ++i) {
+            uint32_t ply = b.firstPly + i, next = firstPly + (uint32_t)moves.size();
+            if (ply < next) continue; // sent again after a power cut
+            if (ply > next) { ++gaps; return; }
+            moves.push_back(b.moves[i]);
+        }
+    }
+    bool matches(const Board &b) const {
+        Board db;
+        if (!startSize || !db.unpack(start, startSize)) return false;
+        for (Move m : moves) db.makeMove(m);
+        return db.toFEN() == b.toFEN();
+    }
+};
+
+bool samePosition(const Board &a, const Board &b) { return a.toFEN() == b.toFEN(); }
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int totalMoves = argc > 1 ? std::atoi(argv[1]) : 20000;
+    int cutEvery = argc > 2 ? std::atoi(argv[2]) : 50;
+    std::string path = argc > 3 ? argv[3] : "journal_sim.bin";
+    std::remove(path.c_str());
+
+    std::mt19937 rng(19);
+    CuttingStorage storage(path, rng);
+    if (!storage.ok()) { std::perror(path.c_str()); return 1; }
+    std::unique_ptr<Journal> journal(new Journal(storage));
+    Game game;
+    Board recovered;
+    journal->recover(recovered);
+    MockDb db;
+
+    int games = 1, played = 0, gamePlies = 0, cuts = 0, lostMoves = 0, badRecoveries = 0;
+    size_t jsonBytes = 0, snapshotBytes = 0;
+    std::string uciMoves;
+    auto sync = [&]() {
+        SyncBatch batch;
+        while (!storage.cut && journal->nextBatch(batch)) {
+            db.apply(batch);
+            journal->markSynced(batch);
+        }
+    };
+    // drop the journal and recover, as after a reset; before and after bound what is acceptable
+    auto reboot = [&](const Board &before, const Board &after) {
+        ++cuts;
+        storage.cut = false;
+        journal.reset(new Journal(storage));
+        if (!journal->recover(recovered) || (!samePosition(recovered, before) && !samePosition(recovered, after))) {
+            ++badRecoveries;
+            std::printf("  cut %d: recovered %s\n", cuts, recovered.toFEN().c_str());
+        }
+        if (!samePosition(recovered, after)) ++lostMoves;
+        game.loadFEN(recovered.toFEN());
+    };
+
+    while (played < totalMoves) {
+        const MoveList &legal = game.legalMoves();
+        if (legal.empty() || gamePlies >= MaxGamePlies || game.position().isFiftyMoveDraw()) {
+            game.newGame();
+            uciMoves.clear();
+            gamePlies = 0;
+            ++games;
+            Board before = game.position();
+            journal->newGame(game.position());
+            if (storage.cut) reboot(before, before);
+            continue;
+        }
+        Move m = legal[std::uniform_int_distribution<int>(0, legal.size() - 1)(rng)];
+        Board before = game.position();
+        game.playMove(m);
+        ++played;
+        ++gamePlies;
+        // what a whole-state rewrite would store after this move
+        uciMoves += (uciMoves.empty() ? "" : " ") + moveToUCI(m);
+        jsonBytes += std::string("{\"fen\":\"" + game.toFEN() + "\",\"moves\":\"" + uciMoves + "\"}").size();
+        snapshotBytes += game.saveSnapshot().size();
+
+        if (cutEvery > 0 && std::uniform_int_distribution<int>(0, cutEvery - 1)(rng) == 0) storage.armed = true;
+        journal->append(m, game.position());
+        if (!storage.cut && played % SyncEvery == 0) sync();
+        storage.armed = false;
+        if (storage.cut) reboot(before, game.position());
+    }
+    sync();
+
+    uint32_t flash = storage.file.bytesWritten();
+    std::printf("%d moves in %d games, %d power cuts: %d recovered to the wrong position, %d in-flight moves lost\n",
+                played, games, cuts, badRecoveries, lostMoves);
+    std::printf("journal: %.2f bytes/move written, %u sector erases (%.2f per 1000 moves)\n", (double)flash / played,
+                (unsigned)storage.file.sectorsErased(), 1000.0 * storage.file.sectorsErased() / played);
+    std::printf("rewrite per move: JSON state %.0f bytes/move, Game::saveSnapshot %.0f bytes/move, one sector erase each\n",
+                (double)jsonBytes / played, (double)snapshotBytes / played);
+    std::printf("db: %u batches, %.2f bytes/move sent, %s\n", (unsigned)db.batches, (double)db.bytes / played,
+                db.gaps ? "GAPS" : db.matches(game.position()) ? "matches the game" : "DIFFERS from the game");
+    return badRecoveries || db.gaps || !db.matches(game.position()) ? 1 : 0;
+}
@@ -0,0 +1,177 @@
+// Grammar-constrained keyword decoding: accuracy and cost per frame.
+//
+//   kws_bench [utterances-per-noise-level]
+//
+// Positions come from random games. For each, a random legal move is spoken
+// as one of its unambiguous phrases and turned into synthetic acoustic scores:
+// every word state lasts a few frames, the true state scores well, one random
+// competing word scores nearly as well, everything else scores poorly, and
+// Gaussian noise of increasing strength is added. The same frames go through
+// the grammar decoder and through an unconstrained word loop whose transcript
+// is then resolved against the legal moves, as a general recognizer would be.
+#include "game.h"
+#include "kws_decoder.h"
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Audio;
+using Chess::SpokenWord;
+using Chess::SpokenWordCount;
+
+namespace {
+
+constexpr int NBest = 5;
+constexpr int SilenceFrames = 15;
+
+struct Utterance {
+    std::vector<SpokenWord> words;
+    std::vector<int16_t> scores; // frames * ScoreCount
+    int frames() const { return (int)(scores.size() / ScoreCount); }
+};
+
+int16_t q8(double v) { return (int16_t)std::max(-32768.0, std::min(32767.0, v * 256)); }
+
+Utterance synthesize(const std::vector<SpokenWord> &words, double noise, std::mt19937 &rng) {
+    Utterance u;
+    u.words = words;
+    std::normal_distribution<double> n01(0, 1);
+    std::uniform_int_distribution<int> stateFrames(3, 9), anyWord(0, SpokenWordCount - 1);
+    auto frame = [&](int trueIndex, int rivalIndex) {
+        for (int i=0; i<ScoreCount; ++i) {
+            double v = i == trueIndex ? -1.0 : i == rivalIndex ? -2.0 : -5.0;
+            u.scores.push_back(q8(v + noise * n01(rng)));
+        }
+    };
+    for (int f=0; f<SilenceFrames; ++f) frame(SilenceScore, -1);
+    for (SpokenWord w : words) {
+        int rival = anyWord(rng);
+        if (rival == (int)w) rival = (rival + 1) % SpokenWordCount;
+        for (int s=0; s<StatesPerWord; ++s) {
+            int len = stateFrames(rng);
+            for (int f=0; f<len; ++f) frame(scoreIndex(w, s), scoreIndex((SpokenWord)rival, s));
+        }
+    }
+    for (int f=0; f<SilenceFrames; ++f) frame(SilenceScore, -1);
+    return u;
+}
+
+// Unconstrained Viterbi over a loop of all words, with a back-trace of the
+// word sequence; what a recognizer without the grammar would transcribe.
+std::vector<SpokenWord> freeLoop(const Utterance &u, int wordPenalty) {
+    constexpr int32_t Dead = INT32_MIN / 4;
+    struct Hist { SpokenWord word; int prev; };
+    std::vector<Hist> hist;
+    struct Tok { int32_t score = Dead; int hist = -1; };
+    std::vector<Tok> state(SpokenWordCount * StatesPerWord);
+    Tok lead{0, -1}, trail;
+    for (int f=0; f<u.frames(); ++f) {
+        const int16_t *s = &u.scores[f * ScoreCount];
+        Tok exit; // best word end of the previous frame
+        for (int w=0; w<SpokenWordCount; ++w)
+            if (state[w*StatesPerWord + StatesPerWord-1].score > exit.score) exit = state[w*StatesPerWord + StatesPerWord-1];
+        Tok enter = lead.score > exit.score ? lead : exit;
+        for (int w=0; w<SpokenWordCount; ++w) {
+            Tok *t = &state[w*StatesPerWord];
+            for (int k=StatesPerWord-1; k>0; --k) {
+                if (t[k-1].score > t[k].score) t[k] = t[k-1];
+                t[k].score += s[w*StatesPerWord + k];
+            }
+            if (enter.score - wordPenalty > t[0].score) {
+                hist.push_back({(SpokenWord)w, enter.hist});
+                t[0] = {enter.score - wordPenalty, (int)hist.size() - 1};
+            }
+            t[0].score += s[w*StatesPerWord];
+        }
+        if (exit.score > trail.score) trail = exit;
+        trail.score += s[SilenceScore];
+        lead.score += s[SilenceScore];
+    }
+    Tok end = trail;
+    for (int w=0; w<SpokenWordCount; ++w)
+        if (state[w*StatesPerWord + StatesPerWord-1].score > end.score) end = state[w*StatesPerWord + StatesPerWord-1];
+    std::vector<SpokenWord> words;
+    for (int h=end.hist; h>=0; h=hist[h].prev) words.insert(words.begin(), hist[h].word);
+    return words;
+}
+
+std::string text(const std::vector<SpokenWord> &words) {
+    std::string s;
+    for (SpokenWord w : words) { if (!s.empty()) s.push_back(' '); s += Chess::spokenWordText(w); }
+    return s;
+}
+
+struct Tally {
+    int utterances = 0, top1 = 0, inNBest = 0;
+    int freeCorrect = 0, freeWrongMove = 0, freeNoMove = 0;
+    int frames = 0;
+    uint64_t updates = 0;
+    double seconds = 0;
+    long nodes = 0;
+};
+
+} // namespace
+
+int main(int argc, char **argv) {
+    const int perLevel = argc > 1 ? std::atoi(argv[1]) : 300;
+    const double noiseLevels[] = {1.0, 2.0, 2.5, 3.0, 3.5};
+    std::mt19937 rng(2024);
+
+    std::printf("%-6s %6s %7s %8s %7s   %-24s %7s %9s %11s\n", "noise", "utts", "top1", "in-5best", "nodes",
+                "free loop: ok/wrong/none", "frames", "us/frame", "states/frm");
+    KwsDecoder decoder;
+    KwsHypothesis nbest[NBest];
+    for (double noise : noiseLevels) {
+        Tally t;
+        Chess::Game game;
+        int ply = 0;
+        while (t.utterances < perLevel) {
+            const Chess::MoveList &legal = game.legalMoves();
+            if (legal.empty() || ply > 120) { game.newGame(); ply = 0; continue; }
+            const Chess::MoveGrammar &g = game.grammar();
+
+            // a phrase that names exactly one move, chosen at random
+            std::vector<int> unique;
+            for (int i=1; i<g.size(); ++i) if (g.node(i).moveCount == 1) unique.push_back(i);
+            int end = unique[std::uniform_int_distribution<int>(0, (int)unique.size() - 1)(rng)];
+            Chess::Move truth = g.moves(end)[0];
+            SpokenWord words[8];
+            int n = g.phrase(end, words, 8);
+            Utterance u = synthesize(std::vector<SpokenWord>(words, words + n), noise, rng);
+
+            auto start = std::chrono::steady_clock::now();
+            decoder.begin(g);
+            for (int f=0; f<u.frames(); ++f) decoder.push(&u.scores[f * ScoreCount]);
+            int found = decoder.finish(nbest, NBest);
+            t.seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            t.frames += u.frames();
+            t.updates += decoder.stateUpdates();
+            t.nodes += g.size();
+            ++t.utterances;
+            if (found && nbest[0].move == truth) ++t.top1;
+            for (int i=0; i<found; ++i) if (nbest[i].move == truth) { ++t.inNBest; break; }
+
+            Chess::Resolution r = game.resolveMove(text(freeLoop(u, KwsConfig().wordPenalty)));
+            if (r.status == Chess::Resolution::Status::Ok && r.move == truth) ++t.freeCorrect;
+            else if (r.status == Chess::Resolution::Status::Ok) ++t.freeWrongMove;
+            else ++t.freeNoMove;
+
+            // move the game on so positions vary
+            game.playMove(legal[std::uniform_int_distribution<int>(0, legal.size() - 1)(rng)]);
+            ++ply;
+        }
+        char freeCol[48];
+        std::snprintf(freeCol, sizeof(freeCol), "%d/%d/%d", t.freeCorrect, t.freeWrongMove, t.freeNoMove);
+        std::printf("%-6.1f %6d %6.1f%% %7.1f%% %7ld   %-24s %7d %9.2f %11.0f\n", noise, t.utterances,
+                    100.0 * t.top1 / t.utterances, 100.0 * t.inNBest / t.utterances, t.nodes / t.utterances,
+                    freeCol, t.frames, t.seconds * 1e6 / t.frames, (double)t.updates / t.frames);
+    }
+    std::printf("\nnodes: mean grammar size per position; free loop outcomes are the transcript resolved\n"
+                "against the legal moves: right move / a different legal move / no legal move\n");
+    return 0;
+}
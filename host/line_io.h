@@ -0,0 +1,56 @@
+#pragma once
+// Buffered line reading and whole-buffer writes on a file descriptor, shared
+// by game_server and its load generator.
+#include <cerrno>
+#include <cstring>
+#include <string>
+#include <unistd.h>
+
+class LineReader {
+public:
+    explicit LineReader(int fd) : fd(fd) {}
+    // next line without its newline; false at end of input or on error
+    bool next(std::string &line) {
+        for (;;) {
+            if (const char *nl = static_cast<const char *>(std::memchr(buf + pos, '\n', end - pos))) {
+                size_t len = nl - (buf + pos);
+                line.assign(buf + pos, len && nl[-1] == '\r' ? len - 1 : len);
+                pos += len + 1;
+                return true;
+            }
+            if (pos > 0) {
+                std::memmove(buf, buf + pos, end - pos);
+                end -= pos;
+                pos = 0;
+            }
+            if (end == sizeof(buf)) end = 0; // an overlong line is dropped
+            ssize_t n = ::read(fd, buf + end, sizeof(buf) - end);
+            if (n < 0 && errno == EINTR) continue;
+            if (n <= 0) {
+                if (end == 0) return false;
+                line.assign(buf, end); // last line without a newline
+                end = 0;
+                return true;
+            }
+            end += (size_t)n;
+        }
+    }
+    // whether a complete line is already buffered, so next() will not block
+    bool buffered() const { return std::memchr(buf + pos, '\n', end - pos) != nullptr; }
+
+private:
+    int fd;
+    char buf[64 * 1024];
+    size_t pos = 0, end = 0;
+};
+
+inline bool writeAll(int fd, const char *data, size_t len) {
+    while (len) {
+        ssize_t n = ::write(fd, data, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return false;
+        data += n;
+        len -= (size_t)n;
+    }
+    return true;
+}
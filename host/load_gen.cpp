@@ -0,0 +1,234 @@
+// Load generator for game_server: keeps many random games in flight over a
+// few socket connections and reports moves/sec and round-trip latency.
+//
+//   load_gen <socket> [games] [seconds] [connections] [-shutdown]
+//
+// Every game has one request outstanding at a time, as a kiosk board or a bot
+// would: new, then legal / move pairs with a random legal move until the game
+// ends or reaches MaxPlies, then end and a new game. Requests that became
+// ready while reading a burst of replies go out in one write. At the end the
+// server's own stats are fetched and printed; -shutdown then stops it.
+//
+// Before the stats, one game is sent a few hostile load requests (broken hex,
+// truncated snapshots, positions the move generator cannot play from); each
+// must be refused, or loaded with its bad parts dropped, and the game must
+// still answer afterwards. A probe that fails counts as an error.
+#include "line_io.h"
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <string>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+constexpr int MaxPlies = 200;
+
+struct ClientStats {
+    Trace::Histogram latency;
+    uint64_t requests = 0, moves = 0, games = 0, errors = 0;
+};
+
+int connectTo(const char *path) {
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    std::strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (sockaddr *)&addr, sizeof(addr)) != 0) {
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// one connection driving games [first, first + count)
+void drive(const char *path, int first, int count, double seconds, ClientStats &stats) {
+    int fd = connectTo(path);
+    if (fd < 0) { std::perror(path); return; }
+    struct ClientGame { uint32_t id = 0; int plies = 0; uint32_t sentUs = 0; };
+    std::vector<ClientGame> games(count);
+    std::unordered_map<uint32_t, int> byId; // server id -> index into games
+    std::mt19937 rng(first + 1);
+    std::string out, line;
+    uint32_t startUs = Trace::nowUs();
+    bool stopping = false;
+    int outstanding = 0;
+
+    auto send = [&](int g, const std::string &request) {
+        games[g].sentUs = Trace::nowUs();
+        out += request;
+        out += '\n';
+        ++outstanding;
+    };
+    auto newGame = [&](int g) { send(g, "new " + std::to_string(g)); };
+    for (int g=0; g<count; ++g) newGame(g);
+    writeAll(fd, out.data(), out.size());
+    out.clear();
+
+    LineReader in(fd);
+    std::vector<std::string> words;
+    while (outstanding && in.next(line)) {
+        --outstanding;
+        words.clear();
+        for (size_t pos=0; pos<line.size(); ) {
+            size_t space = line.find(' ', pos);
+            if (space == std::string::npos) space = line.size();
+            words.emplace_back(line, pos, space - pos);
+            pos = space + 1;
+        }
+        if (words.size() < 2) { ++stats.errors; continue; }
+        int g;
+        if (words[0] == "new" && words.size() == 3) {
+            g = std::atoi(words[1].c_str());
+            games[g].id = (uint32_t)std::strtoul(words[2].c_str(), nullptr, 10);
+            games[g].plies = 0;
+            byId[games[g].id] = g;
+        } else {
+            auto it = byId.find((uint32_t)std::strtoul(words[1].c_str(), nullptr, 10));
+            if (it == byId.end()) { ++stats.errors; continue; }
+            g = it->second;
+        }
+        ClientGame &game = games[g];
+        stats.latency.add(Trace::nowUs() - game.sentUs);
+        ++stats.requests;
+        if (words[0] == "move") ++stats.moves;
+        if (!stopping && (uint32_t)(Trace::nowUs() - startUs) >= seconds * 1e6) stopping = true;
+
+        std::string id = std::to_string(game.id);
+        if (words[0] == "err") {
+            ++stats.errors;
+            if (!stopping) send(g, "end " + id);
+        } else if (words[0] == "end") {
+            byId.erase(game.id);
+            ++stats.games;
+            if (!stopping) newGame(g);
+        } else if (stopping) {
+            send(g, "end " + id); // leave the server's arena as it was
+        } else if (words[0] == "new") {
+            send(g, "legal " + id);
+        } else if (words[0] == "move") {
+            ++game.plies;
+            bool over = words.size() > 3 || game.plies >= MaxPlies;
+            send(g, (over ? "end " : "legal ") + id);
+        } else if (words[0] == "legal") {
+            if (words.size() == 2) send(g, "end " + id);
+            else send(g, "move " + id + " " + words[2 + std::uniform_int_distribution<size_t>(0, words.size() - 3)(rng)]);
+        }
+        if (!in.buffered() && !out.empty()) {
+            writeAll(fd, out.data(), out.size());
+            out.clear();
+        }
+    }
+    close(fd);
+}
+
+// Game::saveSnapshot layout: "WC", version 1, the packed position (rights,
+// en-passant square, clocks, occupancy, piece nibbles), a u16 move count
+struct LoadProbe {
+    const char *what;
+    const char *hex;
+    bool accepted;
+    const char *notLegal; // a move the loaded game must not offer
+};
+const LoadProbe Probes[] = {
+    {"not hex", "zz", false, nullptr},
+    {"truncated", "574301", false, nullptr},
+    {"king left in check", "574301" "00ff00000100" "5000000000000010" "640e" "0000", false, nullptr},
+    {"pawn on the last rank", "574301" "00ff00000100" "1000000000000090" "e601" "0000", false, nullptr},
+    {"en passant without a pawn", "574301" "001300000100" "1010000000000010" "160e" "0000", false, nullptr},
+    {"castling without a rook", "574301" "01ff00000100" "1000000000000010" "e6" "0000", true, "e1g1"},
+};
+
+// true if every probe was answered as expected
+bool probeLoads(const char *path) {
+    int fd = connectTo(path);
+    if (fd < 0) { std::perror(path); return false; }
+    LineReader in(fd);
+    auto ask = [&](const std::string &request, std::string &reply) {
+        std::string line = request + '\n';
+        writeAll(fd, line.data(), line.size());
+        return in.next(reply);
+    };
+    std::string reply;
+    bool ok = ask("new probe", reply) && !reply.compare(0, 10, "new probe ");
+    std::string id = ok ? reply.substr(10) : "";
+    int failed = ok ? 0 : 1;
+    for (const LoadProbe &p : Probes) {
+        if (!ok) break;
+        std::string legal;
+        bool loaded = ask("load " + id + " " + p.hex, reply) && reply == "load " + id;
+        bool answered = ask("legal " + id, legal) && !legal.compare(0, 6, "legal ");
+        bool good = answered && loaded == p.accepted && (!p.notLegal || legal.find(p.notLegal) == std::string::npos);
+        if (!good) std::printf("load probe \"%s\": %s / %s\n", p.what, reply.c_str(), legal.c_str());
+        failed += !good;
+        ok = answered;
+    }
+    if (ok) ask("end " + id, reply);
+    close(fd);
+    std::printf("load probes: %d of %zu handled\n", (int)(sizeof(Probes) / sizeof(Probes[0])) - failed,
+                sizeof(Probes) / sizeof(Probes[0]));
+    return failed == 0;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: load_gen <socket> [games] [seconds] [connections] [-shutdown]\n");
+        return 2;
+    }
+    const char *path = argv[1];
+    bool shutdownAfter = !std::strcmp(argv[argc - 1], "-shutdown");
+    if (shutdownAfter) --argc;
+    int games = argc > 2 ? std::max(1, std::atoi(argv[2])) : 1000;
+    double seconds = argc > 3 ? std::atof(argv[3]) : 5;
+    int connections = argc > 4 ? std::max(1, std::atoi(argv[4])) : 4;
+    connections = std::min(connections, games);
+
+    std::vector<ClientStats> stats(connections);
+    std::vector<std::thread> threads;
+    uint32_t start = Trace::nowUs();
+    for (int c=0; c<connections; ++c) {
+        int first = games * c / connections, last = games * (c + 1) / connections;
+        threads.emplace_back(drive, path, first, last - first, seconds, std::ref(stats[c]));
+    }
+    for (std::thread &t : threads) t.join();
+    double secs = (uint32_t)(Trace::nowUs() - start) / 1e6;
+
+    ClientStats total;
+    for (const ClientStats &s : stats) {
+        total.latency.merge(s.latency);
+        total.requests += s.requests;
+        total.moves += s.moves;
+        total.games += s.games;
+        total.errors += s.errors;
+    }
+    std::printf("%d games in flight over %d connections, %.2f s\n", games, connections, secs);
+    std::printf("client: %llu requests (%.0f/s), %llu moves (%.0f/s), %llu games finished, %llu errors\n",
+                (unsigned long long)total.requests, total.requests / secs, (unsigned long long)total.moves,
+                total.moves / secs, (unsigned long long)total.games, (unsigned long long)total.errors);
+    std::printf("round trip: p50 %u us  p99 %u us  p99.9 %u us  max %u us\n", (unsigned)total.latency.percentile(0.50),
+                (unsigned)total.latency.percentile(0.99), (unsigned)total.latency.percentile(0.999),
+                (unsigned)total.latency.max());
+
+    if (!probeLoads(path)) ++total.errors;
+
+    int fd = connectTo(path);
+    if (fd < 0) { std::perror(path); return 1; }
+    std::string request = shutdownAfter ? "stats\nshutdown\n" : "stats\n";
+    writeAll(fd, request.data(), request.size());
+    LineReader in(fd);
+    std::string line;
+    if (in.next(line)) std::printf("server: %s\n", line.c_str());
+    close(fd);
+    return total.errors ? 1 : 0;
+}
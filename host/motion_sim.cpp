@@ -0,0 +1,142 @@
+// Plays games on the motion planner and reports how long the board spends
+// moving pieces.
+//
+//   motion_sim [games] [nodes-per-move]
+//
+// Games are engine self-play (a few random opening plies, then a fixed node
+// budget per move, default 20000) so captures, castling and promotions come
+// up the way they do in play. Every move is planned from the position before
+// it; the report gives travel time and distance per game, planning cost, and
+// the same carries timed as a naive router would run them: out to a corner,
+// along one line, along the other, back into the square, never sliding across
+// open squares.
+#include "motion_planner.h"
+#include "search.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+
+using namespace Chess;
+using Motion::MotionPlan;
+using Motion::MotionPlanner;
+using Motion::Point;
+
+namespace {
+
+constexpr int MaxPlies = 200;
+
+struct GameTotals {
+    int plies = 0, captures = 0, castles = 0, promotions = 0, routed = 0, byHand = 0;
+    double seconds = 0, naiveSeconds = 0, carryMm = 0, travelMm = 0, worst = 0, planUs = 0;
+};
+
+// a carry from a to b via the lines only, with the planner's motion profile
+double naiveCarry(const MotionPlanner &p, Point a, Point b) {
+    int dx = std::abs(b.x - a.x), dy = std::abs(b.y - a.y);
+    double t = 2 * p.config().magnetMs / 1000.0 + 2 * p.runSeconds(1.41421f, true);
+    if (dx) t += p.runSeconds((float)dx, true);
+    if (dy) t += p.runSeconds((float)dy, true);
+    return t;
+}
+
+// the plan's time with every carry replaced by naiveCarry; head moves stay as planned
+double naiveSeconds(const MotionPlanner &p, Point start, const MotionPlan &plan) {
+    double t = 0;
+    Point at = start, carryFrom = start;
+    for (int i=0; i<plan.count; ++i) {
+        const Motion::Step &s = plan.steps[i];
+        if (!s.magnet) {
+            t += p.runSeconds(std::hypot((float)(s.to.x - at.x), (float)(s.to.y - at.y)), false);
+        } else if (i + 1 == plan.count || !plan.steps[i + 1].magnet) {
+            t += naiveCarry(p, carryFrom, s.to);
+        }
+        at = s.to;
+        if (!s.magnet) carryFrom = s.to;
+    }
+    return t;
+}
+
+bool gameOver(Board &b) {
+    MoveList legal;
+    b.generateLegal(b.sideToMove, legal);
+    return legal.empty() || b.isThreefoldRepetition() || b.isFiftyMoveDraw();
+}
+
+GameTotals playGame(MotionPlanner &planner, Search &search, uint64_t nodes, std::mt19937 &rng) {
+    Board board;
+    board.setupInitialPosition();
+    planner.reset();
+    search.clear();
+    SearchLimits limits;
+    limits.maxNodes = nodes;
+    GameTotals g;
+    MotionPlan plan;
+    while (g.plies < MaxPlies && !gameOver(board)) {
+        Move m;
+        if (g.plies < 4) {
+            MoveList legal;
+            board.generateLegal(board.sideToMove, legal);
+            m = legal[std::uniform_int_distribution<int>(0, legal.size() - 1)(rng)];
+        } else {
+            m = search.think(board, limits).best;
+        }
+        g.captures += board.isCapture(m);
+        g.castles += m.isCastling();
+        g.promotions += m.isPromotion();
+
+        Point start = planner.head();
+        uint32_t searchesBefore = planner.stats().searches + planner.stats().cacheHits;
+        auto t0 = std::chrono::steady_clock::now();
+        if (!planner.plan(board, m, plan)) {
+            std::fprintf(stderr, "no plan for %s in %s\n", moveToUCI(m).c_str(), board.toFEN().c_str());
+            std::exit(1);
+        }
+        g.planUs += std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        g.routed += planner.stats().searches + planner.stats().cacheHits != searchesBefore;
+        g.byHand += plan.needsHand;
+        g.seconds += plan.seconds;
+        g.naiveSeconds += naiveSeconds(planner, start, plan);
+        g.carryMm += plan.carryMm;
+        g.travelMm += plan.travelMm;
+        g.worst = std::max(g.worst, (double)plan.seconds);
+        board.makeMove(m);
+        ++g.plies;
+    }
+    return g;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    int games = argc > 1 ? std::atoi(argv[1]) : 8;
+    uint64_t nodes = argc > 2 ? (uint64_t)std::atoll(argv[2]) : 20000;
+    Bitboards::init();
+    static MotionPlanner planner; // ~50 KB of tables and search scratch
+    Search search(16 << 20);
+    std::mt19937 rng(18);
+
+    std::printf("%4s %5s %4s %3s %3s %6s  %9s %9s %7s  %8s %8s  %7s %8s\n", "game", "plies", "capt", "O-O", "=Q",
+                "routed", "time s", "naive s", "worst s", "carry m", "travel m", "hand", "plan us");
+    GameTotals all;
+    for (int i=0; i<games; ++i) {
+        GameTotals g = playGame(planner, search, nodes, rng);
+        std::printf("%4d %5d %4d %3d %3d %6d  %9.1f %9.1f %7.2f  %8.2f %8.2f  %7d %8.1f\n", i + 1, g.plies, g.captures,
+                    g.castles, g.promotions, g.routed, g.seconds, g.naiveSeconds, g.worst, g.carryMm / 1000,
+                    g.travelMm / 1000, g.byHand, g.planUs / g.plies);
+        all.plies += g.plies;
+        all.seconds += g.seconds;
+        all.naiveSeconds += g.naiveSeconds;
+        all.planUs += g.planUs;
+        all.worst = std::max(all.worst, g.worst);
+    }
+    Motion::PlannerStats s = planner.stats();
+    std::printf("\nper move: %.2f s (naive %.2f s, %.0f%% saved), worst %.2f s, planning %.1f us\n",
+                all.seconds / all.plies, all.naiveSeconds / all.plies, 100 * (1 - all.seconds / all.naiveSeconds),
+                all.worst, all.planUs / all.plies);
+    std::printf("routes: %u direct, %u searched, %u from the path cache\n", (unsigned)s.directRoutes,
+                (unsigned)s.searches, (unsigned)s.cacheHits);
+    return 0;
+}
@@ -0,0 +1,36 @@
+#pragma once
+// Split-at-root perft shared by the host tools: each root move's subtree is
+// one job, handed out through an atomic counter to threads that each work
+// on their own Board copy.
+#include "board.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// perft(board, depth) is the serial counter to run on each subtree
+template<typename Perft>
+uint64_t parallelPerft(const Chess::Board &root, int depth, int threads, Perft perft) {
+    Chess::MoveList moves;
+    root.generateLegal(root.sideToMove, moves);
+    if (depth <= 1) return depth == 1 ? moves.size() : 1;
+    std::atomic<int> next{0};
+    std::atomic<uint64_t> total{0};
+    auto work = [&]() {
+        Chess::Board b = root;
+        uint64_t nodes = 0;
+        for (int i; (i = next.fetch_add(1, std::memory_order_relaxed)) < moves.size(); ) {
+            b.makeMove(moves[i]);
+            nodes += perft(b, depth - 1);
+            b.undoMove();
+        }
+        total.fetch_add(nodes, std::memory_order_relaxed);
+    };
+    std::vector<std::thread> pool;
+    int n = std::max(1, std::min(threads, moves.size()));
+    pool.reserve(n - 1);
+    for (int t=1; t<n; ++t) pool.emplace_back(work);
+    work();
+    for (std::thread &t : pool) t.join();
+    return total.load();
+}
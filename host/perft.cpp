@@ -0,0 +1,179 @@
+// Perft: counts leaf nodes of the legal move tree to validate move generation
+// and measure its speed.
+//
+//   perft [-j threads]    run the standard suite plus FEN/snapshot round trips,
+//                         exit 1 on any mismatch; with more than one thread each
+//                         position is also counted split at the root, and the
+//                         speedup and scaling efficiency are reported; the
+//                         incremental evaluation is checked against a full
+//                         recompute on every node to depth 3
+//   perft <depth> [fen]   per-move breakdown ("divide") for one position
+#include "board.h"
+#include "eval.h"
+#include "game.h"
+#include "alloc_counter.h"
+#include "parallel_perft.h"
+#include "positions.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace Chess;
+
+static uint64_t perft(Board &b, int depth) {
+    assert(b.isConsistent()); // incremental state (bitboards, lists, key) check, debug builds only
+    MoveList moves;
+    b.generateLegal(b.sideToMove, moves);
+#ifndef NDEBUG
+    MoveList reference; // the direct generator must match make/undo filtering exactly
+    b.generateLegalFiltered(b.sideToMove, reference);
+    assert(reference.size() == moves.size());
+#endif
+    if (depth <= 1) return depth == 1 ? moves.size() : 1;
+    uint64_t nodes = 0;
+    for (const Move &m : moves) {
+        b.makeMove(m);
+        nodes += perft(b, depth - 1);
+        b.undoMove();
+    }
+    return nodes;
+}
+
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static int divide(int depth, const std::string &fen) {
+    Board b;
+    if (!b.loadFEN(fen)) { std::fprintf(stderr, "bad FEN: %s\n", fen.c_str()); return 2; }
+    MoveList moves;
+    b.generateLegal(b.sideToMove, moves);
+    uint64_t total = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const Move &m : moves) {
+        b.makeMove(m);
+        uint64_t n = perft(b, depth - 1);
+        b.undoMove();
+        std::printf("%s: %llu\n", moveToUCI(m).c_str(), (unsigned long long)n);
+        total += n;
+    }
+    double secs = secondsSince(start);
+    std::printf("\nnodes %llu  time %.3fs  nps %.0f\n", (unsigned long long)total, secs, total / secs);
+    return 0;
+}
+
+// nodes where the incremental evaluation differs from a full recompute,
+// checked on the way back up too so undoMove is covered
+static uint64_t evalMismatches(Board &b, int depth) {
+    uint64_t bad = evaluate(b) != evaluateFull(b);
+    if (depth == 0) return bad;
+    MoveList moves;
+    b.generateLegal(b.sideToMove, moves);
+    for (const Move &m : moves) {
+        b.makeMove(m);
+        bad += evalMismatches(b, depth - 1);
+        b.undoMove();
+        bad += evaluate(b) != evaluateFull(b);
+    }
+    return bad;
+}
+
+// FEN and binary snapshot round trips along a deterministic game from fen;
+// returns an empty string on success, else what went wrong
+static std::string roundTrip(const std::string &fen) {
+    Game game;
+    if (!game.loadFEN(fen)) return "loadFEN failed";
+    if (game.toFEN() != fen) return "toFEN gave " + game.toFEN();
+    for (int ply=0; ply<60 && !game.legalMoves().empty(); ++ply) {
+        const Board &b = game.position();
+        Board copy;
+        if (!copy.loadFEN(b.toFEN()) || copy.toString() != b.toString() || copy.key != b.key || !(copy.psq == b.psq))
+            return "FEN round trip at ply " + std::to_string(ply);
+        uint8_t packed[Board::MaxPackedSize];
+        size_t n = b.pack(packed);
+        if (copy.unpack(packed, n) != n || copy.toFEN() != b.toFEN() || copy.key != b.key)
+            return "pack round trip at ply " + std::to_string(ply);
+        const MoveList &moves = game.legalMoves();
+        game.playMove(moves[(ply * 7 + 3) % moves.size()]);
+    }
+    std::vector<uint8_t> snap = game.saveSnapshot();
+    Game restored;
+    if (!restored.loadSnapshot(snap.data(), snap.size())) return "loadSnapshot failed";
+    if (restored.position().toString() != game.position().toString() || restored.toFEN() != game.toFEN() ||
+        restored.movesPlayed() != game.movesPlayed() || restored.saveSnapshot() != snap)
+        return "snapshot round trip";
+    snap.pop_back();
+    if (restored.loadSnapshot(snap.data(), snap.size())) return "truncated snapshot accepted";
+    return "";
+}
+
+int main(int argc, char **argv) {
+    int threads = 1;
+    if (argc > 2 && std::string(argv[1]) == "-j") {
+        threads = std::max(1, std::atoi(argv[2]));
+        argc -= 2;
+        argv += 2;
+    }
+    if (argc > 1) {
+        int depth = std::atoi(argv[1]);
+        std::string fen = argc > 2 ? argv[2] : PerftSuite[0].fen;
+        return divide(depth < 1 ? 1 : depth, fen);
+    }
+    int failures = 0;
+    uint64_t totalNodes = 0;
+    double totalSecs = 0, totalParallelSecs = 0;
+    for (const PerftPosition &p : PerftSuite) {
+        Board b;
+        if (!b.loadFEN(p.fen)) { std::printf("%-10s bad FEN\n", p.name); ++failures; continue; }
+#ifdef CHESS_ALLOC_COUNTER
+        size_t allocsBefore = Debug::allocationCount();
+#endif
+        auto start = std::chrono::steady_clock::now();
+        uint64_t n = perft(b, p.depth);
+        double secs = secondsSince(start);
+        bool ok = n == p.nodes;
+#ifdef CHESS_ALLOC_COUNTER
+        size_t allocs = Debug::allocationCount() - allocsBefore;
+        if (allocs) { std::printf("%-10s %zu heap allocations during perft\n", p.name, allocs); ok = false; }
+#endif
+        failures += !ok;
+        totalNodes += n;
+        totalSecs += secs;
+        std::printf("%-10s depth %d  nodes %10llu  %6.3fs  %10.0f nps  %s\n", p.name, p.depth,
+                    (unsigned long long)n, secs, n / secs, ok ? "ok" : "MISMATCH");
+        if (threads > 1) {
+            start = std::chrono::steady_clock::now();
+            uint64_t pn = parallelPerft(b, p.depth, threads, perft);
+            double psecs = secondsSince(start);
+            totalParallelSecs += psecs;
+            failures += pn != p.nodes;
+            std::printf("%-10s %d threads %10llu  %6.3fs  %10.0f nps  speedup %.2f  efficiency %3.0f%%  %s\n", "",
+                        threads, (unsigned long long)pn, psecs, pn / psecs, secs / psecs, 100 * secs / psecs / threads,
+                        pn == p.nodes ? "ok" : "MISMATCH");
+        }
+    }
+    std::printf("total      nodes %llu  %.3fs  %.0f nps\n", (unsigned long long)totalNodes, totalSecs, totalNodes / totalSecs);
+    if (threads > 1)
+        std::printf("total      %d threads  %.3fs  %.0f nps  speedup %.2f  efficiency %.0f%%\n", threads, totalParallelSecs,
+                    totalNodes / totalParallelSecs, totalSecs / totalParallelSecs, 100 * totalSecs / totalParallelSecs / threads);
+    for (const PerftPosition &p : PerftSuite) {
+        std::string err = roundTrip(p.fen);
+        if (!err.empty()) { std::printf("%-10s round trip: %s\n", p.name, err.c_str()); ++failures; }
+    }
+    if (!failures) std::printf("FEN and snapshot round trips ok\n");
+    uint64_t evalBad = 0;
+    for (const PerftPosition &p : PerftSuite) {
+        Board b;
+        b.loadFEN(p.fen);
+        uint64_t bad = evalMismatches(b, std::min(p.depth, 3));
+        if (bad) std::printf("%-10s incremental evaluation differs at %llu nodes\n", p.name, (unsigned long long)bad);
+        evalBad += bad;
+    }
+    failures += evalBad != 0;
+    if (!evalBad) std::printf("incremental evaluation matches a full recompute\n");
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,166 @@
+// Runs the capture/recognition/engine pipeline on host threads in real time
+// and compares it with the same work done serially in one loop.
+//
+//   pipeline_sim [in.wav] [think-ms]
+//
+// Audio streams from the WAV (default: a synthetic clip of speech-like bursts)
+// at real-time pace. Moves are typed in through submitText and the engine
+// answers each with a search of think-ms (default 800). The serial run drains
+// the same audio and calls the search inline, the way a single-loop app_main
+// would, so every search longer than the 320 ms capture ring loses audio.
+// The pipelined run's latency trace is printed and saved for trace_report.
+#include "pipeline.h"
+#include "trace.h"
+#include "wav_capture.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace Audio;
+
+namespace {
+
+const char *const Moves[] = {"e4", "Nf3", "Bc4", "d3", "O-O", "c3", "h3", "Re1", "a4", "Nbd2"};
+
+std::vector<int16_t> syntheticClip(double seconds) {
+    std::mt19937 rng(5);
+    std::normal_distribution<double> noise(0, 60);
+    std::vector<int16_t> pcm((size_t)(seconds * SampleRate));
+    for (size_t i=0; i<pcm.size(); ++i) {
+        double t = (double)i / SampleRate, v = noise(rng);
+        double inBurst = std::fmod(t, 1.5);
+        if (t > 0.5 && inBurst < 0.6) {
+            double env = std::sin(M_PI * inBurst / 0.6);
+            for (int h=1; h<=5; ++h) v += env * 3000 / h * std::sin(2 * M_PI * 140 * h * t);
+        }
+        pcm[i] = (int16_t)std::max(-32768.0, std::min(32767.0, v));
+    }
+    return pcm;
+}
+
+struct Outcome {
+    CaptureStats capture;
+    uint32_t gaps;
+    int movesPlayed;
+    double seconds;
+};
+
+Outcome runPipelined(const std::string &wav, uint32_t thinkMs) {
+    WavCapture source(wav, 1.0);
+    App::PipelineConfig cfg;
+    cfg.limits.timeMs = thinkMs;
+    cfg.ttBytes = 16 << 20;
+    App::Pipeline pipeline(source, nullptr, cfg);
+    uint32_t begin = Util::nowMs();
+    if (!pipeline.start()) { std::fprintf(stderr, "%s: %s\n", wav.c_str(), source.error().c_str()); std::exit(1); }
+
+    size_t next = 0;
+    bool waiting = false;
+    while (!source.finished()) {
+        if (!waiting && next < sizeof(Moves) / sizeof(Moves[0])) {
+            pipeline.submitText(Moves[next++]);
+            waiting = true;
+        }
+        App::EngineEvent e;
+        while (pipeline.pollEvent(e, 20)) {
+            if (e.kind == App::EngineEvent::Kind::Played) {
+                Trace::record(e.byEngine ? Trace::Point::ReplyMotionStart : Trace::Point::MotionStart, e.traceId);
+                std::printf("  %6.2fs  %-6s %s\n", (Util::nowMs() - begin) / 1000.0, e.byEngine ? "engine" : "player",
+                            Chess::moveToUCI(e.move).c_str());
+            }
+            if (e.kind == App::EngineEvent::Kind::Rejected) std::printf("  rejected %s\n", Moves[next - 1]);
+            if (e.byEngine || e.kind != App::EngineEvent::Kind::Played) waiting = false;
+        }
+    }
+    Util::sleepMs(100); // let the last frames drain
+    App::PipelineStats s = pipeline.stats();
+    pipeline.stop();
+    std::printf("  speech frames %u (dropped %u), utterances %u, feature frames %u\n"
+                "  queues: commands %u, text %u (stalls %u), positions %u, events %u\n"
+                "  stack free: capture %u, recognition %u, engine %u bytes\n",
+                (unsigned)s.speech.pushed, (unsigned)s.speech.dropped, (unsigned)s.utterances,
+                (unsigned)s.featureFrames, (unsigned)s.commands.pushed, (unsigned)s.text.pushed,
+                (unsigned)s.text.stalls, (unsigned)s.positions.pushed, (unsigned)s.events.pushed,
+                (unsigned)s.captureStackFree, (unsigned)s.recognitionStackFree, (unsigned)s.engineStackFree);
+    return {s.capture, s.captureGaps, (int)s.movesPlayed, (Util::nowMs() - begin) / 1000.0};
+}
+
+// everything in one loop, as app_main used to be structured
+Outcome runSerial(const std::string &wav, uint32_t thinkMs) {
+    WavCapture source(wav, 1.0);
+    SpeechRing speech;
+    VadGate gate(speech);
+    FeatureExtractor fx;
+    Chess::Game game;
+    Chess::Search search(16 << 20);
+    Chess::SearchLimits limits;
+    limits.timeMs = thinkMs;
+    uint32_t begin = Util::nowMs(), expected = 0, gaps = 0;
+    bool first = true;
+    size_t next = 0;
+    source.start();
+    while (!source.finished() || source.frames().size()) {
+        Frame *f = source.frames().readSlot();
+        if (f) {
+            if (!first && f->sequence != expected) ++gaps;
+            first = false;
+            expected = f->sequence + 1;
+            gate.push(*f);
+            source.frames().releaseRead();
+            SpeechFrame sf;
+            Features feat;
+            while (speech.tryPop(sf)) fx.push(sf.frame, feat);
+            continue;
+        }
+        // idle: take the next move and think about the reply right here
+        if (next < sizeof(Moves) / sizeof(Moves[0])) {
+            Chess::Resolution r = game.resolveMove(Moves[next++]);
+            if (r.status == Chess::Resolution::Status::Ok && game.playMove(r.move)) {
+                Chess::SearchResult res = search.think(game.position(), limits);
+                if (!res.best.isNone()) game.playMove(res.best);
+            }
+        }
+        Util::sleepMs(5);
+    }
+    source.stop();
+    return {source.stats(), gaps, game.movesPlayed(), (Util::nowMs() - begin) / 1000.0};
+}
+
+void report(const char *name, const Outcome &o) {
+    uint32_t lost = o.capture.ringOverruns + o.capture.dmaOverruns;
+    std::printf("%-10s %6.1fs  frames %5u  lost %5u (%.1f%%)  gaps %3u  moves %d\n", name, o.seconds,
+                (unsigned)o.capture.frames, (unsigned)lost, 100.0 * lost / (o.capture.frames + lost),
+                (unsigned)o.gaps, o.movesPlayed);
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    std::string wav = argc > 1 ? argv[1] : "";
+    uint32_t thinkMs = argc > 2 ? (uint32_t)std::atoi(argv[2]) : 800;
+    if (wav.empty()) {
+        wav = "pipeline_sim_input.wav";
+        std::vector<int16_t> pcm = syntheticClip(12);
+        if (!saveWav(wav, pcm.data(), pcm.size())) { std::perror(wav.c_str()); return 1; }
+    }
+
+    std::printf("pipelined (capture, recognition and engine threads):\n");
+    Outcome piped = runPipelined(wav, thinkMs);
+    std::vector<Trace::Event> events(Trace::Capacity);
+    int count = Trace::snapshot(events.data(), Trace::Capacity);
+    Trace::printReport(stdout, events.data(), count);
+    if (FILE *f = std::fopen("pipeline_sim_trace.log", "w")) {
+        Trace::dumpEvents(f, events.data(), count);
+        std::fclose(f);
+        std::printf("  trace events written to pipeline_sim_trace.log\n");
+    }
+    std::printf("serial (one loop):\n");
+    Outcome serial = runSerial(wav, thinkMs);
+    std::printf("\n");
+    report("pipelined", piped);
+    report("serial", serial);
+    return 0;
+}
@@ -0,0 +1,38 @@
+// Per-stage latency report from recorded trace events: the "TRACE ..." lines
+// the board prints when "trace" is typed on its console (the rest of the
+// serial log is ignored), or a pipeline_sim_trace.log.
+//
+//   trace_report [session.log ...]     (stdin without arguments)
+//
+// Each file gets its own report, since ids are only unique within a session;
+// pass one log per build to compare them side by side.
+#include "trace.h"
+#include <cstdio>
+#include <vector>
+
+static void readEvents(FILE *f, std::vector<Trace::Event> &events) {
+    char line[512];
+    Trace::Event e;
+    while (std::fgets(line, sizeof(line), f))
+        if (Trace::parseEvent(line, e)) events.push_back(e);
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        std::vector<Trace::Event> events;
+        readEvents(stdin, events);
+        Trace::printReport(stdout, events.data(), (int)events.size());
+        return 0;
+    }
+    for (int i=1; i<argc; ++i) {
+        FILE *f = std::fopen(argv[i], "r");
+        if (!f) { std::perror(argv[i]); return 1; }
+        std::vector<Trace::Event> events;
+        readEvents(f, events);
+        std::fclose(f);
+        std::printf("%s: ", argv[i]);
+        Trace::printReport(stdout, events.data(), (int)events.size());
+        if (i + 1 < argc) std::printf("\n");
+    }
+    return 0;
+}
@@ -0,0 +1,112 @@
+#pragma once
+// Work-stealing thread pool over small integer tasks. Each worker owns a
+// deque: it pushes and pops its own work at the back (the freshest, still in
+// cache) and, when that is empty, steals from the front of the others'.
+// Submissions from outside the pool are spread round-robin. Workers with
+// nothing to run or steal sleep until the next submit.
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+class WorkPool {
+public:
+    using Run = std::function<void(uint32_t task, int worker)>;
+
+    WorkPool(int threads, Run run) : run(std::move(run)) {
+        for (int i=0; i<threads; ++i) queues.emplace_back(new Queue);
+        for (int i=0; i<threads; ++i) workers.emplace_back([this, i]() { loop(i); });
+    }
+    ~WorkPool() {
+        {
+            std::lock_guard<std::mutex> l(sleepLock);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (std::thread &t : workers) t.join();
+    }
+    WorkPool(const WorkPool&) = delete;
+    WorkPool &operator=(const WorkPool&) = delete;
+
+    // from any thread; a worker submitting keeps the task on its own deque
+    void submit(uint32_t task) {
+        int q = current.pool == this ? current.id : (int)(next.fetch_add(1, std::memory_order_relaxed) % queues.size());
+        {
+            std::lock_guard<std::mutex> l(queues[q]->lock);
+            queues[q]->items.push_back(task);
+        }
+        pending.fetch_add(1, std::memory_order_release);
+        { std::lock_guard<std::mutex> l(sleepLock); } // a worker between its check and its wait sees pending
+        wake.notify_one();
+    }
+
+    int threads() const { return (int)workers.size(); }
+    uint64_t steals() const { return stolen.load(std::memory_order_relaxed); }
+
+private:
+    struct Queue {
+        std::mutex lock;
+        std::deque<uint32_t> items;
+    };
+    struct Current {
+        const WorkPool *pool = nullptr;
+        int id = -1;
+    };
+
+    bool take(int id, uint32_t &task) {
+        {
+            Queue &own = *queues[id];
+            std::lock_guard<std::mutex> l(own.lock);
+            if (!own.items.empty()) {
+                task = own.items.back();
+                own.items.pop_back();
+                return true;
+            }
+        }
+        for (size_t i=1; i<queues.size(); ++i) {
+            Queue &victim = *queues[(id + i) % queues.size()];
+            std::lock_guard<std::mutex> l(victim.lock);
+            if (!victim.items.empty()) {
+                task = victim.items.front();
+                victim.items.pop_front();
+                stolen.fetch_add(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void loop(int id) {
+        current = {this, id};
+        for (;;) {
+            uint32_t task;
+            if (take(id, task)) {
+                pending.fetch_sub(1, std::memory_order_relaxed);
+                run(task, id);
+                continue;
+            }
+            std::unique_lock<std::mutex> l(sleepLock);
+            wake.wait(l, [this]() { return stopping || pending.load(std::memory_order_acquire) > 0; });
+            if (stopping) return;
+        }
+    }
+
+    static thread_local Current current;
+
+    Run run;
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+    std::atomic<uint32_t> next{0};
+    std::atomic<int> pending{0}; // submitted and not yet taken
+    std::atomic<uint64_t> stolen{0};
+    std::mutex sleepLock;
+    std::condition_variable wake;
+    bool stopping = false;
+};
+
+inline thread_local WorkPool::Current WorkPool::current;
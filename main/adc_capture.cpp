@@ -0,0 +1,132 @@
+#include "adc_capture.h"
+
+#ifdef ESP_PLATFORM
+extern "C" {
+#include "esp_adc/adc_cali.h"
+#include "esp_adc/adc_cali_scheme.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+}
+
+namespace Audio {
+
+static const char *TAG = "ADC_CAPTURE";
+
+constexpr int ResultBytes = SOC_ADC_DIGI_RESULT_BYTES;
+constexpr int64_t FrameUs = 1000000LL * FrameSamples / SampleRate;
+
+AdcCapture::AdcCapture(const AdcMicConfig &c) : cfg(c) {}
+
+AdcCapture::~AdcCapture() { stop(); }
+
+// One calibration call per raw level, once, instead of one per sample in the ISR.
+void AdcCapture::buildTable() {
+    adc_cali_handle_t cali = nullptr;
+    adc_cali_curve_fitting_config_t caliCfg = {};
+    caliCfg.unit_id = ADC_UNIT_1;
+    caliCfg.chan = cfg.channel;
+    caliCfg.atten = cfg.atten;
+    caliCfg.bitwidth = ADC_BITWIDTH_12;
+    bool calibrated = adc_cali_create_scheme_curve_fitting(&caliCfg, &cali) == ESP_OK;
+    if (!calibrated) ESP_LOGW(TAG, "no ADC calibration; assuming a linear 0-3300 mV");
+    for (int raw=0; raw<RawLevels; ++raw) {
+        int mv = raw * 3300 / (RawLevels - 1);
+        if (calibrated) adc_cali_raw_to_voltage(cali, raw, &mv);
+        mvOf[raw] = (int16_t)mv;
+    }
+    if (calibrated) adc_cali_delete_scheme_curve_fitting(cali);
+}
+
+bool AdcCapture::start() {
+    if (adc) return true;
+    resetCounters();
+    buildTable();
+    dc = -1;
+    frame = nullptr;
+    filled = 0;
+    lastIsrUs = 0;
+
+    adc_continuous_handle_cfg_t handleCfg = {};
+    handleCfg.conv_frame_size = FrameSamples * ResultBytes; // one conversion frame per audio frame
+    // the driver also copies each conversion frame into this pool for
+    // adc_continuous_read; nobody reads it, so keep it small and let it flush
+    handleCfg.max_store_buf_size = 2 * handleCfg.conv_frame_size;
+    handleCfg.flags.flush_pool = 1;
+    if (adc_continuous_new_handle(&handleCfg, &adc) != ESP_OK) { adc = nullptr; return false; }
+
+    adc_digi_pattern_config_t pattern = {};
+    pattern.atten = cfg.atten;
+    pattern.channel = cfg.channel;
+    pattern.unit = ADC_UNIT_1;
+    pattern.bit_width = ADC_BITWIDTH_12;
+    adc_continuous_config_t digiCfg = {};
+    digiCfg.pattern_num = 1;
+    digiCfg.adc_pattern = &pattern;
+    digiCfg.sample_freq_hz = SampleRate;
+    digiCfg.conv_mode = ADC_CONV_SINGLE_UNIT_1;
+    digiCfg.format = ADC_DIGI_OUTPUT_FORMAT_TYPE2;
+
+    adc_continuous_evt_cbs_t cbs = {};
+    cbs.on_conv_done = onConversion;
+    if (adc_continuous_config(adc, &digiCfg) != ESP_OK ||
+        adc_continuous_register_event_callbacks(adc, &cbs, this) != ESP_OK ||
+        adc_continuous_start(adc) != ESP_OK) {
+        ESP_LOGE(TAG, "ADC setup failed");
+        adc_continuous_deinit(adc);
+        adc = nullptr;
+        return false;
+    }
+    ESP_LOGI(TAG, "capturing %d Hz on ADC1 channel %d, %d-sample frames", SampleRate, (int)cfg.channel, FrameSamples);
+    return true;
+}
+
+void AdcCapture::stop() {
+    if (!adc) return;
+    adc_continuous_stop(adc);
+    adc_continuous_deinit(adc);
+    adc = nullptr;
+}
+
+// Runs in the DMA ISR once per conversion frame.
+bool IRAM_ATTR AdcCapture::onConversion(adc_continuous_handle_t, const adc_continuous_evt_data_t *event, void *ctx) {
+    AdcCapture *self = static_cast<AdcCapture *>(ctx);
+    // a late ISR means the DMA wrapped over conversion frames we never saw
+    int64_t now = esp_timer_get_time();
+    if (self->lastIsrUs) {
+        int64_t missed = (now - self->lastIsrUs + FrameUs / 2) / FrameUs - 1;
+        if (missed > 0) {
+            self->lostFrames((uint32_t)missed);
+            self->filled = 0; // restart the partial frame rather than splice across the gap
+        }
+    }
+    self->lastIsrUs = now;
+
+    const adc_digi_output_data_t *results = reinterpret_cast<const adc_digi_output_data_t *>(event->conv_frame_buffer);
+    int n = (int)(event->size / ResultBytes);
+    int32_t dc = self->dc;
+    const int gain = self->cfg.gain;
+    for (int i=0; i<n; ++i) {
+        if (results[i].type2.channel != (uint32_t)self->cfg.channel) continue;
+        int32_t x = (int32_t)self->mvOf[results[i].type2.data] << 8; // Q8 mV
+        if (dc < 0) dc = x << DcShift; // first sample: start settled instead of ramping up from 0
+        // the DcShift extra bits keep the step from flooring to 0 while the
+        // level is still up to 4 mV off, which the gain would turn into offset
+        dc += x - (dc >> DcShift);
+        int32_t v = ((x - (dc >> DcShift)) * gain) >> 8;
+        if (!self->filled) {
+            self->frame = self->beginFrame();
+            if (!self->frame) self->frame = &self->discard; // counted as an overrun by beginFrame
+        }
+        self->frame->samples[self->filled++] = (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+        if (self->filled == FrameSamples) {
+            if (self->frame != &self->discard) self->endFrame();
+            self->filled = 0;
+        }
+    }
+    self->dc = dc;
+    return false; // no task woken
+}
+
+} // namespace Audio
+#endif // ESP_PLATFORM
@@ -0,0 +1,49 @@
+#pragma once
+#include "audio_capture.h"
+
+#ifdef ESP_PLATFORM
+extern "C" {
+#include "esp_adc/adc_continuous.h"
+}
+
+namespace Audio {
+
+struct AdcMicConfig {
+    adc_channel_t channel = ADC_CHANNEL_3; // GPIO4 on ADC1, as in the analog mic test
+    adc_atten_t atten = ADC_ATTEN_DB_12;   // ~0-3.3 V
+    int gain = 16;                         // PCM counts per mV after DC removal
+};
+
+// Analog microphone on ADC1 sampled by the continuous-mode DMA driver at
+// 16 kHz. Each conversion frame is one audio frame; the conversion-done ISR
+// turns the raw 12-bit results into PCM straight into a ring slot through a
+// raw-to-mV table built from the calibration scheme at start(), then a
+// one-pole DC blocker and the gain, so a sample costs a table lookup, a few
+// shifts and one multiply. Feeds the same frame ring as I2SCapture.
+class AdcCapture : public AudioSource {
+public:
+    explicit AdcCapture(const AdcMicConfig &cfg = AdcMicConfig());
+    ~AdcCapture() override;
+    bool start() override;
+    void stop() override;
+
+private:
+    static constexpr int RawLevels = 4096;
+    static constexpr int DcShift = 10; // DC tracking time constant, 1024 samples (~2.5 Hz corner)
+
+    static bool onConversion(adc_continuous_handle_t handle, const adc_continuous_evt_data_t *event, void *ctx);
+    void buildTable();
+
+    AdcMicConfig cfg;
+    adc_continuous_handle_t adc = nullptr;
+    int16_t mvOf[RawLevels]; // calibrated millivolts by raw reading
+    // ISR only
+    int32_t dc = 0;          // Q8 millivolts << DcShift; 3300 mV still fits
+    Frame *frame = nullptr;  // being filled, across conversion frames if they split one
+    int filled = 0;
+    Frame discard;           // fills in for a ring slot when the ring is full
+    int64_t lastIsrUs = 0;
+};
+
+} // namespace Audio
+#endif // ESP_PLATFORM
@@ -1,57 +1,75 @@
 extern "C" {
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "driver/i2s_std.h"
 #include "esp_log.h"
+#include "esp_timer.h"
 }
+#include "i2s_capture.h"
+#include "vad.h"
+#include "feature_extractor.h"
+#include <algorithm>
+#include <cstdlib>
 
-#define I2S_NUM     (I2S_NUM_0)
 #define I2S_BCLK   GPIO_NUM_8
 #define I2S_LRCLK  GPIO_NUM_9
 #define I2S_DATA   GPIO_NUM_4
 
 static const char *TAG = "I2S_MIC";
 
+// the frame rings live inside; keep them off the task stack
+static Audio::I2SCapture mic({I2S_BCLK, I2S_LRCLK, I2S_DATA});
+static Audio::SpeechRing speech;
+static Audio::VadGate gate(speech);
+static Audio::FeatureExtractor features;
+
 extern "C" void app_main(void)
 {
-    i2s_chan_handle_t rx_handle;
-    i2s_chan_config_t chan_cfg = I2S_CHANNEL_DEFAULT_CONFIG(I2S_NUM, I2S_ROLE_MASTER);
-    i2s_new_channel(&chan_cfg, NULL, &rx_handle);
-
-
-    // Standard I2S configuration
-    i2s_std_config_t std_cfg = {
-        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(16000),
-        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_32BIT, I2S_SLOT_MODE_MONO),
-        .gpio_cfg = {
-            .mclk = I2S_GPIO_UNUSED,
-            .bclk = I2S_BCLK,
-            .ws = I2S_LRCLK,
-            .dout = I2S_GPIO_UNUSED,
-            .din = I2S_DATA,
-            .invert_flags = {
-                .mclk_inv = false,
-                .bclk_inv = false,
-                .ws_inv = false
-            }
-        }
-    };
-
-    ESP_ERROR_CHECK(i2s_channel_init_std_mode(rx_handle, &std_cfg));
-    ESP_ERROR_CHECK(i2s_channel_enable(rx_handle));
-
+    if (!mic.start()) {
+        ESP_LOGE(TAG, "I2S Microphone failed to start");
+        return;
+    }
     ESP_LOGI(TAG, "I2S Microphone started");
 
-    int32_t sample_buffer[256];
-
+    Audio::FrameRing &ring = mic.frames();
+    uint32_t expected = 0, gaps = 0, frames = 0;
+    int peak = 0;
+    uint32_t hops = 0;
+    int64_t featureUs = 0, worstUs = 0;
+    Audio::Features feat;
     while (true) {
-        size_t bytes_read = 0;
-        ESP_ERROR_CHECK(i2s_channel_read(rx_handle, sample_buffer, sizeof(sample_buffer), &bytes_read, portMAX_DELAY));
-
-        // Print first sample so you know it's alive:
-        int32_t sample = sample_buffer[0] >> 14; // MSB align
-        ESP_LOGI(TAG, "Sample: %d", sample);
+        Audio::Frame *f = ring.readSlot();
+        if (!f) {
+            // the ring holds 320 ms, so polling every 10 ms loses nothing
+            vTaskDelay(pdMS_TO_TICKS(10));
+            continue;
+        }
+        if (f->sequence != expected) ++gaps;
+        expected = f->sequence + 1;
+        for (int16_t s : f->samples) peak = std::max(peak, std::abs((int)s));
+        Audio::Vad::Event ev = gate.push(*f);
+        ring.releaseRead();
+        if (ev == Audio::Vad::Event::Start) ESP_LOGI(TAG, "speech start");
+        if (ev == Audio::Vad::Event::End) ESP_LOGI(TAG, "speech end");
+        // features for every speech frame; nothing consumes them yet
+        Audio::SpeechFrame sf;
+        while (speech.tryPop(sf)) {
+            if (sf.flags & Audio::SpeechFrame::First) features.reset();
+            int64_t t0 = esp_timer_get_time();
+            bool ready = features.push(sf.frame, feat);
+            int64_t us = esp_timer_get_time() - t0;
+            if (ready) { ++hops; featureUs += us; worstUs = std::max(worstUs, us); }
+        }
 
-        vTaskDelay(pdMS_TO_TICKS(50));
+        // once a second: level and any audio lost on the way
+        if (++frames % (Audio::SampleRate / Audio::FrameSamples) == 0) {
+            Audio::CaptureStats s = mic.stats();
+            ESP_LOGI(TAG, "peak %d  frames %u  gaps %u  ring overruns %u  dma overruns %u",
+                     peak, (unsigned)s.frames, (unsigned)gaps, (unsigned)s.ringOverruns, (unsigned)s.dmaOverruns);
+            if (hops) ESP_LOGI(TAG, "features: %u hops, mean %d us, worst %d us of the 10 ms budget",
+                               (unsigned)hops, (int)(featureUs / hops), (int)worstUs);
+            peak = 0;
+            hops = 0;
+            featureUs = worstUs = 0;
+        }
     }
 }
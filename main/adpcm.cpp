@@ -0,0 +1,64 @@
+#include "adpcm.h"
+
+namespace Audio {
+
+namespace {
+
+constexpr int16_t StepTable[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17, 19, 21, 23, 25, 28, 31, 34, 37, 41, 45, 50, 55, 60, 66, 73, 80, 88, 97,
+    107, 118, 130, 143, 157, 173, 190, 209, 230, 253, 279, 307, 337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066, 2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428,
+    4871, 5358, 5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899, 15289, 16818, 18500, 20350,
+    22385, 24623, 27086, 29794, 32767,
+};
+constexpr int8_t IndexTable[8] = {-1, -1, -1, -1, 2, 4, 6, 8}; // by the magnitude bits of a code
+
+inline int clampIndex(int i) { return i < 0 ? 0 : i > 88 ? 88 : i; }
+inline int clampSample(int v) { return v > 32767 ? 32767 : v < -32768 ? -32768 : v; }
+
+// applies code to the state the way the decoder will, so both stay in step
+inline void step(AdpcmState &s, int code) {
+    int st = StepTable[s.index];
+    int diff = st >> 3;
+    if (code & 4) diff += st;
+    if (code & 2) diff += st >> 1;
+    if (code & 1) diff += st >> 2;
+    s.predictor = (int16_t)clampSample(code & 8 ? s.predictor - diff : s.predictor + diff);
+    s.index = (uint8_t)clampIndex(s.index + IndexTable[code & 7]);
+}
+
+inline int encodeSample(AdpcmState &s, int sample) {
+    int st = StepTable[s.index];
+    int diff = sample - s.predictor;
+    int code = 0;
+    if (diff < 0) { code = 8; diff = -diff; }
+    // three bits of diff / step by successive halving
+    if (diff >= st) { code |= 4; diff -= st; }
+    st >>= 1;
+    if (diff >= st) { code |= 2; diff -= st; }
+    st >>= 1;
+    if (diff >= st) code |= 1;
+    step(s, code);
+    return code;
+}
+
+} // namespace
+
+void adpcmEncode(const int16_t *pcm, int count, uint8_t *out, AdpcmState &state) {
+    for (int i=0; i<count; i+=2) {
+        int lo = encodeSample(state, pcm[i]);
+        int hi = encodeSample(state, pcm[i + 1]);
+        out[i >> 1] = (uint8_t)(lo | hi << 4);
+    }
+}
+
+void adpcmDecode(const uint8_t *in, int count, int16_t *pcm, AdpcmState &state) {
+    for (int i=0; i<count; i+=2) {
+        step(state, in[i >> 1] & 15);
+        pcm[i] = state.predictor;
+        step(state, in[i >> 1] >> 4);
+        pcm[i + 1] = state.predictor;
+    }
+}
+
+} // namespace Audio
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+
+// IMA-ADPCM: 4 bits per 16-bit sample, 4:1. Each sample costs a table
+// lookup, a few adds and compares, and no multiply or divide, so it runs
+// inline with capture.
+namespace Audio {
+
+// predictor and step index carried from one sample to the next; a block
+// stores it so it can be decoded on its own
+struct AdpcmState {
+    int16_t predictor = 0;
+    uint8_t index = 0;
+};
+
+// count samples (even) into count / 2 bytes, first sample in the low nibble
+// as in IMA-ADPCM WAV files
+void adpcmEncode(const int16_t *pcm, int count, uint8_t *out, AdpcmState &state);
+void adpcmDecode(const uint8_t *in, int count, int16_t *pcm, AdpcmState &state);
+
+} // namespace Audio
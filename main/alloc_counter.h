@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+
+// Host builds with CHESS_ALLOC_COUNTER defined (the CMake option of that name,
+// on in Debug) replace the global operator new/delete with counting versions
+// so tools can verify that hot paths (move generation, make/undo, search)
+// never touch the heap. The firmware never defines it and does not build
+// alloc_counter.cpp.
+#ifdef CHESS_ALLOC_COUNTER
+
+namespace Chess {
+namespace Debug {
+
+// number of operator new calls since program start
+size_t allocationCount();
+
+} // namespace Debug
+} // namespace Chess
+#endif
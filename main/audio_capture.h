@@ -0,0 +1,82 @@
+#pragma once
+#include "spsc_ring.h"
+#include <atomic>
+#include <cstdint>
+
+namespace Audio {
+
+constexpr int SampleRate = 16000;
+constexpr int FrameSamples = 160; // 10 ms
+
+struct Frame {
+    uint32_t sequence; // consecutive for gap-free audio; a jump means frames were lost
+    int16_t samples[FrameSamples];
+};
+
+using FrameRing = Util::SpscRing<Frame, 32>; // 320 ms of slack for the consumer
+
+struct CaptureStats {
+    uint32_t frames;       // frames delivered to the ring
+    uint32_t ringOverruns; // frames dropped because the consumer fell behind
+    uint32_t dmaOverruns;  // frames lost before reaching us (DMA buffer overwritten)
+};
+
+// 32-bit I2S slot (24-bit sample, MSB aligned) to 16-bit PCM. shift picks the
+// gain: 16 keeps the top 16 bits, each step below doubles the level.
+inline int16_t slotToPcm(int32_t slot, int shift) {
+    int32_t v = slot >> shift;
+    return (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+}
+
+// A continuous 16 kHz mono capture stage. Backends produce frames into the
+// ring from their own context (ISR or thread); the single consumer drains
+// frames() and can tell from Frame::sequence whether anything was lost.
+class AudioSource {
+public:
+    virtual ~AudioSource() = default;
+    virtual bool start() = 0;
+    virtual void stop() = 0;
+
+    FrameRing &frames() { return ring; }
+    CaptureStats stats() const {
+        return {delivered.load(std::memory_order_relaxed), ringOverruns.load(std::memory_order_relaxed),
+                dmaOverruns.load(std::memory_order_relaxed)};
+    }
+
+protected:
+    // Producer side. beginFrame returns the slot to fill in place, or nullptr
+    // if the ring is full, in which case the frame is counted and dropped.
+    // Counters have a single writer, so plain load/store is enough even in an ISR.
+    Frame *beginFrame() {
+        uint32_t seq = sequence.load(std::memory_order_relaxed);
+        sequence.store(seq + 1, std::memory_order_relaxed);
+        Frame *f = ring.writeSlot();
+        if (!f) { bump(ringOverruns); return nullptr; }
+        f->sequence = seq;
+        return f;
+    }
+    void endFrame() {
+        ring.commitWrite();
+        bump(delivered);
+    }
+    // frames the hardware lost; skips their sequence numbers so the gap is visible
+    void lostFrames(uint32_t n) {
+        sequence.store(sequence.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        dmaOverruns.store(dmaOverruns.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+    void resetCounters() {
+        sequence.store(0); delivered.store(0); ringOverruns.store(0); dmaOverruns.store(0);
+    }
+
+    FrameRing ring;
+
+private:
+    static void bump(std::atomic<uint32_t> &c) { c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+    std::atomic<uint32_t> sequence{0};
+    std::atomic<uint32_t> delivered{0};
+    std::atomic<uint32_t> ringOverruns{0};
+    std::atomic<uint32_t> dmaOverruns{0};
+};
+
+} // namespace Audio
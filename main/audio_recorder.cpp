@@ -0,0 +1,65 @@
+#include "audio_recorder.h"
+#include <cstdlib>
+#include <cstring>
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
+namespace Audio {
+
+AudioRecorder::AudioRecorder(uint32_t frames) : count(frames) {
+    size_t bytes = (size_t)frames * sizeof(RecordedFrame);
+    void *p = nullptr;
+#ifdef ESP_PLATFORM
+    // PSRAM: the recording is written once per 10 ms and read only on a flush.
+    // No internal RAM fallback; 264 KB there would starve the search tables.
+    p = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+#else
+    p = std::malloc(bytes);
+#endif
+    slots = static_cast<RecordedFrame *>(p);
+    if (!slots) count = 0;
+}
+
+AudioRecorder::~AudioRecorder() {
+#ifdef ESP_PLATFORM
+    heap_caps_free(slots);
+#else
+    std::free(slots);
+#endif
+}
+
+void AudioRecorder::push(const Frame &f, uint8_t flags) {
+    if (!slots) return;
+    uint32_t h = head.load(std::memory_order_relaxed);
+    RecordedFrame &r = slots[h % count];
+    r.sequence = f.sequence;
+    r.flags = flags;
+    r.index = state.index;
+    r.predictor = state.predictor;
+    adpcmEncode(f.samples, FrameSamples, r.data, state);
+    head.store(h + 1, std::memory_order_release);
+}
+
+bool AudioRecorder::flush(const Writer &write) const {
+    uint8_t header[HeaderSize] = {};
+    uint32_t magic = Magic;
+    uint16_t fields[3] = {Version, (uint16_t)SampleRate, (uint16_t)FrameSamples};
+    std::memcpy(header, &magic, 4);
+    std::memcpy(header + 4, fields, sizeof(fields));
+    if (!write(header, sizeof(header))) return false;
+    if (!slots) return true;
+
+    uint32_t end = head.load(std::memory_order_acquire);
+    for (uint32_t k = end > count ? end - count : 0; k != end; ++k) {
+        RecordedFrame copy;
+        std::memcpy(&copy, &slots[k % count], sizeof(copy));
+        // frame k is gone once push has started on frame k + count
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (head.load(std::memory_order_relaxed) - k >= count) continue;
+        if (!write(&copy, sizeof(copy))) return false;
+    }
+    return true;
+}
+
+} // namespace Audio
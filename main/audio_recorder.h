@@ -0,0 +1,64 @@
+#pragma once
+#include "adpcm.h"
+#include "audio_capture.h"
+#include <atomic>
+#include <cstddef>
+#include <functional>
+
+namespace Audio {
+
+// One 10 ms frame of a recording, decodable on its own from the ADPCM state
+// it starts with. 88 bytes for 320 of PCM.
+struct RecordedFrame {
+    uint32_t sequence; // Frame::sequence; a jump is a gap between utterances
+    uint8_t flags;     // SpeechFrame::First / Last
+    uint8_t index;     // AdpcmState at the start of the frame
+    int16_t predictor;
+    uint8_t data[FrameSamples / 2];
+};
+static_assert(sizeof(RecordedFrame) == 88, "RecordedFrame is stored and sent as is");
+
+// Rolling recording of the most recent utterances, so a misrecognized
+// command can be heard again. The capture task pushes each frame the VAD
+// gate forwards; it is IMA-ADPCM encoded into a ring of RecordedFrames
+// (PSRAM on the device; without it nothing is recorded and ok() is false)
+// that overwrites the oldest frame when full.
+//
+// flush() writes the frames still held, oldest first, as a stream that
+// host/adpcm_wav turns back into WAV:
+//
+//   header  magic "WADP", u16 version, u16 sample rate, u16 frame samples, u16 0
+//   frames  RecordedFrame, little-endian, to the end of the stream
+//
+// It can run on another task while capture keeps pushing: a frame the
+// writer laps while being copied is left out rather than sent torn.
+class AudioRecorder {
+public:
+    static constexpr uint32_t Magic = 0x50444157; // "WADP" as stored
+    static constexpr uint16_t Version = 1;
+    static constexpr size_t HeaderSize = 12;
+    using Writer = std::function<bool(const void *data, size_t len)>;
+
+    explicit AudioRecorder(uint32_t frames = 3000); // 30 s of speech in 264 KB
+    ~AudioRecorder();
+    AudioRecorder(const AudioRecorder&) = delete;
+    AudioRecorder &operator=(const AudioRecorder&) = delete;
+    bool ok() const { return slots != nullptr; }
+
+    // capture task only
+    void push(const Frame &f, uint8_t flags);
+    // any task; false if write failed
+    bool flush(const Writer &write) const;
+
+    uint32_t capacity() const { return count; }
+    uint32_t framesPushed() const { return head.load(std::memory_order_relaxed); }
+    uint32_t framesHeld() const { uint32_t h = framesPushed(); return h < count ? h : count; }
+
+private:
+    RecordedFrame *slots;
+    uint32_t count;
+    std::atomic<uint32_t> head{0}; // frames pushed; the next goes to slots[head % count]
+    AdpcmState state;              // carried across frames so quality does not restart each one
+};
+
+} // namespace Audio
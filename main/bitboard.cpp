@@ -0,0 +1,128 @@
+#include "bitboard.h"
+#ifdef ESP_PLATFORM
+#include "esp_attr.h"
+#else
+#define EXT_RAM_BSS_ATTR
+#endif
+
+namespace Chess {
+namespace Bitboards {
+
+Bitboard knightAttacks[64];
+Bitboard kingAttacks[64];
+Bitboard pawnAttacks[2][64];
+Magic rookMagics[64];
+Magic bishopMagics[64];
+
+// Sum over squares of 2^popcount(mask): 102400 rook and 5248 bishop entries.
+// The rook table is ~800KB, so on the S3 it lives in PSRAM.
+static EXT_RAM_BSS_ATTR Bitboard rookTable[102400];
+static Bitboard bishopTable[5248];
+
+// Found offline with a sparse random search, one per square (a1..h8).
+static constexpr Bitboard RookMagicNumbers[64] = {
+    0x1080004008801020ULL, 0x0840092002C03000ULL, 0x1900200010400900ULL, 0x0880100008000480ULL,
+    0x4200100420080200ULL, 0x8100020100080400ULL, 0x0200040110886200ULL, 0x0200008040220411ULL,
+    0x0404800084400220ULL, 0x0000401000402000ULL, 0x0086001081220440ULL, 0x0408800800100280ULL,
+    0x000A001201040820ULL, 0x8848800200840080ULL, 0x4001000100040200ULL, 0x0442000102105084ULL,
+    0x9080010020804100ULL, 0x0040404000201009ULL, 0x0000808010002009ULL, 0x2200090021D00100ULL,
+    0x0008008008040080ULL, 0x0004004002010040ULL, 0x0011040008015042ULL, 0x00000A0001768104ULL,
+    0x0000800080204009ULL, 0x2010004140002001ULL, 0x9800200280100080ULL, 0x1000100080080080ULL,
+    0x0442000A00049020ULL, 0x2100040080020080ULL, 0x0800120400900148ULL, 0x0010040A00128541ULL,
+    0x2800804000800030ULL, 0x1010002000400041ULL, 0x4000200011004100ULL, 0x0610008410800800ULL,
+    0x0400802402800800ULL, 0xC100020080800400ULL, 0x0002000802000401ULL, 0x0182085882000401ULL,
+    0x0220204000808000ULL, 0x2860100040024022ULL, 0x0001002004110040ULL, 0x99101042000A0020ULL,
+    0x0004080004008080ULL, 0x0010040002008080ULL, 0x2012004881020004ULL, 0x8300842444820011ULL,
+    0x0088403882010200ULL, 0x0820400080210100ULL, 0x0110910040A00300ULL, 0x0801100280080480ULL,
+    0x0242009008200600ULL, 0x1002000489500200ULL, 0x0040800200010080ULL, 0x0091800041000080ULL,
+    0x0000209300488001ULL, 0x04C1002414824001ULL, 0x020020000B001041ULL, 0x7000100004200901ULL,
+    0x8002002004100802ULL, 0x30010002084C0007ULL, 0x0888221800813004ULL, 0x4000002840840112ULL
+};
+
+static constexpr Bitboard BishopMagicNumbers[64] = {
+    0xA010041108003100ULL, 0x006082020A002900ULL, 0x6810010619200000ULL, 0x08281A0520000408ULL,
+    0x0001104001000400ULL, 0x0018901008048400ULL, 0x00040A0210245280ULL, 0x000200210808A402ULL,
+    0x9140048410821200ULL, 0x0800091010820041ULL, 0x20504804832202C0ULL, 0x0100091401081000ULL,
+    0x8021011140000012ULL, 0x0810020804450400ULL, 0x208B0542109008A2ULL, 0x0080084A08040204ULL,
+    0x0040E2A80811244CULL, 0x2505022008008108ULL, 0x0430220100420040ULL, 0x010A040420220040ULL,
+    0x1105000290400000ULL, 0x0093001200822120ULL, 0x4000A62048043004ULL, 0x280120048A015004ULL,
+    0x006090002A020814ULL, 0x44042000240800D0ULL, 0x01102800040A4400ULL, 0x1004080080220040ULL,
+    0x0001001011004024ULL, 0x0010044000805040ULL, 0x0914041200820100ULL, 0x0004821012821480ULL,
+    0x0024040500C05021ULL, 0x0088611002080200ULL, 0x0116080A00040020ULL, 0x4000020080080080ULL,
+    0x2450450140840040ULL, 0x0000880201484100ULL, 0x0222020404020092ULL, 0x8081110600002E00ULL,
+    0x2842101105000801ULL, 0x1100809008001025ULL, 0x00020202221C0400ULL, 0x0422014022009020ULL,
+    0x0210046102100C00ULL, 0xC004008082029102ULL, 0x00AA461801101200ULL, 0x0404080080201108ULL,
+    0x020542108C205002ULL, 0x0410544804100100ULL, 0x0040910841100000ULL, 0x0400200042021100ULL,
+    0x00004204850400C0ULL, 0x0200100410A42102ULL, 0x1040020801210102ULL, 0x0805040410420000ULL,
+    0x2884804130100200ULL, 0x800C262201242000ULL, 0x1058000194108800ULL, 0x0014221054420204ULL,
+    0x0104000012A02200ULL, 0x0200881003300100ULL, 0x0140400202840100ULL, 0x0402020801010201ULL
+};
+
+// step from sq by (df,dr); -1 when it leaves the board
+static int step(int sq, int df, int dr) {
+    int f = (sq & 7) + df, r = (sq >> 3) + dr;
+    return (f<0||f>7||r<0||r>7) ? -1 : r*8 + f;
+}
+
+// slow ray walk, only used to fill the tables
+static Bitboard slidingAttacks(int sq, Bitboard occ, const int (*dirs)[2]) {
+    Bitboard a = 0;
+    for (int d=0; d<4; ++d) {
+        for (int t = step(sq, dirs[d][0], dirs[d][1]); t != -1; t = step(t, dirs[d][0], dirs[d][1])) {
+            a |= bit(t);
+            if (occ & bit(t)) break;
+        }
+    }
+    return a;
+}
+
+static void initMagics(Magic *magics, const Bitboard *numbers, Bitboard *table, const int (*dirs)[2]) {
+    Bitboard *next = table;
+    for (int sq=0; sq<64; ++sq) {
+        Magic &m = magics[sq];
+        Bitboard edges = ((Rank1 | Rank8) & ~(Rank1 << (8*(sq>>3)))) | ((FileA | FileH) & ~(FileA << (sq&7)));
+        m.mask = slidingAttacks(sq, 0, dirs) & ~edges;
+        m.magic = numbers[sq];
+        m.shift = (uint8_t)(64 - popcount(m.mask));
+        m.attacks = next;
+        // enumerate every blocker subset of the mask (carry-rippler)
+        Bitboard occ = 0;
+        do {
+            m.attacks[m.index(occ)] = slidingAttacks(sq, occ, dirs);
+            occ = (occ - m.mask) & m.mask;
+        } while (occ);
+        next += 1ULL << popcount(m.mask);
+    }
+}
+
+static bool build() {
+    constexpr int knightSteps[8][2] = {{1,2},{2,1},{2,-1},{1,-2},{-1,-2},{-2,-1},{-2,1},{-1,2}};
+    constexpr int rookDirs[4][2] = {{1,0},{-1,0},{0,1},{0,-1}};
+    constexpr int bishopDirs[4][2] = {{1,1},{1,-1},{-1,1},{-1,-1}};
+    for (int sq=0; sq<64; ++sq) {
+        knightAttacks[sq] = kingAttacks[sq] = 0;
+        for (auto &s : knightSteps) { int t = step(sq, s[0], s[1]); if (t != -1) knightAttacks[sq] |= bit(t); }
+        for (int df=-1; df<=1; ++df)
+            for (int dr=-1; dr<=1; ++dr) {
+                int t = step(sq, df, dr);
+                if ((df||dr) && t != -1) kingAttacks[sq] |= bit(t);
+            }
+        pawnAttacks[0][sq] = pawnAttacks[1][sq] = 0;
+        for (int df=-1; df<=1; df+=2) {
+            int w = step(sq, df, 1), b = step(sq, df, -1);
+            if (w != -1) pawnAttacks[0][sq] |= bit(w);
+            if (b != -1) pawnAttacks[1][sq] |= bit(b);
+        }
+    }
+    initMagics(rookMagics, RookMagicNumbers, rookTable, rookDirs);
+    initMagics(bishopMagics, BishopMagicNumbers, bishopTable, bishopDirs);
+    return true;
+}
+
+void init() {
+    static const bool done = build(); // thread-safe one-time init
+    (void)done;
+}
+
+} // namespace Bitboards
+} // namespace Chess
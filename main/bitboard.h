@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#if defined(__BMI2__) && !defined(ESP_PLATFORM)
+#include <immintrin.h>
+#define CHESS_USE_PEXT 1
+#endif
+
+namespace Chess {
+
+using Bitboard = uint64_t;
+
+namespace Bitboards {
+
+constexpr Bitboard FileA = 0x0101010101010101ULL;
+constexpr Bitboard FileH = FileA << 7;
+constexpr Bitboard Rank1 = 0xFFULL;
+constexpr Bitboard Rank8 = Rank1 << 56;
+
+constexpr Bitboard bit(int sq) { return 1ULL << sq; }
+inline int lsb(Bitboard b) { return __builtin_ctzll(b); }
+inline int popcount(Bitboard b) { return __builtin_popcountll(b); }
+inline int popLsb(Bitboard &b) { int s = lsb(b); b &= b - 1; return s; }
+
+// Sliding attack lookup for one square. On hosts with BMI2 the index is a
+// PEXT of the blockers, otherwise a classic (fancy) magic multiply.
+struct Magic {
+    Bitboard mask;   // relevant blockers, board edges excluded
+    Bitboard magic;
+    Bitboard *attacks;
+    uint8_t shift;
+    unsigned index(Bitboard occ) const {
+#ifdef CHESS_USE_PEXT
+        return (unsigned)_pext_u64(occ, mask);
+#else
+        return (unsigned)(((occ & mask) * magic) >> shift);
+#endif
+    }
+};
+
+extern Bitboard knightAttacks[64];
+extern Bitboard kingAttacks[64];
+extern Bitboard pawnAttacks[2][64]; // [color][square]: squares a pawn on square attacks
+extern Magic rookMagics[64];
+extern Magic bishopMagics[64];
+
+// build the attack tables; cheap to call again, only the first call does work
+void init();
+
+inline Bitboard rookAttacks(int sq, Bitboard occ) { const Magic &m = rookMagics[sq]; return m.attacks[m.index(occ)]; }
+inline Bitboard bishopAttacks(int sq, Bitboard occ) { const Magic &m = bishopMagics[sq]; return m.attacks[m.index(occ)]; }
+inline Bitboard queenAttacks(int sq, Bitboard occ) { return rookAttacks(sq, occ) | bishopAttacks(sq, occ); }
+
+} // namespace Bitboards
+} // namespace Chess
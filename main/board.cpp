@@ -2,300 +2,500 @@
 #include <cstdio>
 #include <algorithm>
 #include <cctype>
+#include <cstdlib>
 
 namespace Chess {
 
 Board::Board() {
+    Bitboards::init();
     setupInitialPosition();
 }
 
-void Board::setupInitialPosition() {
+void Board::clear() {
     for (auto &p: squares) p = Piece();
-    // White
-    for (int f=0; f<8; ++f) squares[sqidx(f,1)] = Piece(PieceType::Pawn, Color::White);
-    squares[sqidx(0,0)] = Piece(PieceType::Rook, Color::White);
-    squares[sqidx(7,0)] = Piece(PieceType::Rook, Color::White);
-    squares[sqidx(1,0)] = Piece(PieceType::Knight, Color::White);
-    squares[sqidx(6,0)] = Piece(PieceType::Knight, Color::White);
-    squares[sqidx(2,0)] = Piece(PieceType::Bishop, Color::White);
-    squares[sqidx(5,0)] = Piece(PieceType::Bishop, Color::White);
-    squares[sqidx(3,0)] = Piece(PieceType::Queen, Color::White);
-    squares[sqidx(4,0)] = Piece(PieceType::King, Color::White);
-    // Black
-    for (int f=0; f<8; ++f) squares[sqidx(f,6)] = Piece(PieceType::Pawn, Color::Black);
-    squares[sqidx(0,7)] = Piece(PieceType::Rook, Color::Black);
-    squares[sqidx(7,7)] = Piece(PieceType::Rook, Color::Black);
-    squares[sqidx(1,7)] = Piece(PieceType::Knight, Color::Black);
-    squares[sqidx(6,7)] = Piece(PieceType::Knight, Color::Black);
-    squares[sqidx(2,7)] = Piece(PieceType::Bishop, Color::Black);
-    squares[sqidx(5,7)] = Piece(PieceType::Bishop, Color::Black);
-    squares[sqidx(3,7)] = Piece(PieceType::Queen, Color::Black);
-    squares[sqidx(4,7)] = Piece(PieceType::King, Color::Black);
+    for (auto &side: pieces) for (auto &bb: side) bb = 0;
+    colors[0] = colors[1] = 0;
+    occupied = 0;
+    key = 0;
+    psq = Psqt::Score();
+    for (auto &side: pieceCount) for (auto &n: side) n = 0;
+    kingSquare[0] = kingSquare[1] = -1;
+}
+
+void Board::putPiece(int sq, Piece p) {
+    Bitboard b = Bitboards::bit(sq);
+    squares[sq] = p;
+    pieces[(int)p.color][(int)p.type] |= b;
+    colors[(int)p.color] |= b;
+    occupied |= b;
+    key ^= Zobrist::keys.piece[(int)p.color][(int)p.type][sq];
+    psq.mg += Psqt::tables.piece[(int)p.color][(int)p.type][sq].mg;
+    psq.eg += Psqt::tables.piece[(int)p.color][(int)p.type][sq].eg;
+    uint8_t &n = pieceCount[(int)p.color][(int)p.type];
+    pieceList[(int)p.color][(int)p.type][n] = (uint8_t)sq;
+    listIndex[sq] = n++;
+    if (p.type==PieceType::King) kingSquare[(int)p.color] = (int8_t)sq;
+}
+
+void Board::removePiece(int sq) {
+    Piece p = squares[sq];
+    if (p.type==PieceType::Empty) return;
+    Bitboard b = Bitboards::bit(sq);
+    pieces[(int)p.color][(int)p.type] &= ~b;
+    colors[(int)p.color] &= ~b;
+    occupied &= ~b;
+    key ^= Zobrist::keys.piece[(int)p.color][(int)p.type][sq];
+    psq.mg -= Psqt::tables.piece[(int)p.color][(int)p.type][sq].mg;
+    psq.eg -= Psqt::tables.piece[(int)p.color][(int)p.type][sq].eg;
+    // swap the last list entry into the hole
+    uint8_t *list = pieceList[(int)p.color][(int)p.type];
+    uint8_t last = list[--pieceCount[(int)p.color][(int)p.type]];
+    list[listIndex[sq]] = last;
+    listIndex[last] = listIndex[sq];
+    if (p.type==PieceType::King) kingSquare[(int)p.color] = -1;
+    squares[sq] = Piece();
+}
+
+void Board::movePiece(int from, int to) {
+    Piece p = squares[from];
+    Bitboard fromTo = Bitboards::bit(from) | Bitboards::bit(to);
+    pieces[(int)p.color][(int)p.type] ^= fromTo;
+    colors[(int)p.color] ^= fromTo;
+    occupied ^= fromTo;
+    key ^= Zobrist::keys.piece[(int)p.color][(int)p.type][from] ^ Zobrist::keys.piece[(int)p.color][(int)p.type][to];
+    const Psqt::Score *table = Psqt::tables.piece[(int)p.color][(int)p.type];
+    psq.mg += table[to].mg - table[from].mg;
+    psq.eg += table[to].eg - table[from].eg;
+    pieceList[(int)p.color][(int)p.type][listIndex[from]] = (uint8_t)to;
+    listIndex[to] = listIndex[from];
+    if (p.type==PieceType::King) kingSquare[(int)p.color] = (int8_t)to;
+    squares[to] = p;
+    squares[from] = Piece();
+}
+
+void Board::setupInitialPosition() {
+    clear();
+    const PieceType backRank[8] = {PieceType::Rook, PieceType::Knight, PieceType::Bishop, PieceType::Queen,
+                                   PieceType::King, PieceType::Bishop, PieceType::Knight, PieceType::Rook};
+    for (int f=0; f<8; ++f) {
+        putPiece(sqidx(f,0), Piece(backRank[f], Color::White));
+        putPiece(sqidx(f,1), Piece(PieceType::Pawn, Color::White));
+        putPiece(sqidx(f,6), Piece(PieceType::Pawn, Color::Black));
+        putPiece(sqidx(f,7), Piece(backRank[f], Color::Black));
+    }
 
     castlingRights = 0b1111; // both sides both ways: wk,wq,bk,bq
     enpassant = -1;
     sideToMove = Color::White;
+    halfmoveClock = 0;
+    fullmoveNumber = 1;
     history.clear();
+    key = computeKey();
 }
 
-int Board::findKing(Color c) const {
-    for (int i=0;i<64;++i) if (squares[i].type==PieceType::King && squares[i].color==c) return i;
-    return -1;
+uint64_t Board::computeKey() const {
+    uint64_t k = 0;
+    for (int sq=0; sq<64; ++sq) {
+        const Piece &p = squares[sq];
+        if (p.type!=PieceType::Empty) k ^= Zobrist::keys.piece[(int)p.color][(int)p.type][sq];
+    }
+    k ^= Zobrist::keys.castling[castlingRights];
+    if (enpassant != -1) k ^= Zobrist::keys.enpassant[fileOf(enpassant)];
+    if (sideToMove==Color::Black) k ^= Zobrist::keys.side;
+    return k;
 }
 
-bool Board::isSquareAttacked(int sq, Color by) const {
-    if (by==Color::None) return false;
-    // pawns
-    int r = rankOf(sq), f = fileOf(sq);
-    int pawnDir = (by==Color::White)? 1 : -1;
-    int pr = r - pawnDir; // to see pawn attacking sq, pawn must be on pr with diagonal files
-    if (pr>=0 && pr<8) {
-        if (f>0) {
-            int s = sqidx(f-1, pr);
-            if (squares[s].type==PieceType::Pawn && squares[s].color==by) return true;
-        }
-        if (f<7) {
-            int s = sqidx(f+1, pr);
-            if (squares[s].type==PieceType::Pawn && squares[s].color==by) return true;
+Psqt::Score Board::computePsq() const {
+    Psqt::Score s;
+    for (int sq=0; sq<64; ++sq) {
+        const Piece &p = squares[sq];
+        if (p.type==PieceType::Empty) continue;
+        s.mg += Psqt::tables.piece[(int)p.color][(int)p.type][sq].mg;
+        s.eg += Psqt::tables.piece[(int)p.color][(int)p.type][sq].eg;
+    }
+    return s;
+}
+
+int Board::repetitions() const {
+    // positions with the same side to move are 2, 4, ... plies back; nothing
+    // before the last irreversible move can repeat
+    int limit = std::min<int>(halfmoveClock, history.size());
+    int count = 0;
+    for (int i=1; i<limit; i+=2)
+        if (history.keyFromTop(i) == key) ++count;
+    return count;
+}
+
+static PieceType pieceFromChar(char ch) {
+    switch (std::tolower(ch)) {
+        case 'p': return PieceType::Pawn;
+        case 'n': return PieceType::Knight;
+        case 'b': return PieceType::Bishop;
+        case 'r': return PieceType::Rook;
+        case 'q': return PieceType::Queen;
+        case 'k': return PieceType::King;
+        default: return PieceType::Empty;
+    }
+}
+
+bool Board::loadFEN(const std::string &fen) {
+    clear();
+    history.clear();
+    castlingRights = 0;
+    enpassant = -1;
+    sideToMove = Color::White;
+    halfmoveClock = 0;
+    fullmoveNumber = 1;
+    size_t i = 0;
+    // placement, rank 8 first
+    int f = 0, r = 7;
+    for (; i<fen.size() && fen[i]!=' '; ++i) {
+        char ch = fen[i];
+        if (ch=='/') { if (f!=8 || r==0) return false; f = 0; --r; }
+        else if (ch>='1' && ch<='8') f += ch - '0';
+        else {
+            PieceType t = pieceFromChar(ch);
+            Color pc = std::isupper((unsigned char)ch) ? Color::White : Color::Black;
+            if (t==PieceType::Empty || f>7 || pieceCount[(int)pc][(int)t]>=MaxPerType) return false;
+            putPiece(sqidx(f,r), Piece(t, pc));
+            ++f;
         }
+        if (f>8) return false;
     }
-    // knights
-    const int kn[8] = {-17,-15,-10,-6,6,10,15,17};
-    for (int k=0;k<8;++k) {
-        int to = sq + kn[k];
-        if (to<0||to>=64) continue;
-        int tf=fileOf(to), tr=rankOf(to);
-        if (std::abs(tf - f) > 2 || std::abs(tr - r) > 2) continue;
-        if (squares[to].type==PieceType::Knight && squares[to].color==by) return true;
-    }
-    // sliding: bishops & queens diagonals
-    const int diag[4] = {-9,-7,7,9};
-    for (int d=0; d<4; ++d) {
-        int offset = diag[d];
-        int t = sq + offset;
-        while (t>=0 && t<64) {
-            int tf=fileOf(t);
-            if (std::abs(tf - f)>2 && (offset==-9||offset==-7||offset==7||offset==9)) break;
-            if (squares[t].type != PieceType::Empty) {
-                if (squares[t].color==by && (squares[t].type==PieceType::Bishop || squares[t].type==PieceType::Queen)) return true;
-                break;
-            }
-            t += offset;
+    if (r!=0 || f!=8 || ++i>=fen.size()) return false;
+    // side to move
+    if (fen[i]=='b') sideToMove = Color::Black;
+    else if (fen[i]!='w') return false;
+    i += 2;
+    // castling rights
+    for (; i<fen.size() && fen[i]!=' '; ++i) {
+        switch (fen[i]) {
+            case 'K': castlingRights |= 1; break;
+            case 'Q': castlingRights |= 2; break;
+            case 'k': castlingRights |= 4; break;
+            case 'q': castlingRights |= 8; break;
+            case '-': break;
+            default: return false;
         }
     }
-    // sliding: rooks & queens
-    const int orth[4] = {-8,-1,1,8};
-    for (int d=0; d<4; ++d) {
-        int offset = orth[d];
-        int t = sq + offset;
-        while (t>=0 && t<64) {
-            int tf=fileOf(t);
-            if (std::abs(tf - f)>4 && (offset==-1||offset==1)) break;
-            if (squares[t].type != PieceType::Empty) {
-                if (squares[t].color==by && (squares[t].type==PieceType::Rook || squares[t].type==PieceType::Queen)) return true;
-                break;
+    // en-passant square
+    if (++i<fen.size() && fen[i]!='-') {
+        if (i+1>=fen.size()) return false;
+        int ef = fen[i]-'a', er = fen[i+1]-'1';
+        if (ef<0||ef>7||er<0||er>7) return false;
+        enpassant = (int8_t)sqidx(ef,er);
+    }
+    // optional halfmove clock and fullmove number
+    while (i<fen.size() && fen[i]!=' ') ++i;
+    if (i+1<fen.size()) {
+        char *end = nullptr;
+        halfmoveClock = (uint16_t)std::strtoul(fen.c_str() + i + 1, &end, 10);
+        int n = std::atoi(end);
+        if (n > 0) fullmoveNumber = (uint16_t)n;
+    }
+    return validate();
+}
+
+// Shared tail of loadFEN and unpack: the move generator assumes one king a
+// side, castling rights backed by the king and rook on their home squares,
+// an en-passant square behind a pawn that just double-pushed and the side
+// not to move out of check. Rights without their pieces are dropped; the
+// rest is rejected.
+bool Board::validate() {
+    using namespace Bitboards;
+    if (pieceCount[0][(int)PieceType::King]!=1 || pieceCount[1][(int)PieceType::King]!=1) return false;
+    if ((pieces[0][(int)PieceType::Pawn] | pieces[1][(int)PieceType::Pawn]) & (Rank1 | Rank8)) return false;
+    static constexpr struct { int king, rook; Color c; } Homes[4] = {
+        {4, 7, Color::White}, {4, 0, Color::White}, {60, 63, Color::Black}, {60, 56, Color::Black}};
+    for (int i=0; i<4; ++i) {
+        const auto &h = Homes[i];
+        if (!(pieces[(int)h.c][(int)PieceType::King] & bit(h.king)) || !(pieces[(int)h.c][(int)PieceType::Rook] & bit(h.rook)))
+            castlingRights &= (uint8_t)~(1u << i);
+    }
+    Color them = (sideToMove==Color::White) ? Color::Black : Color::White;
+    if (enpassant != -1) {
+        // White to move: Black just pushed to rank 5 through rank 6, and the reverse
+        int epRank = sideToMove==Color::White ? 5 : 2;
+        int pawnSq = sideToMove==Color::White ? enpassant - 8 : enpassant + 8;
+        int fromSq = sideToMove==Color::White ? enpassant + 8 : enpassant - 8;
+        if (rankOf(enpassant) != epRank || !(pieces[(int)them][(int)PieceType::Pawn] & bit(pawnSq)) ||
+            (occupied & (bit(enpassant) | bit(fromSq))))
+            return false;
+    }
+    if (isSquareAttacked(kingSquare[(int)them], sideToMove)) return false;
+    key = computeKey();
+    return true;
+}
+
+#ifndef NDEBUG
+bool Board::isConsistent() const {
+    Bitboard all[2] = {0, 0};
+    for (int col=0; col<2; ++col) {
+        for (int t=(int)PieceType::Pawn; t<=(int)PieceType::King; ++t) {
+            Bitboard bb = pieces[col][t];
+            if (all[col] & bb) return false;
+            all[col] |= bb;
+            if (pieceCount[col][t] != Bitboards::popcount(bb)) return false;
+            for (int i=0; i<pieceCount[col][t]; ++i) {
+                int sq = pieceList[col][t][i];
+                if (!(bb & Bitboards::bit(sq)) || listIndex[sq] != i) return false;
             }
-            t += offset;
         }
+        Bitboard k = pieces[col][(int)PieceType::King];
+        if (kingSquare[col] != (k ? Bitboards::lsb(k) : -1)) return false;
     }
-    // king nearby
-    for (int off=-9; off<=9; ++off) {
-        if (off==0) continue;
-        int to = sq+off;
-        if (to<0||to>=64) continue;
-        int tf=fileOf(to), tr=rankOf(to);
-        if (std::abs(tf - f) > 1 || std::abs(tr - r) > 1) continue;
-        if (squares[to].type==PieceType::King && squares[to].color==by) return true;
+    if (all[0] != colors[0] || all[1] != colors[1] || (colors[0] & colors[1]) || occupied != (colors[0] | colors[1])) return false;
+    for (int sq=0; sq<64; ++sq) {
+        const Piece &p = squares[sq];
+        bool empty = p.type==PieceType::Empty;
+        if (empty != !(occupied & Bitboards::bit(sq))) return false;
+        if (!empty && !(pieces[(int)p.color][(int)p.type] & Bitboards::bit(sq))) return false;
     }
+    return key == computeKey() && psq == computePsq();
+}
+#endif
+
+bool Board::isSquareAttacked(int sq, Color by) const {
+    if (by==Color::None) return false;
+    using namespace Bitboards;
+    const Bitboard *p = pieces[(int)by];
+    // a pawn of 'by' attacks sq iff a pawn of the other color on sq would attack it back
+    if (pawnAttacks[(int)by ^ 1][sq] & p[(int)PieceType::Pawn]) return true;
+    if (knightAttacks[sq] & p[(int)PieceType::Knight]) return true;
+    if (kingAttacks[sq] & p[(int)PieceType::King]) return true;
+    Bitboard queens = p[(int)PieceType::Queen];
+    if (bishopAttacks(sq, occupied) & (p[(int)PieceType::Bishop] | queens)) return true;
+    if (rookAttacks(sq, occupied) & (p[(int)PieceType::Rook] | queens)) return true;
     return false;
 }
 
 // pseudo-legal generation helpers
-void Board::addPawnMoves(int sq, Color c, std::vector<Move> &out) const {
-    int f = fileOf(sq), r = rankOf(sq);
-    int dir = (c==Color::White) ? 1 : -1;
+void Board::addMoves(int from, Bitboard targets, MoveList &out) {
+    while (targets) out.emplace_back(from, Bitboards::popLsb(targets));
+}
+
+void Board::addPromotions(int from, int to, MoveList &out) {
+    // queen first: callers that take the first match get the usual choice
+    out.emplace_back(from, to, Move::Promotion, PieceType::Queen);
+    out.emplace_back(from, to, Move::Promotion, PieceType::Rook);
+    out.emplace_back(from, to, Move::Promotion, PieceType::Bishop);
+    out.emplace_back(from, to, Move::Promotion, PieceType::Knight);
+}
+
+void Board::addPawnMoves(int sq, Color c, Bitboard allowed, MoveList &out) const {
+    int r = rankOf(sq);
+    int dir = (c==Color::White) ? 8 : -8;
     int startRank = (c==Color::White) ? 1 : 6;
-    int toRank = r + dir;
-    if (toRank>=0 && toRank<8) {
-        int to = sqidx(f,toRank);
-        if (squares[to].type==PieceType::Empty) {
-            // promotion?
-            if ((c==Color::White && toRank==7) || (c==Color::Black && toRank==0)) {
-                // promote to q,r,b,n encoded 4..1
-                out.emplace_back(sq,to,4,0);
-                out.emplace_back(sq,to,3,0);
-                out.emplace_back(sq,to,2,0);
-                out.emplace_back(sq,to,1,0);
-            } else out.emplace_back(sq,to,0,0);
-            // double
-            if (r==startRank) {
-                int to2 = sqidx(f, r + 2*dir);
-                if (squares[to2].type==PieceType::Empty) out.emplace_back(sq,to2,0,0);
-            }
-        }
-        // captures
-        if (f>0) {
-            int cap = sqidx(f-1,toRank);
-            if (squares[cap].type!=PieceType::Empty && squares[cap].color!=c) {
-                if ((c==Color::White && toRank==7) || (c==Color::Black && toRank==0)) {
-                    out.emplace_back(sq,cap,4,1);
-                    out.emplace_back(sq,cap,3,1);
-                    out.emplace_back(sq,cap,2,1);
-                    out.emplace_back(sq,cap,1,1);
-                } else out.emplace_back(sq,cap,0,1);
-            }
-            // en-passant capture?
-            if (cap == enpassant && enpassant != -1) out.emplace_back(sq,cap,0,2); // flag enpassant
-        }
-        if (f<7) {
-            int cap = sqidx(f+1,toRank);
-            if (squares[cap].type!=PieceType::Empty && squares[cap].color!=c) {
-                if ((c==Color::White && toRank==7) || (c==Color::Black && toRank==0)) {
-                    out.emplace_back(sq,cap,4,1);
-                    out.emplace_back(sq,cap,3,1);
-                    out.emplace_back(sq,cap,2,1);
-                    out.emplace_back(sq,cap,1,1);
-                } else out.emplace_back(sq,cap,0,1);
-            }
-            if (cap == enpassant && enpassant != -1) out.emplace_back(sq,cap,0,2);
+    bool promo = (c==Color::White) ? (r==6) : (r==1);
+    int to = sq + dir;
+    // pushes
+    if (!(occupied & Bitboards::bit(to))) {
+        if (allowed & Bitboards::bit(to)) {
+            if (promo) {
+                addPromotions(sq, to, out);
+            } else out.emplace_back(sq,to);
         }
+        // double; masked separately since it may block a check the single push can't
+        if (r==startRank && !(occupied & Bitboards::bit(to + dir)) && (allowed & Bitboards::bit(to + dir)))
+            out.emplace_back(sq,to+dir);
     }
-}
-
-void Board::addKnightMoves(int sq, Color c, std::vector<Move> &out) const {
-    constexpr int offsets[8] = {-17,-15,-10,-6,6,10,15,17};
-    int f=fileOf(sq), r=rankOf(sq);
-    for (int i=0;i<8;++i) {
-        int to = sq + offsets[i];
-        if (to<0||to>=64) continue;
-        int tf=fileOf(to), tr=rankOf(to);
-        if (std::abs(tf - f) > 2 || std::abs(tr - r) > 2) continue;
-        if (squares[to].type==PieceType::Empty || squares[to].color!=c) out.emplace_back(sq,(uint8_t)to,0,(squares[to].type==PieceType::Empty)?0:1);
+    // captures
+    Bitboard caps = Bitboards::pawnAttacks[(int)c][sq] & colors[(int)c ^ 1] & allowed;
+    while (caps) {
+        int cap = Bitboards::popLsb(caps);
+        if (promo) {
+            addPromotions(sq, cap, out);
+        } else out.emplace_back(sq,cap);
     }
 }
 
-void Board::addSlidingMoves(int sq, Color c, const int *dirs, int ndirs, bool rooklike, std::vector<Move> &out) const {
-    for (int d=0; d<ndirs; ++d) {
-        int off = dirs[d];
-        int to = sq + off;
-        while (to>=0 && to<64) {
-            int sf=fileOf(sq), tf=fileOf(to);
-            // naive wrap guard
-            if (std::abs(tf - sf) > 2 && (off==-9||off==-7||off==7||off==9)) break;
-            if (squares[to].type==PieceType::Empty) out.emplace_back(sq,(uint8_t)to,0,0);
-            else {
-                if (squares[to].color!=c) out.emplace_back(sq,(uint8_t)to,0,1);
-                break;
-            }
-            to += off;
+void Board::addEnPassantMoves(Color c, bool legalOnly, MoveList &out) const {
+    if (enpassant == -1) return;
+    int victim = enpassant + ((c==Color::White) ? -8 : 8);
+    int king = findKing(c);
+    Bitboard enemy = colors[(int)c ^ 1];
+    Bitboard takers = Bitboards::pawnAttacks[(int)c ^ 1][enpassant] & pieces[(int)c][(int)PieceType::Pawn];
+    while (takers) {
+        int from = Bitboards::popLsb(takers);
+        if (legalOnly) {
+            // two pawns leave their squares at once, which defeats the pin/check
+            // masks (e.g. a rook behind both on the 5th rank), so test the result directly
+            Bitboard occ = (occupied ^ Bitboards::bit(from) ^ Bitboards::bit(victim)) | Bitboards::bit(enpassant);
+            if (attackersTo(king, occ) & enemy & ~Bitboards::bit(victim)) continue;
         }
+        out.emplace_back(from, (int)enpassant, Move::EnPassant);
     }
 }
 
-void Board::addKingMoves(int sq, Color c, std::vector<Move> &out) const {
-    constexpr int offs[8] = {-9,-8,-7,-1,1,7,8,9};
-    for (int i=0;i<8;++i) {
-        int to = sq + offs[i];
-        if (to<0||to>=64) continue;
-        int tf=fileOf(to), tr=rankOf(to);
-        if (std::abs(tf - fileOf(sq)) > 1 || std::abs(tr - rankOf(sq)) > 1) continue;
-        if (squares[to].type==PieceType::Empty || squares[to].color!=c) out.emplace_back(sq,(uint8_t)to,0,(squares[to].type==PieceType::Empty)?0:1);
+void Board::addCastlingMoves(int sq, Color c, MoveList &out) const {
+    // the king may not castle out of, through, or into check
+    int r = (c==Color::White) ? 0 : 7;
+    uint8_t kingSide = (c==Color::White) ? 1 : 4, queenSide = (c==Color::White) ? 2 : 8;
+    Color them = (c==Color::White) ? Color::Black : Color::White;
+    if (!(castlingRights & (kingSide | queenSide)) || sq != sqidx(4,r) || isSquareAttacked(sq, them)) return;
+    // king side: f,g empty
+    Bitboard between = Bitboards::bit(sqidx(5,r)) | Bitboards::bit(sqidx(6,r));
+    if ((castlingRights & kingSide) && !(occupied & between)
+        && !isSquareAttacked(sqidx(5,r), them) && !isSquareAttacked(sqidx(6,r), them)) {
+        out.emplace_back(sq, sqidx(6,r), Move::Castling);
     }
-    // castling possibilities (pseudo-legal); legality/filtering will remove moves leaving king in check or through attacked squares
-    if (c==Color::White) {
-        // king side: squares f1(5), g1(6) must be empty and rights wk (bit0)
-        if ((castlingRights & 1) && squares[sqidx(5,0)].type==PieceType::Empty && squares[sqidx(6,0)].type==PieceType::Empty) {
-            out.emplace_back(sq,(uint8_t)sqidx(6,0),0,4); // flag castling=bit2
-        }
-        // queen side: d1(3), c1(2), b1(1) empty and right bit1
-        if ((castlingRights & 2) && squares[sqidx(3,0)].type==PieceType::Empty && squares[sqidx(2,0)].type==PieceType::Empty && squares[sqidx(1,0)].type==PieceType::Empty) {
-            out.emplace_back(sq,(uint8_t)sqidx(2,0),0,4);
-        }
-    } else {
-        if ((castlingRights & 4) && squares[sqidx(5,7)].type==PieceType::Empty && squares[sqidx(6,7)].type==PieceType::Empty) {
-            out.emplace_back(sq,(uint8_t)sqidx(6,7),0,4);
-        }
-        if ((castlingRights & 8) && squares[sqidx(3,7)].type==PieceType::Empty && squares[sqidx(2,7)].type==PieceType::Empty && squares[sqidx(1,7)].type==PieceType::Empty) {
-            out.emplace_back(sq,(uint8_t)sqidx(2,7),0,4);
-        }
+    // queen side: b,c,d empty; only d and c must be safe
+    between = Bitboards::bit(sqidx(1,r)) | Bitboards::bit(sqidx(2,r)) | Bitboards::bit(sqidx(3,r));
+    if ((castlingRights & queenSide) && !(occupied & between)
+        && !isSquareAttacked(sqidx(3,r), them) && !isSquareAttacked(sqidx(2,r), them)) {
+        out.emplace_back(sq, sqidx(2,r), Move::Castling);
     }
 }
 
-void Board::generatePseudoLegal(Color c, std::vector<Move> &out) const {
+void Board::generatePseudoLegal(Color c, MoveList &out) const {
+    using namespace Bitboards;
     out.clear();
-    for (int i=0;i<64;++i) {
-        const Piece &p = squares[i];
-        if (p.type==PieceType::Empty || p.color!=c) continue;
-        switch (p.type) {
-            case PieceType::Pawn: addPawnMoves(i,c,out); break;
-            case PieceType::Knight: addKnightMoves(i,c,out); break;
-            case PieceType::Bishop: { const int d[4]={-9,-7,7,9}; addSlidingMoves(i,c,d,4,false,out); break; }
-            case PieceType::Rook:   { const int d[4]={-8,-1,1,8}; addSlidingMoves(i,c,d,4,true,out); break; }
-            case PieceType::Queen:  { const int d1[4]={-9,-7,7,9}; addSlidingMoves(i,c,d1,4,false,out); const int d2[4]={-8,-1,1,8}; addSlidingMoves(i,c,d2,4,true,out); break; }
-            case PieceType::King: addKingMoves(i,c,out); break;
-            default: break;
-        }
+    const Bitboard *p = pieces[(int)c];
+    Bitboard targets = ~colors[(int)c];
+    Bitboard b = p[(int)PieceType::Pawn];
+    while (b) addPawnMoves(popLsb(b), c, ~0ULL, out);
+    addEnPassantMoves(c, false, out);
+    b = p[(int)PieceType::Knight];
+    while (b) { int sq = popLsb(b); addMoves(sq, knightAttacks[sq] & targets, out); }
+    b = p[(int)PieceType::Bishop];
+    while (b) { int sq = popLsb(b); addMoves(sq, bishopAttacks(sq, occupied) & targets, out); }
+    b = p[(int)PieceType::Rook];
+    while (b) { int sq = popLsb(b); addMoves(sq, rookAttacks(sq, occupied) & targets, out); }
+    b = p[(int)PieceType::Queen];
+    while (b) { int sq = popLsb(b); addMoves(sq, queenAttacks(sq, occupied) & targets, out); }
+    b = p[(int)PieceType::King];
+    while (b) {
+        int sq = popLsb(b);
+        addMoves(sq, kingAttacks[sq] & targets, out);
+        addCastlingMoves(sq, c, out);
     }
 }
 
-void Board::generateLegal(Color c, std::vector<Move> &out) {
-    std::vector<Move> temp;
-    generatePseudoLegal(c, temp);
+Bitboard Board::attackersTo(int sq, Bitboard occ) const {
+    using namespace Bitboards;
+    const Bitboard (&w)[7] = pieces[0], (&bl)[7] = pieces[1];
+    Bitboard rooks = w[(int)PieceType::Rook] | bl[(int)PieceType::Rook] | w[(int)PieceType::Queen] | bl[(int)PieceType::Queen];
+    Bitboard bishops = w[(int)PieceType::Bishop] | bl[(int)PieceType::Bishop] | w[(int)PieceType::Queen] | bl[(int)PieceType::Queen];
+    return (pawnAttacks[1][sq] & w[(int)PieceType::Pawn])
+         | (pawnAttacks[0][sq] & bl[(int)PieceType::Pawn])
+         | (knightAttacks[sq] & (w[(int)PieceType::Knight] | bl[(int)PieceType::Knight]))
+         | (kingAttacks[sq] & (w[(int)PieceType::King] | bl[(int)PieceType::King]))
+         | (rookAttacks(sq, occ) & rooks)
+         | (bishopAttacks(sq, occ) & bishops);
+}
+
+// squares strictly between a and b when they share a rank, file or diagonal, else 0
+static Bitboard between(int a, int b) {
+    using namespace Bitboards;
+    Bitboard ab = bit(a) | bit(b);
+    if (rookAttacks(a, 0) & bit(b)) return rookAttacks(a, ab) & rookAttacks(b, ab);
+    if (bishopAttacks(a, 0) & bit(b)) return bishopAttacks(a, ab) & bishopAttacks(b, ab);
+    return 0;
+}
+
+// the whole line through a and b (both included), or 0 if they are not aligned
+static Bitboard lineThrough(int a, int b) {
+    using namespace Bitboards;
+    if (rookAttacks(a, 0) & bit(b)) return (rookAttacks(a, 0) & rookAttacks(b, 0)) | bit(a) | bit(b);
+    if (bishopAttacks(a, 0) & bit(b)) return (bishopAttacks(a, 0) & bishopAttacks(b, 0)) | bit(a) | bit(b);
+    return 0;
+}
+
+void Board::generateLegal(Color c, MoveList &out) const {
+    using namespace Bitboards;
     out.clear();
-    out.reserve(temp.size());
-    for (const Move &m : temp) {
-        // make-move & check if own king is in check -> undo
+    Color them = (c==Color::White) ? Color::Black : Color::White;
+    const Bitboard *p = pieces[(int)c];
+    const Bitboard *e = pieces[(int)them];
+    Bitboard own = colors[(int)c], enemy = colors[(int)them];
+    int king = findKing(c);
+    if (king == -1) return;
+
+    // king steps: the king itself must not shield the destination from a slider
+    Bitboard occNoKing = occupied ^ bit(king);
+    Bitboard kt = kingAttacks[king] & ~own;
+    while (kt) {
+        int to = popLsb(kt);
+        if (!(attackersTo(to, occNoKing) & enemy)) out.emplace_back(king, to);
+    }
+
+    Bitboard checkers = attackersTo(king, occupied) & enemy;
+    if (popcount(checkers) > 1) return; // double check: only the king can move
+
+    // with one checker, other pieces must capture it or block the ray
+    Bitboard checkMask = ~0ULL;
+    if (checkers) checkMask = checkers | between(king, lsb(checkers));
+    else addCastlingMoves(king, c, out);
+
+    // own pieces that are the only blocker between the king and an enemy slider
+    Bitboard pinned = 0;
+    Bitboard snipers = (rookAttacks(king, 0) & (e[(int)PieceType::Rook] | e[(int)PieceType::Queen]))
+                     | (bishopAttacks(king, 0) & (e[(int)PieceType::Bishop] | e[(int)PieceType::Queen]));
+    while (snipers) {
+        Bitboard blockers = between(king, popLsb(snipers)) & occupied;
+        if (blockers && !(blockers & (blockers - 1)) && (blockers & own)) pinned |= blockers;
+    }
+    auto allowedFor = [&](int sq) { return (pinned & bit(sq)) ? checkMask & lineThrough(king, sq) : checkMask; };
+
+    Bitboard b = p[(int)PieceType::Pawn];
+    while (b) { int sq = popLsb(b); addPawnMoves(sq, c, allowedFor(sq), out); }
+    addEnPassantMoves(c, true, out);
+    Bitboard targets = ~own;
+    b = p[(int)PieceType::Knight] & ~pinned; // a pinned knight can never move
+    while (b) { int sq = popLsb(b); addMoves(sq, knightAttacks[sq] & targets & checkMask, out); }
+    b = p[(int)PieceType::Bishop];
+    while (b) { int sq = popLsb(b); addMoves(sq, bishopAttacks(sq, occupied) & targets & allowedFor(sq), out); }
+    b = p[(int)PieceType::Rook];
+    while (b) { int sq = popLsb(b); addMoves(sq, rookAttacks(sq, occupied) & targets & allowedFor(sq), out); }
+    b = p[(int)PieceType::Queen];
+    while (b) { int sq = popLsb(b); addMoves(sq, queenAttacks(sq, occupied) & targets & allowedFor(sq), out); }
+}
+
+void Board::generateLegalFiltered(Color c, MoveList &out) {
+    generatePseudoLegal(c, out);
+    // filter in place: make-move & check if own king is in check -> undo
+    int kept = 0;
+    for (int i=0; i<out.size(); ++i) {
+        const Move m = out[i];
         if (!makeMove(m)) { /* invalid move application */ continue; }
         int k = findKing(c);
         bool inCheck = (k==-1) ? true : isSquareAttacked(k, (c==Color::White)?Color::Black:Color::White);
         undoMove();
-        if (!inCheck) out.push_back(m);
+        if (!inCheck) out[kept++] = m;
     }
+    out.resize(kept);
 }
 
 bool Board::makeMove(const Move &m) {
-    if (m.from>=64 || m.to>=64) return false;
+    const int from = m.from(), to = m.to();
+    Piece mover = squares[from];
+    if (mover.type==PieceType::Empty || from==to) return false;
+    // handle en-passant capture: the captured pawn is behind the to square
+    int capSq = m.isEnPassant() ? to + ((sideToMove==Color::White) ? -8 : 8) : to;
+    PieceType captured = squares[capSq].type;
     Undo u;
     u.mv = m;
-    u.captured = squares[m.to];
+    u.halfmoveClock = halfmoveClock;
+    u.captured = captured;
     u.castlingRights = castlingRights;
     u.enpassant = enpassant;
-    history.push_back(u);
-
-    // handle en-passant capture: if flag set as enpassant (2)
-    if (m.flags & 2) {
-        // captured pawn is behind to square
-        int capRank = rankOf(m.to) + ((sideToMove==Color::White) ? -1 : 1);
-        int capSq = sqidx(fileOf(m.to), capRank);
-        u.captured = squares[capSq];
-        squares[capSq] = Piece();
-    }
+    history.push_back(u, key);
+    removePiece(capSq);
 
     // move piece
-    Piece mover = squares[m.from];
-    squares[m.to] = mover;
-    squares[m.from] = Piece();
+    movePiece(from, to);
 
     // promotion
-    if (m.promotion) {
-        squares[m.to].type = static_cast<PieceType>(m.promotion + (int)PieceType::Empty); // consistent mapping
+    if (m.isPromotion()) {
+        removePiece(to);
+        putPiece(to, Piece(m.promotion(), mover.color));
     }
 
     // castling: move rook accordingly
-    if (m.flags & 4) {
-        if (m.to == sqidx(6,0)) { // white king side
-            squares[sqidx(5,0)] = squares[sqidx(7,0)];
-            squares[sqidx(7,0)] = Piece();
-        } else if (m.to == sqidx(2,0)) { // white queen side
-            squares[sqidx(3,0)] = squares[sqidx(0,0)];
-            squares[sqidx(0,0)] = Piece();
-        } else if (m.to == sqidx(6,7)) { // black king side
-            squares[sqidx(5,7)] = squares[sqidx(7,7)];
-            squares[sqidx(7,7)] = Piece();
-        } else if (m.to == sqidx(2,7)) { // black queen side
-            squares[sqidx(3,7)] = squares[sqidx(0,7)];
-            squares[sqidx(0,7)] = Piece();
-        }
+    if (m.isCastling()) {
+        int r = rankOf(to);
+        if (fileOf(to) == 6) movePiece(sqidx(7,r), sqidx(5,r)); // king side
+        else movePiece(sqidx(0,r), sqidx(3,r));                 // queen side
     }
 
     // update castling rights: if king or rook moved or rook captured
@@ -303,70 +503,126 @@ bool Board::makeMove(const Move &m) {
         if (mover.color==Color::White) castlingRights &= ~(1|2);
         else castlingRights &= ~(4|8);
     } else if (mover.type==PieceType::Rook) {
-        if (m.from == sqidx(0,0)) castlingRights &= ~2;
-        if (m.from == sqidx(7,0)) castlingRights &= ~1;
-        if (m.from == sqidx(0,7)) castlingRights &= ~8;
-        if (m.from == sqidx(7,7)) castlingRights &= ~4;
+        if (from == sqidx(0,0)) castlingRights &= ~2;
+        if (from == sqidx(7,0)) castlingRights &= ~1;
+        if (from == sqidx(0,7)) castlingRights &= ~8;
+        if (from == sqidx(7,7)) castlingRights &= ~4;
     }
     // if rook captured, clear rights
-    if (u.captured.type==PieceType::Rook) {
-        if (m.to == sqidx(0,0)) castlingRights &= ~2;
-        if (m.to == sqidx(7,0)) castlingRights &= ~1;
-        if (m.to == sqidx(0,7)) castlingRights &= ~8;
-        if (m.to == sqidx(7,7)) castlingRights &= ~4;
+    if (captured==PieceType::Rook) {
+        if (to == sqidx(0,0)) castlingRights &= ~2;
+        if (to == sqidx(7,0)) castlingRights &= ~1;
+        if (to == sqidx(0,7)) castlingRights &= ~8;
+        if (to == sqidx(7,7)) castlingRights &= ~4;
     }
 
+    key ^= Zobrist::keys.castling[u.castlingRights] ^ Zobrist::keys.castling[castlingRights];
+
     // set enpassant: if pawn double moved, set square behind pawn
+    if (enpassant != -1) key ^= Zobrist::keys.enpassant[fileOf(enpassant)];
     enpassant = -1;
-    if (mover.type==PieceType::Pawn && std::abs((int)rankOf(m.to) - (int)rankOf(m.from))==2) {
-        int epRank = (rankOf(m.to) + rankOf(m.from)) / 2;
-        enpassant = sqidx(fileOf(m.from), epRank);
+    if (mover.type==PieceType::Pawn && std::abs(to - from)==16) {
+        enpassant = (to + from) / 2;
+        key ^= Zobrist::keys.enpassant[fileOf(enpassant)];
     }
 
+    // 50-move rule clock
+    if (mover.type==PieceType::Pawn || captured!=PieceType::Empty) halfmoveClock = 0;
+    else ++halfmoveClock;
+    if (sideToMove==Color::Black) ++fullmoveNumber;
+
     // change side
     sideToMove = (sideToMove==Color::White)?Color::Black:Color::White;
+    key ^= Zobrist::keys.side;
     return true;
 }
 
 void Board::undoMove() {
     if (history.empty()) return;
     Undo u = history.back();
+    uint64_t savedKey = history.backKey();
     history.pop_back();
+    const int from = u.mv.from(), to = u.mv.to();
     // revert side
+    Color them = sideToMove;
     sideToMove = (sideToMove==Color::White)?Color::Black:Color::White;
+    if (sideToMove==Color::Black) --fullmoveNumber;
     // revert enpassant/castling rights
     enpassant = u.enpassant;
     castlingRights = u.castlingRights;
-    // move back
-    squares[u.mv.from] = squares[u.mv.to];
+    halfmoveClock = u.halfmoveClock;
     // handle promotion: if promotion, revert to pawn
-    if (u.mv.promotion) squares[u.mv.from].type = PieceType::Pawn;
+    if (u.mv.isPromotion()) {
+        removePiece(to);
+        putPiece(to, Piece(PieceType::Pawn, sideToMove));
+    }
+    // move back
+    movePiece(to, from);
     // restore captured piece
-    if (u.mv.flags & 2) {
-        // enpassant capture was captured behind 'to'
-        int capRank = rankOf(u.mv.to) + ((sideToMove==Color::White) ? -1 : 1);
-        int capSq = sqidx(fileOf(u.mv.to), capRank);
-        squares[capSq] = u.captured;
-        squares[u.mv.to] = Piece();
-    } else {
-        squares[u.mv.to] = u.captured;
+    if (u.captured != PieceType::Empty) {
+        // an en-passant victim sits behind 'to'
+        int capSq = u.mv.isEnPassant() ? to + ((sideToMove==Color::White) ? -8 : 8) : to;
+        putPiece(capSq, Piece(u.captured, them));
     }
     // revert rook for castling
-    if (u.mv.flags & 4) {
-        if (u.mv.to == sqidx(6,0)) { // white king side
-            squares[sqidx(7,0)] = squares[sqidx(5,0)];
-            squares[sqidx(5,0)] = Piece();
-        } else if (u.mv.to == sqidx(2,0)) { // white queen
-            squares[sqidx(0,0)] = squares[sqidx(3,0)];
-            squares[sqidx(3,0)] = Piece();
-        } else if (u.mv.to == sqidx(6,7)) {
-            squares[sqidx(7,7)] = squares[sqidx(5,7)];
-            squares[sqidx(5,7)] = Piece();
-        } else if (u.mv.to == sqidx(2,7)) {
-            squares[sqidx(0,7)] = squares[sqidx(3,7)];
-            squares[sqidx(3,7)] = Piece();
-        }
+    if (u.mv.isCastling()) {
+        int r = rankOf(to);
+        if (fileOf(to) == 6) movePiece(sqidx(5,r), sqidx(7,r)); // king side
+        else movePiece(sqidx(3,r), sqidx(0,r));                 // queen side
     }
+    // the piece helpers above xor the key as they go; the saved key covers rights/ep/side too
+    key = savedKey;
+}
+
+// Packed position layout (little endian):
+//   [0]     castling rights in bits 0-3, bit 4 set when Black is to move
+//   [1]     en-passant square, 0xff for none
+//   [2..3]  halfmove clock
+//   [4..5]  fullmove number
+//   [6..13] occupancy bitboard
+//   [14..]  one nibble per occupied square in ascending order, low nibble
+//           first: PieceType in bits 0-2, bit 3 set for Black
+size_t Board::pack(uint8_t *out) const {
+    out[0] = (uint8_t)(castlingRights | (sideToMove==Color::Black ? 0x10 : 0));
+    out[1] = enpassant == -1 ? 0xff : (uint8_t)enpassant;
+    out[2] = (uint8_t)halfmoveClock; out[3] = (uint8_t)(halfmoveClock >> 8);
+    out[4] = (uint8_t)fullmoveNumber; out[5] = (uint8_t)(fullmoveNumber >> 8);
+    for (int i=0; i<8; ++i) out[6+i] = (uint8_t)(occupied >> (8*i));
+    size_t n = 14;
+    int nibble = 0;
+    for (Bitboard bb = occupied; bb; ) {
+        const Piece &p = squares[Bitboards::popLsb(bb)];
+        uint8_t v = (uint8_t)((int)p.type | (p.color==Color::Black ? 8 : 0));
+        if (nibble++ & 1) out[n++] |= (uint8_t)(v << 4);
+        else out[n] = v;
+    }
+    return n + (nibble & 1);
+}
+
+size_t Board::unpack(const uint8_t *in, size_t len) {
+    if (len < 14 || (in[0] & 0xe0) || (in[1] != 0xff && in[1] > 63)) return 0;
+    Bitboard occ = 0;
+    for (int i=0; i<8; ++i) occ |= (Bitboard)in[6+i] << (8*i);
+    int count = Bitboards::popcount(occ);
+    size_t size = 14 + (size_t)(count + 1) / 2;
+    if (len < size) return 0;
+    clear();
+    history.clear();
+    castlingRights = in[0] & 0x0f;
+    sideToMove = (in[0] & 0x10) ? Color::Black : Color::White;
+    enpassant = in[1] == 0xff ? -1 : (int8_t)in[1];
+    halfmoveClock = (uint16_t)(in[2] | (in[3] << 8));
+    fullmoveNumber = (uint16_t)(in[4] | (in[5] << 8));
+    int nibble = 0;
+    for (Bitboard bb = occ; bb; ++nibble) {
+        int sq = Bitboards::popLsb(bb);
+        uint8_t v = (uint8_t)((in[14 + nibble/2] >> ((nibble & 1) * 4)) & 0x0f);
+        PieceType t = (PieceType)(v & 7);
+        Color c = (v & 8) ? Color::Black : Color::White;
+        if (t==PieceType::Empty || (int)t > (int)PieceType::King || pieceCount[(int)c][(int)t]>=MaxPerType) return 0;
+        putPiece(sq, Piece(t, c));
+    }
+    return validate() ? size : 0;
 }
 
 std::string Board::toString() const {
@@ -396,6 +652,33 @@ std::string Board::toString() const {
     return out;
 }
 
+std::string Board::toFEN() const {
+    char buf[96]; // longest placement is 64 chars; the rest fits easily
+    char *p = buf;
+    for (int r=7; r>=0; --r) {
+        int empty = 0;
+        for (int f=0; f<8; ++f) {
+            const Piece &pc = squares[sqidx(f,r)];
+            if (pc.type==PieceType::Empty) { ++empty; continue; }
+            if (empty) { *p++ = (char)('0' + empty); empty = 0; }
+            char c = " PNBRQK"[(int)pc.type];
+            *p++ = pc.color==Color::Black ? (char)std::tolower(c) : c;
+        }
+        if (empty) *p++ = (char)('0' + empty);
+        if (r) *p++ = '/';
+    }
+    *p++ = ' ';
+    *p++ = sideToMove==Color::White ? 'w' : 'b';
+    *p++ = ' ';
+    if (!castlingRights) *p++ = '-';
+    for (int i=0; i<4; ++i) if (castlingRights & (1<<i)) *p++ = "KQkq"[i];
+    *p++ = ' ';
+    if (enpassant == -1) *p++ = '-';
+    else { *p++ = (char)('a' + fileOf(enpassant)); *p++ = (char)('1' + rankOf(enpassant)); }
+    std::snprintf(p, buf + sizeof(buf) - p, " %u %u", (unsigned)halfmoveClock, (unsigned)fullmoveNumber);
+    return std::string(buf);
+}
+
 void Board::debugPrint() const {
     std::string s = toString();
     std::printf("%s\n", s.c_str());
@@ -1,52 +1,139 @@
 #pragma once
 #include "chess_types.h"
 #include "move.h"
+#include "bitboard.h"
+#include "psqt.h"
+#include "zobrist.h"
 #include <array>
-#include <vector>
 #include <string>
 
 namespace Chess {
 
+// Everything makeMove overwrites that can't be recomputed, in 8 bytes. The
+// position key lives in a parallel array in UndoStack.
 struct Undo {
     Move mv;
-    Piece captured;
+    uint16_t halfmoveClock;
+    PieceType captured;     // its color is always the side that did not move
     uint8_t castlingRights; // 4 bits: wk, wq, bk, bq
-    int8_t enpassant; // -1 none or square
+    int8_t enpassant;       // -1 none or square
+};
+static_assert(sizeof(Undo) <= 8, "Undo must stay compact");
+
+// Preallocated undo history used as a ring: once full, pushing overwrites the
+// oldest entry, so only the last Capacity moves can be taken back. Keys are kept
+// apart from the records so repetition scans walk a dense array.
+class UndoStack {
+public:
+    static constexpr int Capacity = 512; // power of two
+    void clear() { top = 0; count = 0; }
+    bool empty() const { return count == 0; }
+    int size() const { return count; }
+    void push_back(const Undo &u, uint64_t key) {
+        items[top] = u;
+        keys[top] = key;
+        top = (top + 1) & (Capacity - 1);
+        if (count < Capacity) ++count;
+    }
+    void pop_back() { top = (top - 1) & (Capacity - 1); --count; }
+    Undo &back() { return items[(top - 1) & (Capacity - 1)]; }
+    uint64_t backKey() const { return keys[(top - 1) & (Capacity - 1)]; }
+    // i-th most recent entry, 0 = last pushed
+    const Undo &fromTop(int i) const { return items[(top - 1 - i) & (Capacity - 1)]; }
+    // position key before the i-th most recent move
+    uint64_t keyFromTop(int i) const { return keys[(top - 1 - i) & (Capacity - 1)]; }
+private:
+    std::array<Undo,Capacity> items;
+    std::array<uint64_t,Capacity> keys;
+    int top = 0, count = 0;
 };
 
 class Board {
 public:
     Board();
     void setupInitialPosition();
+    // load a position from FEN; returns false on malformed input or an
+    // unplayable position (see validate)
+    bool loadFEN(const std::string &fen);
     // generate pseudo-legal moves for color
-    void generatePseudoLegal(Color c, std::vector<Move> &out) const;
-    // generate legal moves (filters pseudo-legal by not leaving king in check)
-    void generateLegal(Color c, std::vector<Move> &out);
+    void generatePseudoLegal(Color c, MoveList &out) const;
+    // generate legal moves directly, using checkers and pinned pieces computed once per call
+    void generateLegal(Color c, MoveList &out) const;
+    // reference legal generator: pseudo-legal moves filtered by make/undo; slow,
+    // kept to cross-check generateLegal
+    void generateLegalFiltered(Color c, MoveList &out);
     // make and undo
     bool makeMove(const Move &m);
     void undoMove();
     // helpers
     bool isSquareAttacked(int sq, Color by) const;
-    int findKing(Color c) const;
+    int findKing(Color c) const { return kingSquare[(int)c]; }
+    // pieces of both colors attacking sq, given occupancy occ
+    Bitboard attackersTo(int sq, Bitboard occ) const;
+    bool isCapture(const Move &m) const { return m.isEnPassant() || squares[m.to()].type != PieceType::Empty; }
+    // number of earlier occurrences of the current position, scanning back
+    // only to the last capture or pawn move
+    int repetitions() const;
+    bool isThreefoldRepetition() const { return repetitions() >= 2; }
+    bool isFiftyMoveDraw() const { return halfmoveClock >= 100; }
+    // full recompute of the Zobrist key, for setup and consistency checks
+    uint64_t computeKey() const;
+    // full recompute of psq, for consistency checks
+    Psqt::Score computePsq() const;
+#ifndef NDEBUG
+    // cross-checks squares, bitboards, piece lists, king squares, key and psq
+    bool isConsistent() const;
+#endif
+    Bitboard piecesOf(Color c, PieceType t) const { return pieces[(int)c][(int)t]; }
     std::string toString() const;
+    std::string toFEN() const;
+    // compact binary form of the position (placement, side, rights, clocks),
+    // 14 to 30 bytes; the undo history is not included
+    static constexpr size_t MaxPackedSize = 30;
+    size_t pack(uint8_t *out) const;
+    // returns the bytes consumed, 0 if malformed or unplayable (the board is
+    // then unspecified)
+    size_t unpack(const uint8_t *in, size_t len);
     void debugPrint() const;
 
     // state
-    std::array<Piece,64> squares;
+    std::array<Piece,64> squares; // mailbox mirror of the bitboards, for piece-on-square lookups
+    Bitboard pieces[2][7]; // [color][PieceType]; index 0 (Empty) unused
+    Bitboard colors[2];    // all pieces of each color
+    Bitboard occupied;
+    // piece lists, kept in step with the bitboards; listIndex maps a square
+    // to its slot in the list of the piece standing on it
+    static constexpr int MaxPerType = 10; // 2 originals + 8 promotions
+    uint8_t pieceList[2][7][MaxPerType];
+    uint8_t pieceCount[2][7];
+    uint8_t listIndex[64];
+    int8_t kingSquare[2]; // -1 if missing
     uint8_t castlingRights; // bits: 0 white king,1 white queen,2 black king,3 black queen
     int8_t enpassant; // square index or -1
     Color sideToMove;
-    std::vector<Undo> history; // small vector for undo stack
+    uint16_t halfmoveClock; // plies since the last capture or pawn move
+    uint16_t fullmoveNumber; // starts at 1, incremented after Black moves
+    uint64_t key; // Zobrist key, updated incrementally by makeMove/undoMove
+    Psqt::Score psq; // material and square bonuses, White minus Black, updated with key
+    UndoStack history;
 
 private:
     static constexpr int fileOf(int sq) { return sq & 7; }
     static constexpr int rankOf(int sq) { return sq >> 3; }
     static int sqidx(int f,int r) { return r*8 + f; }
 
-    void addPawnMoves(int sq, Color c, std::vector<Move> &out) const;
-    void addKnightMoves(int sq, Color c, std::vector<Move> &out) const;
-    void addKingMoves(int sq, Color c, std::vector<Move> &out) const;
-    void addSlidingMoves(int sq, Color c, const int *dirs, int ndirs, bool rooklike, std::vector<Move> &out) const;
+    void clear();
+    // drops unbacked castling rights; false if the position cannot be played from
+    bool validate();
+    void putPiece(int sq, Piece p);
+    void removePiece(int sq);
+    void movePiece(int from, int to);
+
+    static void addMoves(int from, Bitboard targets, MoveList &out);
+    static void addPromotions(int from, int to, MoveList &out);
+    void addPawnMoves(int sq, Color c, Bitboard allowed, MoveList &out) const;
+    void addEnPassantMoves(Color c, bool legalOnly, MoveList &out) const;
+    void addCastlingMoves(int sq, Color c, MoveList &out) const;
 };
 
 } // namespace Chess
@@ -0,0 +1,104 @@
+#pragma once
+#include "spsc_ring.h"
+#include "task.h"
+#include <atomic>
+
+namespace Util {
+
+struct ChannelStats {
+    uint32_t pushed;    // items delivered
+    uint32_t dropped;   // items the producer gave up on because the channel stayed full
+    uint32_t stalls;    // times the producer found the channel full and had to wait
+    uint32_t highWater; // deepest the queue has been
+};
+
+// SpscRing between two tasks, with wake-ups and counters. Producers choose
+// per item: tryPush drops when full (audio, where waiting would only move the
+// loss upstream); push waits up to a timeout for the consumer, which is the
+// backpressure for commands that must not be lost. The consumer blocks in
+// pop, or in a Signal shared by several channels (see wakeOnData).
+template<typename T, uint32_t Capacity>
+class Channel {
+public:
+    bool tryPush(const T &v) {
+        if (!ring.push(v)) { bump(droppedCount); return false; }
+        published();
+        return true;
+    }
+    bool push(const T &v, int timeoutMs) {
+        if (ring.push(v)) { published(); return true; }
+        bump(stallCount);
+        uint32_t deadline = nowMs() + (uint32_t)timeoutMs;
+        for (;;) {
+            int left = (int)(deadline - nowMs());
+            if (left < 0 || !space.wait(left)) {
+                if (ring.push(v)) break; // freed just as the wait ran out
+                bump(droppedCount);
+                return false;
+            }
+            if (ring.push(v)) break;
+        }
+        published();
+        return true;
+    }
+
+    // in place, for large items: a null slot means the item is dropped (and counted)
+    T *writeSlot() {
+        T *s = ring.writeSlot();
+        if (!s) bump(droppedCount);
+        return s;
+    }
+    void commitWrite() {
+        ring.commitWrite();
+        published();
+    }
+
+    // consumer, in place
+    T *readSlot() { return ring.readSlot(); }
+    void releaseRead() {
+        ring.releaseRead();
+        space.notify();
+    }
+    bool tryPop(T &v) {
+        if (!ring.pop(v)) return false;
+        space.notify();
+        return true;
+    }
+    // false on timeout; timeoutMs < 0 waits forever
+    bool pop(T &v, int timeoutMs) {
+        uint32_t deadline = nowMs() + (uint32_t)timeoutMs;
+        while (!tryPop(v)) {
+            int left = timeoutMs < 0 ? -1 : (int)(deadline - nowMs());
+            if (timeoutMs >= 0 && left < 0) return false;
+            if (!dataSignal->wait(left)) return tryPop(v);
+        }
+        return true;
+    }
+
+    // route this channel's data notifications to a signal the consumer shares
+    // with other channels, so it can sleep on all of them at once
+    void wakeOnData(Signal &s) { dataSignal = &s; }
+
+    uint32_t size() const { return ring.size(); }
+    ChannelStats stats() const {
+        return {pushedCount.load(std::memory_order_relaxed), droppedCount.load(std::memory_order_relaxed),
+                stallCount.load(std::memory_order_relaxed), highWater.load(std::memory_order_relaxed)};
+    }
+
+private:
+    // counters have a single writer, the producer
+    static void bump(std::atomic<uint32_t> &c) { c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+    void published() {
+        bump(pushedCount);
+        uint32_t depth = ring.size();
+        if (depth > highWater.load(std::memory_order_relaxed)) highWater.store(depth, std::memory_order_relaxed);
+        dataSignal->notify();
+    }
+
+    SpscRing<T, Capacity> ring;
+    Signal data, space;
+    Signal *dataSignal = &data;
+    std::atomic<uint32_t> pushedCount{0}, droppedCount{0}, stallCount{0}, highWater{0};
+};
+
+} // namespace Util
@@ -0,0 +1,240 @@
+#include "dsp_kernels.h"
+
+#if defined(ESP_PLATFORM)
+#include "sdkconfig.h"
+#endif
+
+#if defined(__SSE4_1__)
+#include <immintrin.h>
+#elif defined(CONFIG_IDF_TARGET_ESP32S3)
+extern "C" {
+#include "dsps_mul.h"
+#include "dsps_fft2r.h"
+#include "dsps_dotprod.h"
+}
+#endif
+
+namespace Audio {
+namespace Dsp {
+
+#if defined(__SSE4_1__)
+
+const char *backend() {
+#ifdef __AVX2__
+    return "avx2";
+#else
+    return "sse4.1";
+#endif
+}
+
+void window(const int16_t *x, const int16_t *w, int16_t *out, int n) {
+    int i = 0;
+#ifdef __AVX2__
+    for (; i+16<=n; i+=16) {
+        __m256i a = _mm256_loadu_si256((const __m256i *)(x + i)), b = _mm256_loadu_si256((const __m256i *)(w + i));
+        _mm256_storeu_si256((__m256i *)(out + i), _mm256_mulhrs_epi16(a, b)); // (a*b + 2^14) >> 15
+    }
+#endif
+    for (; i+8<=n; i+=8) {
+        __m128i a = _mm_loadu_si128((const __m128i *)(x + i)), b = _mm_loadu_si128((const __m128i *)(w + i));
+        _mm_storeu_si128((__m128i *)(out + i), _mm_mulhrs_epi16(a, b));
+    }
+    if (i < n) Ref::window(x + i, w + i, out + i, n - i);
+}
+
+int peakAbs(const int16_t *x, int n) {
+    int i = 0, peak = 0;
+    __m128i m = _mm_setzero_si128();
+#ifdef __AVX2__
+    __m256i m8 = _mm256_setzero_si256();
+    for (; i+16<=n; i+=16) m8 = _mm256_max_epu16(m8, _mm256_abs_epi16(_mm256_loadu_si256((const __m256i *)(x + i))));
+    m = _mm_max_epu16(_mm256_castsi256_si128(m8), _mm256_extracti128_si256(m8, 1));
+#endif
+    // |−32768| comes out as 0x8000, which is right when read unsigned
+    for (; i+8<=n; i+=8) m = _mm_max_epu16(m, _mm_abs_epi16(_mm_loadu_si128((const __m128i *)(x + i))));
+    // minpos finds the minimum, so search the complement
+    peak = 0xffff - _mm_extract_epi16(_mm_minpos_epu16(_mm_xor_si128(m, _mm_set1_epi16(-1))), 0);
+    if (i < n) { int rest = Ref::peakAbs(x + i, n - i); if (rest > peak) peak = rest; }
+    return peak;
+}
+
+void shiftLeft(int16_t *x, int n, int shift) {
+    int i = 0;
+    __m128i s = _mm_cvtsi32_si128(shift);
+    for (; i+8<=n; i+=8) {
+        __m128i *p = (__m128i *)(x + i);
+        _mm_storeu_si128(p, _mm_sll_epi16(_mm_loadu_si128(p), s));
+    }
+    if (i < n) Ref::shiftLeft(x + i, n - i, shift);
+}
+
+// the same bit reversal as Ref, kept local so fft stays self-contained
+static void bitReverse(int16_t *z, int n) {
+    int32_t *c = (int32_t *)z; // one complex point per 32-bit word
+    for (int i=1, j=0; i<n; ++i) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) { int32_t t = c[i]; c[i] = c[j]; c[j] = t; }
+    }
+}
+
+void fft(int16_t *z, int n, const Twiddle *tw) {
+    bitReverse(z, n);
+    const __m128i round = _mm_set1_epi32(1 << 15);
+    for (int half=1; half<n; half*=2) {
+        const Twiddle *stage = tw + half - 1;
+        if (half < 4) {
+            // too narrow for four butterflies per vector
+            for (int base=0; base<n; base+=2*half) {
+                for (int j=0; j<half; ++j) {
+                    int16_t *u = z + 2*(base + j), *a = u + 2*half;
+                    const int16_t *r = stage[j].rot;
+                    int32_t tr = (a[0]*r[0] + a[1]*r[1] + (1 << 15)) >> 16;
+                    int32_t ti = (a[0]*r[2] + a[1]*r[3] + (1 << 15)) >> 16;
+                    int32_t ur = u[0] >> 1, ui = u[1] >> 1;
+                    auto sat = [](int32_t v) { return (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v); };
+                    u[0] = sat(ur + tr); u[1] = sat(ui + ti);
+                    a[0] = sat(ur - tr); a[1] = sat(ui - ti);
+                }
+            }
+            continue;
+        }
+        for (int base=0; base<n; base+=2*half) {
+            for (int j=0; j<half; j+=4) {
+                __m128i *pu = (__m128i *)(z + 2*(base + j)), *pa = (__m128i *)(z + 2*(base + j + half));
+                __m128i u = _mm_loadu_si128(pu), a = _mm_loadu_si128(pa);
+                // twiddles for four butterflies: (wr,-wi,wi,wr) each; split into the re and im dot products
+                __m128i w01 = _mm_loadu_si128((const __m128i *)stage[j].rot);
+                __m128i w23 = _mm_loadu_si128((const __m128i *)stage[j+2].rot);
+                __m128i wRe = _mm_unpacklo_epi64(_mm_shuffle_epi32(w01, 0x08), _mm_shuffle_epi32(w23, 0x08));
+                __m128i wIm = _mm_unpacklo_epi64(_mm_shuffle_epi32(w01, 0x0d), _mm_shuffle_epi32(w23, 0x0d));
+                __m128i tr = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(a, wRe), round), 16);
+                __m128i ti = _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(a, wIm), round), 16);
+                __m128i t = _mm_blend_epi16(tr, _mm_slli_epi32(ti, 16), 0xaa); // re in the low half, im in the high
+                __m128i h = _mm_srai_epi16(u, 1);
+                _mm_storeu_si128(pu, _mm_adds_epi16(h, t));
+                _mm_storeu_si128(pa, _mm_subs_epi16(h, t));
+            }
+        }
+    }
+}
+
+void power(const int16_t *bins, int32_t *out, int n) {
+    int k = 0;
+#ifdef __AVX2__
+    for (; k+8<=n; k+=8) {
+        __m256i b = _mm256_loadu_si256((const __m256i *)(bins + 2*k));
+        _mm256_storeu_si256((__m256i *)(out + k), _mm256_madd_epi16(b, b)); // re*re + im*im per pair
+    }
+#endif
+    for (; k+4<=n; k+=4) {
+        __m128i b = _mm_loadu_si128((const __m128i *)(bins + 2*k));
+        _mm_storeu_si128((__m128i *)(out + k), _mm_madd_epi16(b, b));
+    }
+    if (k < n) Ref::power(bins + 2*k, out + k, n - k);
+}
+
+void melEnergies(const int32_t *power, const MelFilter *filters, const uint16_t *weights, uint64_t *out, int count) {
+    for (int f=0; f<count; ++f) {
+        const MelFilter &mf = filters[f];
+        const int32_t *p = power + mf.firstBin;
+        const uint16_t *w = weights + mf.weightOffset;
+        int i = 0;
+        uint64_t acc = 0;
+#ifdef __AVX2__
+        __m256i sum = _mm256_setzero_si256();
+        for (; i+8<=mf.bins; i+=8) {
+            __m256i pv = _mm256_loadu_si256((const __m256i *)(p + i));
+            __m256i wv = _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(w + i)));
+            // 32x32->64 products of the even lanes, then of the odd ones
+            sum = _mm256_add_epi64(sum, _mm256_mul_epu32(pv, wv));
+            sum = _mm256_add_epi64(sum, _mm256_mul_epu32(_mm256_srli_epi64(pv, 32), _mm256_srli_epi64(wv, 32)));
+        }
+        __m128i s = _mm_add_epi64(_mm256_castsi256_si128(sum), _mm256_extracti128_si256(sum, 1));
+#else
+        __m128i s = _mm_setzero_si128();
+        for (; i+4<=mf.bins; i+=4) {
+            __m128i pv = _mm_loadu_si128((const __m128i *)(p + i));
+            __m128i wv = _mm_cvtepu16_epi32(_mm_loadl_epi64((const __m128i *)(w + i)));
+            s = _mm_add_epi64(s, _mm_mul_epu32(pv, wv));
+            s = _mm_add_epi64(s, _mm_mul_epu32(_mm_srli_epi64(pv, 32), _mm_srli_epi64(wv, 32)));
+        }
+#endif
+        acc = (uint64_t)_mm_cvtsi128_si64(s) + (uint64_t)_mm_extract_epi64(s, 1);
+        for (; i<mf.bins; ++i) acc += (uint64_t)(uint32_t)p[i] * w[i];
+        out[f] = acc;
+    }
+}
+
+void matVec(const int16_t *m, const int16_t *x, int16_t *out, int rows, int stride) {
+    for (int r=0; r<rows; ++r) {
+        const int16_t *row = m + r*stride;
+#ifdef __AVX2__
+        __m256i acc = _mm256_setzero_si256();
+        for (int j=0; j<stride; j+=16)
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(_mm256_loadu_si256((const __m256i *)(row + j)),
+                                                          _mm256_loadu_si256((const __m256i *)(x + j))));
+        __m128i s = _mm_add_epi32(_mm256_castsi256_si128(acc), _mm256_extracti128_si256(acc, 1));
+#else
+        __m128i s = _mm_setzero_si128();
+        for (int j=0; j<stride; j+=8)
+            s = _mm_add_epi32(s, _mm_madd_epi16(_mm_loadu_si128((const __m128i *)(row + j)),
+                                                _mm_loadu_si128((const __m128i *)(x + j))));
+#endif
+        s = _mm_hadd_epi32(s, s);
+        s = _mm_hadd_epi32(s, s);
+        // >> 15 and saturate, as packs does for the int32 -> int16 step
+        out[r] = (int16_t)_mm_extract_epi16(_mm_packs_epi32(_mm_srai_epi32(s, 15), s), 0);
+    }
+}
+
+#elif defined(CONFIG_IDF_TARGET_ESP32S3)
+
+// The ESP-DSP library's aes3 variants use the S3's PIE vector instructions.
+// Its FFT and multiply round differently from Ref, so target output can
+// differ from the host in the last bit; the shape of the pipeline is the same.
+const char *backend() { return "esp-dsp"; }
+
+void window(const int16_t *x, const int16_t *w, int16_t *out, int n) {
+    dsps_mul_s16(x, w, out, n, 1, 1, 1, 15);
+}
+
+int peakAbs(const int16_t *x, int n) { return Ref::peakAbs(x, n); }
+void shiftLeft(int16_t *x, int n, int shift) { Ref::shiftLeft(x, n, shift); }
+
+void fft(int16_t *z, int n, const Twiddle *) {
+    static bool ready = dsps_fft2r_init_sc16(nullptr, CONFIG_DSP_MAX_FFT_SIZE) == ESP_OK;
+    if (!ready) return;
+    // scales by 1/2 per stage like Ref, but leaves the output bit reversed
+    dsps_fft2r_sc16(z, n);
+    dsps_bit_rev_sc16_ansi(z, n);
+}
+
+void power(const int16_t *bins, int32_t *out, int n) { Ref::power(bins, out, n); }
+
+void melEnergies(const int32_t *power, const MelFilter *filters, const uint16_t *weights, uint64_t *out, int count) {
+    Ref::melEnergies(power, filters, weights, out, count);
+}
+
+void matVec(const int16_t *m, const int16_t *x, int16_t *out, int rows, int stride) {
+    for (int r=0; r<rows; ++r) dsps_dotprod_s16(m + r*stride, x, out + r, stride, 0); // >> 15
+}
+
+#else
+
+const char *backend() { return "scalar"; }
+void window(const int16_t *x, const int16_t *w, int16_t *out, int n) { Ref::window(x, w, out, n); }
+int peakAbs(const int16_t *x, int n) { return Ref::peakAbs(x, n); }
+void shiftLeft(int16_t *x, int n, int shift) { Ref::shiftLeft(x, n, shift); }
+void fft(int16_t *z, int n, const Twiddle *tw) { Ref::fft(z, n, tw); }
+void power(const int16_t *bins, int32_t *out, int n) { Ref::power(bins, out, n); }
+void melEnergies(const int32_t *power, const MelFilter *filters, const uint16_t *weights, uint64_t *out, int count) {
+    Ref::melEnergies(power, filters, weights, out, count);
+}
+void matVec(const int16_t *m, const int16_t *x, int16_t *out, int rows, int stride) { Ref::matVec(m, x, out, rows, stride); }
+
+#endif
+
+} // namespace Dsp
+} // namespace Audio
@@ -0,0 +1,62 @@
+#pragma once
+#include <cstdint>
+
+namespace Audio {
+namespace Dsp {
+
+// log2(x) in Q8, with the fraction taken linearly from the bits below the MSB
+inline int log2Q8(uint64_t x) {
+    if (!x) return 0;
+    int msb = 63 - __builtin_clzll(x);
+    uint64_t frac = msb >= 8 ? x >> (msb - 8) : x << (8 - msb);
+    return (msb << 8) | (int)(frac & 0xff);
+}
+
+// FFT twiddles for one radix-2 stage of half-size h start at index h - 1.
+// Each butterfly multiplies by w as two dot products on the interleaved
+// (re, im) pair: re = (re, im) . rot[0..1], im = (re, im) . rot[2..3].
+struct Twiddle { int16_t rot[4]; }; // wr, -wi, wi, wr (Q15)
+
+// Triangular filter over a contiguous run of bins.
+struct MelFilter {
+    uint16_t firstBin;
+    uint16_t bins;
+    uint32_t weightOffset; // into the shared Q15 weight array
+};
+
+// Fixed-point kernels of the feature front end. Ref holds the scalar
+// reference; the versions directly in Dsp are the fastest for the build
+// (AVX2/SSE4.1 on the host, the ESP32-S3 DSP library on target) and match Ref
+// bit for bit on the host.
+namespace Ref {
+// out = round(x * w >> 15)
+void window(const int16_t *x, const int16_t *w, int16_t *out, int n);
+// largest |x|
+int peakAbs(const int16_t *x, int n);
+// x <<= shift in place; the caller guarantees no overflow
+void shiftLeft(int16_t *x, int n, int shift);
+// in-place complex FFT of n interleaved Q15 points, natural order in and out,
+// halved every stage so the result is the DFT / n
+void fft(int16_t *z, int n, const Twiddle *tw);
+// out[k] = re^2 + im^2 of n interleaved complex bins
+void power(const int16_t *bins, int32_t *out, int n);
+// out[f] = sum of power * Q15 weight over each filter's bins
+void melEnergies(const int32_t *power, const MelFilter *filters, const uint16_t *weights, uint64_t *out, int count);
+// out[i] = sum_j m[i][j] * x[j] >> 15, saturated; rows are stride apart,
+// stride and the zero-padded x a multiple of 16
+void matVec(const int16_t *m, const int16_t *x, int16_t *out, int rows, int stride);
+} // namespace Ref
+
+void window(const int16_t *x, const int16_t *w, int16_t *out, int n);
+int peakAbs(const int16_t *x, int n);
+void shiftLeft(int16_t *x, int n, int shift);
+void fft(int16_t *z, int n, const Twiddle *tw);
+void power(const int16_t *bins, int32_t *out, int n);
+void melEnergies(const int32_t *power, const MelFilter *filters, const uint16_t *weights, uint64_t *out, int count);
+void matVec(const int16_t *m, const int16_t *x, int16_t *out, int rows, int stride);
+
+// name of the build's kernel set, for benchmark output
+const char *backend();
+
+} // namespace Dsp
+} // namespace Audio
@@ -0,0 +1,79 @@
+#include "dsp_kernels.h"
+#include <cstdlib>
+#include <utility>
+
+namespace Audio {
+namespace Dsp {
+namespace Ref {
+
+static int16_t sat16(int32_t v) { return (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v); }
+
+void window(const int16_t *x, const int16_t *w, int16_t *out, int n) {
+    for (int i=0; i<n; ++i) out[i] = sat16((x[i] * w[i] + (1 << 14)) >> 15);
+}
+
+int peakAbs(const int16_t *x, int n) {
+    int peak = 0;
+    for (int i=0; i<n; ++i) { int a = std::abs((int)x[i]); if (a > peak) peak = a; }
+    return peak;
+}
+
+void shiftLeft(int16_t *x, int n, int shift) {
+    for (int i=0; i<n; ++i) x[i] = (int16_t)(x[i] * (1 << shift));
+}
+
+static void bitReverse(int16_t *z, int n) {
+    for (int i=1, j=0; i<n; ++i) {
+        int bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) { std::swap(z[2*i], z[2*j]); std::swap(z[2*i+1], z[2*j+1]); }
+    }
+}
+
+void fft(int16_t *z, int n, const Twiddle *tw) {
+    bitReverse(z, n);
+    for (int half=1; half<n; half*=2) {
+        const Twiddle *stage = tw + half - 1;
+        for (int base=0; base<n; base+=2*half) {
+            for (int j=0; j<half; ++j) {
+                int16_t *u = z + 2*(base + j), *a = u + 2*half;
+                const int16_t *r = stage[j].rot;
+                // t = a * w / 2, rounded; u / 2; the halving keeps every stage in range
+                int32_t tr = (a[0]*r[0] + a[1]*r[1] + (1 << 15)) >> 16;
+                int32_t ti = (a[0]*r[2] + a[1]*r[3] + (1 << 15)) >> 16;
+                int32_t ur = u[0] >> 1, ui = u[1] >> 1;
+                u[0] = sat16(ur + tr); u[1] = sat16(ui + ti);
+                a[0] = sat16(ur - tr); a[1] = sat16(ui - ti);
+            }
+        }
+    }
+}
+
+void power(const int16_t *bins, int32_t *out, int n) {
+    for (int k=0; k<n; ++k) out[k] = bins[2*k]*bins[2*k] + bins[2*k+1]*bins[2*k+1];
+}
+
+void melEnergies(const int32_t *power, const MelFilter *filters, const uint16_t *weights, uint64_t *out, int count) {
+    for (int f=0; f<count; ++f) {
+        const MelFilter &mf = filters[f];
+        const int32_t *p = power + mf.firstBin;
+        const uint16_t *w = weights + mf.weightOffset;
+        uint64_t acc = 0;
+        for (int i=0; i<mf.bins; ++i) acc += (uint64_t)(uint32_t)p[i] * w[i];
+        out[f] = acc;
+    }
+}
+
+void matVec(const int16_t *m, const int16_t *x, int16_t *out, int rows, int stride) {
+    for (int i=0; i<rows; ++i) {
+        const int16_t *row = m + i*stride;
+        int32_t acc = 0;
+        for (int j=0; j<stride; ++j) acc += row[j] * x[j];
+        out[i] = sat16(acc >> 15);
+    }
+}
+
+} // namespace Ref
+} // namespace Dsp
+} // namespace Audio
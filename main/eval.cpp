@@ -0,0 +1,26 @@
+#include "eval.h"
+#include <algorithm>
+
+namespace Chess {
+
+// p is MaxPhase with all minor and major pieces on the board, 0 with none
+static int taper(const Board &b, Psqt::Score s, int p) {
+    p = std::min(p, Psqt::MaxPhase); // early promotions can push it past the opening total
+    int score = (s.mg * p + s.eg * (Psqt::MaxPhase - p)) / Psqt::MaxPhase;
+    return b.sideToMove==Color::White ? score : -score;
+}
+
+int evaluate(const Board &b) {
+    int p = 0;
+    for (int t=(int)PieceType::Knight; t<=(int)PieceType::Queen; ++t)
+        p += Psqt::PhaseWeight[t] * (b.pieceCount[0][t] + b.pieceCount[1][t]);
+    return taper(b, b.psq, p);
+}
+
+int evaluateFull(const Board &b) {
+    int p = 0;
+    for (const Piece &pc : b.squares) p += Psqt::PhaseWeight[(int)pc.type];
+    return taper(b, b.computePsq(), p);
+}
+
+} // namespace Chess
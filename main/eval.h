@@ -0,0 +1,17 @@
+#pragma once
+#include "board.h"
+
+namespace Chess {
+
+constexpr int PieceValue[7] = {0, 100, 320, 330, 500, 900, 0}; // by PieceType, centipawns, for move ordering
+
+// Static evaluation in centipawns from the side to move's point of view:
+// material and piece-square bonuses (Board::psq, kept up to date by
+// makeMove/undoMove), tapered from midgame to endgame by the material left.
+// O(1) per call.
+int evaluate(const Board &b);
+
+// the same score recomputed from every square, to verify the incremental one
+int evaluateFull(const Board &b);
+
+} // namespace Chess
@@ -0,0 +1,152 @@
+#include "feature_extractor.h"
+#include <cmath>
+#include <cstring>
+
+namespace Audio {
+
+namespace FeatureTables {
+
+int16_t hamming[WindowSamples];
+Dsp::Twiddle fftTwiddles[FftSize / 2 - 1];
+int16_t splitTwiddles[SpectrumBins][2];
+Dsp::MelFilter melFilters[MelBands];
+uint16_t melWeights[2 * SpectrumBins]; // each bin is in at most two filters
+int16_t dct[CepstralCoeffs][DctStride];
+
+// symmetric Q15: -1.0 maps to -32767 so a twiddle can always be negated
+static int16_t q15(double v) {
+    long r = std::lround(v * 32768.0);
+    return (int16_t)(r > 32767 ? 32767 : r < -32767 ? -32767 : r);
+}
+
+static double hzToMel(double hz) { return 2595.0 * std::log10(1.0 + hz / 700.0); }
+static double melToHz(double mel) { return 700.0 * (std::pow(10.0, mel / 2595.0) - 1.0); }
+
+// Floating point only here, once; everything per frame is integer.
+static bool build() {
+    for (int i=0; i<WindowSamples; ++i) hamming[i] = q15(0.54 - 0.46 * std::cos(2 * M_PI * i / (WindowSamples - 1)));
+
+    const int points = FftSize / 2;
+    for (int half=1; half<points; half*=2) {
+        for (int j=0; j<half; ++j) {
+            double a = -M_PI * j / half;
+            int16_t wr = q15(std::cos(a)), wi = q15(std::sin(a));
+            Dsp::Twiddle &t = fftTwiddles[half - 1 + j];
+            t.rot[0] = wr; t.rot[1] = (int16_t)-wi; t.rot[2] = wi; t.rot[3] = wr;
+        }
+    }
+    for (int k=0; k<SpectrumBins; ++k) {
+        double a = 2 * M_PI * k / FftSize;
+        splitTwiddles[k][0] = q15(std::cos(a));
+        splitTwiddles[k][1] = q15(-std::sin(a));
+    }
+
+    // HTK-style triangles between 20 Hz and Nyquist, equally spaced in mel
+    double lo = hzToMel(20), hi = hzToMel(SampleRate / 2);
+    double edges[MelBands + 2];
+    for (int i=0; i<MelBands+2; ++i) edges[i] = melToHz(lo + (hi - lo) * i / (MelBands + 1)) * FftSize / SampleRate;
+    uint32_t offset = 0;
+    for (int f=0; f<MelBands; ++f) {
+        int first = (int)std::ceil(edges[f]), last = (int)std::floor(edges[f + 2]);
+        if (last >= SpectrumBins) last = SpectrumBins - 1;
+        melFilters[f].firstBin = (uint16_t)first;
+        melFilters[f].weightOffset = offset;
+        int n = 0;
+        for (int k=first; k<=last; ++k) {
+            double w = k <= edges[f + 1] ? (k - edges[f]) / (edges[f + 1] - edges[f])
+                                         : (edges[f + 2] - k) / (edges[f + 2] - edges[f + 1]);
+            melWeights[offset + n++] = (uint16_t)q15(w < 0 ? 0 : w > 0.99997 ? 0.99997 : w);
+        }
+        melFilters[f].bins = (uint16_t)n;
+        offset += n;
+    }
+
+    std::memset(dct, 0, sizeof(dct));
+    for (int i=0; i<CepstralCoeffs; ++i) {
+        double scale = std::sqrt((i == 0 ? 1.0 : 2.0) / MelBands);
+        for (int j=0; j<MelBands; ++j) dct[i][j] = q15(scale * std::cos(M_PI * i * (j + 0.5) / MelBands));
+    }
+    return true;
+}
+
+void init() {
+    static const bool done = build(); // thread-safe one-time init
+    (void)done;
+}
+
+} // namespace FeatureTables
+
+using namespace FeatureTables;
+
+void realSpectrum(const int16_t *z, int16_t *bins) {
+    const int points = FftSize / 2;
+    for (int k=0; k<SpectrumBins; ++k) {
+        // Z[k] and conj(Z[N-k]) separate the even and odd samples' spectra
+        const int16_t *a = z + 2 * (k % points), *b = z + 2 * ((points - k) % points);
+        int32_t er = a[0] + b[0], ei = a[1] - b[1];  // 2 * even
+        int32_t or_ = a[1] + b[1], oi = b[0] - a[0]; // 2 * odd
+        int64_t wr = splitTwiddles[k][0], wi = splitTwiddles[k][1];
+        int32_t tr = (int32_t)((wr * or_ - wi * oi + (1 << 14)) >> 15);
+        int32_t ti = (int32_t)((wr * oi + wi * or_ + (1 << 14)) >> 15);
+        // 2 * X[k], brought to the 1/FftSize scale
+        bins[2*k] = (int16_t)((er + tr + 2) >> 2);
+        bins[2*k+1] = (int16_t)((ei + ti + 2) >> 2);
+    }
+}
+
+FeatureExtractor::FeatureExtractor() {
+    FeatureTables::init();
+    reset();
+}
+
+void FeatureExtractor::reset() {
+    filled = 0;
+    lastSample = 0;
+}
+
+bool FeatureExtractor::push(const Frame &f, Features &out) {
+    // slide the window one frame and append the pre-emphasized frame (x[n] - 0.97 x[n-1])
+    std::memmove(history, history + FrameSamples, (WindowSamples - FrameSamples) * sizeof(int16_t));
+    int16_t *dst = history + WindowSamples - FrameSamples;
+    for (int i=0; i<FrameSamples; ++i) {
+        int32_t v = f.samples[i] - ((31785 * lastSample + (1 << 14)) >> 15);
+        dst[i] = (int16_t)(v > 32767 ? 32767 : v < -32768 ? -32768 : v);
+        lastSample = f.samples[i];
+    }
+    if (filled < WindowSamples) filled += FrameSamples;
+    if (filled < WindowSamples) return false;
+    compute(history, out);
+    return true;
+}
+
+void FeatureExtractor::compute(const int16_t *window, Features &out) {
+    alignas(32) int16_t buf[FftSize];
+    alignas(32) int16_t bins[2 * SpectrumBins];
+    alignas(32) int32_t power[SpectrumBins];
+    alignas(32) int16_t logMel[DctStride] = {};
+    uint64_t mel[MelBands];
+
+    Dsp::window(window, hamming, buf, WindowSamples);
+    std::memset(buf + WindowSamples, 0, (FftSize - WindowSamples) * sizeof(int16_t));
+    // block floating point: bring the peak to [2^13, 2^14) so quiet frames keep
+    // their precision and the FFT's complex points stay below full scale
+    int peak = Dsp::peakAbs(buf, WindowSamples), shift = 0;
+    if (peak) while ((peak << (shift + 1)) < (1 << 14)) ++shift;
+    if (shift) Dsp::shiftLeft(buf, WindowSamples, shift);
+
+    Dsp::fft(buf, FftSize / 2, fftTwiddles); // even/odd samples as re/im of 256 points
+    realSpectrum(buf, bins);
+    Dsp::power(bins, power, SpectrumBins);
+    Dsp::melEnergies(power, melFilters, melWeights, mel, MelBands);
+
+    // undo the scalings: 1/FftSize on amplitude is 2*9 octaves of power, the
+    // weights are Q15, and the normalization added 2*shift octaves
+    const int offsetQ8 = (2 * 9 - 15 - 2 * shift) * 256;
+    for (int i=0; i<MelBands; ++i) {
+        int v = mel[i] ? (Dsp::log2Q8(mel[i]) + offsetQ8) * LogScale / 256 : 0;
+        out.logMel[i] = logMel[i] = (int16_t)(v < 0 ? 0 : v);
+    }
+    Dsp::matVec(&dct[0][0], logMel, out.mfcc, CepstralCoeffs, DctStride);
+}
+
+} // namespace Audio
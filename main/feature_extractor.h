@@ -0,0 +1,52 @@
+#pragma once
+#include "audio_capture.h"
+#include "dsp_kernels.h"
+
+namespace Audio {
+
+constexpr int WindowSamples = 400; // 25 ms analysis window, advanced one 10 ms frame at a time
+constexpr int FftSize = 512;       // real FFT, computed as a 256-point complex one
+constexpr int SpectrumBins = FftSize / 2 + 1;
+constexpr int MelBands = 40;
+constexpr int CepstralCoeffs = 13;
+constexpr int LogScale = 64;       // log-mel units per octave of energy (~3 dB)
+
+struct Features {
+    int16_t logMel[MelBands];       // log2 energy * LogScale, 0 = silence
+    int16_t mfcc[CepstralCoeffs];   // orthonormal DCT-II of logMel, same scale
+};
+
+// Streaming log-mel/MFCC front end, fixed point throughout: pre-emphasis,
+// Hamming window, block-normalized real FFT, power, mel filterbank, log2 and
+// DCT. Consumes the capture frames directly. Tables are shared and built once.
+class FeatureExtractor {
+public:
+    FeatureExtractor();
+    void reset();
+    // returns true once a full window has been seen, with out filled
+    bool push(const Frame &f, Features &out);
+    // one window of WindowSamples pre-emphasized samples to features; bench entry point
+    static void compute(const int16_t *window, Features &out);
+
+private:
+    int16_t history[WindowSamples];
+    int filled;
+    int16_t lastSample; // pre-emphasis state
+};
+
+namespace FeatureTables {
+void init();
+extern int16_t hamming[WindowSamples];
+extern Dsp::Twiddle fftTwiddles[FftSize / 2 - 1];
+extern int16_t splitTwiddles[SpectrumBins][2]; // cos, -sin of 2*pi*k/FftSize
+extern Dsp::MelFilter melFilters[MelBands];
+extern uint16_t melWeights[2 * SpectrumBins];
+constexpr int DctStride = 48; // MelBands padded for the vector kernels
+extern int16_t dct[CepstralCoeffs][DctStride];
+} // namespace FeatureTables
+
+// the real-FFT split after the complex FFT: FftSize/2 interleaved points to
+// SpectrumBins interleaved bins, both scaled by 1/FftSize overall
+void realSpectrum(const int16_t *z, int16_t *bins);
+
+} // namespace Audio
@@ -1,52 +1,174 @@
 #include "game.h"
 #include <cstdio>
+#include <cstring>
 
 namespace Chess {
 
-Game::Game() { newGame(); }
+// snapshot framing: magic, version, packed start position, move count (u16
+// little endian), then the move indices. Indices depend on the order
+// generateLegal emits moves in, so a change to that order needs a new version.
+static constexpr uint8_t SnapshotMagic[2] = {'W', 'C'};
+static constexpr uint8_t SnapshotVersion = 1;
 
-void Game::newGame() { board.setupInitialPosition(); }
+Game::Game() {
+    std::memset(legalIndex, 0, sizeof(legalIndex));
+    moveLog.reserve(256);
+    newGame();
+}
+
+void Game::newGame() {
+    board.setupInitialPosition();
+    resetLog();
+}
+
+void Game::resetLog() {
+    invalidateLegal();
+    startPosSize = (uint8_t)board.pack(startPos);
+    moveLog.clear();
+}
+
+bool Game::loadFEN(const std::string &fen) {
+    if (!board.loadFEN(fen)) { newGame(); return false; }
+    resetLog();
+    return true;
+}
+
+std::vector<uint8_t> Game::saveSnapshot() const {
+    std::vector<uint8_t> out;
+    out.reserve(3 + startPosSize + 2 + moveLog.size());
+    out.insert(out.end(), SnapshotMagic, SnapshotMagic + 2);
+    out.push_back(SnapshotVersion);
+    out.insert(out.end(), startPos, startPos + startPosSize);
+    out.push_back((uint8_t)moveLog.size());
+    out.push_back((uint8_t)(moveLog.size() >> 8));
+    out.insert(out.end(), moveLog.begin(), moveLog.end());
+    return out;
+}
+
+bool Game::loadSnapshot(const uint8_t *data, size_t size) {
+    size_t used = 0;
+    if (size < 3 || data[0] != SnapshotMagic[0] || data[1] != SnapshotMagic[1] || data[2] != SnapshotVersion ||
+        !(used = board.unpack(data + 3, size - 3))) {
+        newGame();
+        return false;
+    }
+    resetLog();
+    size_t pos = 3 + used;
+    if (size < pos + 2) { newGame(); return false; }
+    size_t count = data[pos] | (data[pos+1] << 8);
+    pos += 2;
+    if (size != pos + count) { newGame(); return false; }
+    for (size_t i=0; i<count; ++i) {
+        const MoveList &moves = legalMoves();
+        if (data[pos+i] >= moves.size()) { newGame(); return false; }
+        playIndex(data[pos+i]);
+    }
+    return true;
+}
 
 void Game::debugPrintBoard() { board.debugPrint(); }
 
 Color Game::sideToMove() const { return board.sideToMove; }
 
-void Game::legalMoves(std::vector<Move> &out) const {
-    // non-const generateLegal depends on make/undo, so create a copy
-    Board tmp = board;
-    const_cast<Board&>(tmp).generateLegal(board.sideToMove, out); // safe: operate on copy
+void Game::invalidateLegal() {
+    spokenValid = false;
+    if (!legalValid) return;
+    // only the slots set by buildLegal are non-zero
+    for (const Move &m : legal) legalIndex[m.from()][m.to()] = 0;
+    legalValid = false;
+}
+
+void Game::buildLegal() const {
+    board.generateLegal(board.sideToMove, legal);
+    // promotions share from/to and are generated queen first; keep the first
+    for (int i=legal.size()-1; i>=0; --i) legalIndex[legal[i].from()][legal[i].to()] = (uint8_t)(i + 1);
+    resolver.rebuild(board, legal);
+    legalValid = true;
+}
+
+const MoveList &Game::legalMoves() const {
+    if (!legalValid) buildLegal();
+    return legal;
+}
+
+const Move *Game::findMove(int from, int to, PieceType promotion) const {
+    if (from<0||from>63||to<0||to>63) return nullptr;
+    if (!legalValid) buildLegal();
+    int idx = legalIndex[from][to];
+    if (!idx) return nullptr;
+    const Move *m = &legal[idx - 1];
+    if (promotion==PieceType::Empty) return m;
+    if (!m->isPromotion()) return nullptr;
+    // the (at most four) promotions for this from/to are adjacent in the list
+    for (const Move *end = legal.end(); m != end && m->from()==from && m->to()==to; ++m)
+        if (m->promotion() == promotion) return m;
+    return nullptr;
+}
+
+Resolution Game::resolveMove(const std::string &text) const {
+    if (!legalValid) buildLegal();
+    return resolver.resolve(text);
+}
+
+std::string Game::toSAN(const Move &m) {
+    if (!legalValid) buildLegal();
+    return resolver.toSAN(board, m);
+}
+
+const MoveGrammar &Game::grammar() const {
+    if (!spokenValid) {
+        spoken.rebuild(board, legalMoves());
+        spokenValid = true;
+    }
+    return spoken;
+}
+
+void Game::playIndex(int i) {
+    moveLog.push_back((uint8_t)i);
+    board.makeMove(legal[i]);
+    invalidateLegal();
+}
+
+bool Game::playMove(const Move &m) {
+    const Move *lm = findMove(m.from(), m.to(), m.promotion());
+    if (!lm) return false;
+    // apply the exact move (prefer move from legal list to get its kind)
+    playIndex((int)(lm - legal.begin()));
+    return true;
 }
 
 static int fileCharToInt(char c) { return c - 'a'; }
 static int rankCharToInt(char c) { return c - '1'; }
 
-bool Game::playMoveUCI(const std::string &uci) {
+// the move kind is left Normal; callers look the real move up in the legal list
+static bool parseUCI(const std::string &uci, Move &m) {
     if (uci.size() < 4) return false;
     int fromF = fileCharToInt(uci[0]);
     int fromR = rankCharToInt(uci[1]);
     int toF = fileCharToInt(uci[2]);
     int toR = rankCharToInt(uci[3]);
     if (fromF<0||fromF>7||toF<0||toF>7||fromR<0||fromR>7||toR<0||toR>7) return false;
-    Move m((uint8_t)(fromR*8+fromF),(uint8_t)(toR*8+toF),0,0);
+    int from = fromR*8+fromF, to = toR*8+toF;
+    m = Move(from, to);
     if (uci.size()>=5) {
         char p = uci[4];
-        // map promotions: n=1,b=2,r=3,q=4
-        if (p=='n') m.promotion = 1;
-        else if (p=='b') m.promotion = 2;
-        else if (p=='r') m.promotion = 3;
-        else m.promotion = 4;
+        PieceType promo = PieceType::Queen;
+        if (p=='n') promo = PieceType::Knight;
+        else if (p=='b') promo = PieceType::Bishop;
+        else if (p=='r') promo = PieceType::Rook;
+        m = Move(from, to, Move::Promotion, promo);
     }
-    // Get legal moves and check if matches
-    std::vector<Move> legal;
-    board.generateLegal(board.sideToMove, legal);
-    for (const Move &lm : legal) {
-        if (lm.from==m.from && lm.to==m.to && (m.promotion==0 || m.promotion==lm.promotion)) {
-            // apply the exact move (prefer move from legal list to get flags)
-            board.makeMove(lm);
-            return true;
-        }
-    }
-    return false;
+    return true;
+}
+
+bool Game::isLegalUCI(const std::string &uci) const {
+    Move m;
+    return parseUCI(uci, m) && findMove(m.from(), m.to(), m.promotion());
+}
+
+bool Game::playMoveUCI(const std::string &uci) {
+    Move m;
+    return parseUCI(uci, m) && playMove(m);
 }
 
 } // namespace Chess
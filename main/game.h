@@ -1,7 +1,9 @@
 #pragma once
 #include "board.h"
-#include <vector>
+#include "move_grammar.h"
+#include "move_resolver.h"
 #include <string>
+#include <vector>
 
 namespace Chess {
 
@@ -12,10 +14,55 @@ public:
     void debugPrintBoard();
     // play using UCI like "e2e4" or "e7e8q"
     bool playMoveUCI(const std::string &uci);
-    void legalMoves(std::vector<Move> &out) const;
+    // play a move if it is legal in the current position (flags are taken from the legal list)
+    bool playMove(const Move &m);
+    // legal moves of the current position; built on first use and kept until a move is played
+    const MoveList &legalMoves() const;
+    void legalMoves(MoveList &out) const { out = legalMoves(); }
+    // O(1) lookup in the cached legal list; promotion Empty picks the queen promotion.
+    // Returns nullptr if no such legal move exists.
+    const Move *findMove(int from, int to, PieceType promotion = PieceType::Empty) const;
+    bool isLegalUCI(const std::string &uci) const;
+    // resolve SAN ("Nbd7"), UCI or a spoken phrase ("knight to f3") against the legal moves
+    Resolution resolveMove(const std::string &text) const;
+    // SAN of a legal move in the current position, e.g. for spoken confirmation
+    std::string toSAN(const Move &m);
+    // every spoken phrase naming a legal move, for the keyword decoder; built on
+    // first use after a move and kept until the next one
+    const MoveGrammar &grammar() const;
     Color sideToMove() const;
+    const Board &position() const { return board; }
+
+    // start a game from a FEN position; on malformed input the game is reset
+    // to the initial position and false is returned
+    bool loadFEN(const std::string &fen);
+    std::string toFEN() const { return board.toFEN(); }
+    // versioned binary save of the whole game: the start position followed by
+    // one byte per move played, its index in that position's legal list. Cheap
+    // enough to write to flash or a DB blob after every move.
+    std::vector<uint8_t> saveSnapshot() const;
+    // replays a snapshot; on malformed input the game is reset and false returned
+    bool loadSnapshot(const uint8_t *data, size_t size);
+    int movesPlayed() const { return (int)moveLog.size(); }
 private:
+    void invalidateLegal();
+    void buildLegal() const;
+    // records the current position as the start of an empty move log
+    void resetLog();
+    // plays legal[i], which must be valid
+    void playIndex(int i);
+
     Board board;
+    // lazily built legal-move cache; not thread-safe, like the rest of Game
+    mutable MoveList legal;
+    mutable bool legalValid = false;
+    mutable uint8_t legalIndex[64][64]; // [from][to] -> index into legal + 1, 0 = none
+    mutable MoveResolver resolver; // indexed over legal, rebuilt with it
+    mutable MoveGrammar spoken;    // rebuilt lazily, only when asked for after the position changed
+    mutable bool spokenValid = false;
+    uint8_t startPos[Board::MaxPackedSize]; // packed position the move log starts from
+    uint8_t startPosSize = 0;
+    std::vector<uint8_t> moveLog; // legal-list index of each move played
 };
 
 } // namespace Chess
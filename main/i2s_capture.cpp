@@ -0,0 +1,93 @@
+#include "i2s_capture.h"
+
+#ifdef ESP_PLATFORM
+extern "C" {
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+}
+
+namespace Audio {
+
+static const char *TAG = "I2S_CAPTURE";
+
+constexpr int DmaBuffers = 6; // 60 ms of hardware slack before the ISR must run
+constexpr int64_t FrameUs = 1000000LL * FrameSamples / SampleRate;
+
+I2SCapture::I2SCapture(const I2SPins &p, i2s_port_t prt, int s) : pins(p), port(prt), shift(s) {}
+
+I2SCapture::~I2SCapture() { stop(); }
+
+bool I2SCapture::start() {
+    if (rx) return true;
+    resetCounters();
+    lastIsrUs = 0;
+
+    i2s_chan_config_t chanCfg = I2S_CHANNEL_DEFAULT_CONFIG(port, I2S_ROLE_MASTER);
+    chanCfg.dma_desc_num = DmaBuffers;
+    chanCfg.dma_frame_num = FrameSamples; // one DMA buffer per frame
+    if (i2s_new_channel(&chanCfg, nullptr, &rx) != ESP_OK) { rx = nullptr; return false; }
+
+    i2s_std_config_t stdCfg = {
+        .clk_cfg = I2S_STD_CLK_DEFAULT_CONFIG(SampleRate),
+        .slot_cfg = I2S_STD_PHILIPS_SLOT_DEFAULT_CONFIG(I2S_DATA_BIT_WIDTH_32BIT, I2S_SLOT_MODE_MONO),
+        .gpio_cfg = {
+            .mclk = I2S_GPIO_UNUSED,
+            .bclk = pins.bclk,
+            .ws = pins.ws,
+            .dout = I2S_GPIO_UNUSED,
+            .din = pins.din,
+            .invert_flags = {
+                .mclk_inv = false,
+                .bclk_inv = false,
+                .ws_inv = false
+            }
+        }
+    };
+    i2s_event_callbacks_t cbs = {};
+    cbs.on_recv = onReceive;
+    if (i2s_channel_init_std_mode(rx, &stdCfg) != ESP_OK ||
+        i2s_channel_register_event_callback(rx, &cbs, this) != ESP_OK ||
+        i2s_channel_enable(rx) != ESP_OK) {
+        ESP_LOGE(TAG, "I2S setup failed");
+        i2s_del_channel(rx);
+        rx = nullptr;
+        return false;
+    }
+    ESP_LOGI(TAG, "capturing %d Hz, %d-sample frames", SampleRate, FrameSamples);
+    return true;
+}
+
+void I2SCapture::stop() {
+    if (!rx) return;
+    i2s_channel_disable(rx);
+    i2s_del_channel(rx);
+    rx = nullptr;
+}
+
+// Runs in the DMA ISR once per filled buffer. The driver also queues the
+// buffer for i2s_channel_read; nobody reads it, so the driver just recycles
+// the oldest queue entry, which costs nothing.
+bool IRAM_ATTR I2SCapture::onReceive(i2s_chan_handle_t, i2s_event_data_t *event, void *ctx) {
+    I2SCapture *self = static_cast<I2SCapture *>(ctx);
+    // a late ISR means the DMA wrapped over buffers we never saw
+    int64_t now = esp_timer_get_time();
+    if (self->lastIsrUs) {
+        int64_t missed = (now - self->lastIsrUs + FrameUs / 2) / FrameUs - 1;
+        if (missed > 0) self->lostFrames((uint32_t)missed);
+    }
+    self->lastIsrUs = now;
+
+    Frame *f = self->beginFrame();
+    if (!f) return false;
+    const int32_t *slots = static_cast<const int32_t *>(event->dma_buf);
+    int n = (int)(event->size / sizeof(int32_t));
+    if (n > FrameSamples) n = FrameSamples;
+    for (int i=0; i<n; ++i) f->samples[i] = slotToPcm(slots[i], self->shift);
+    for (int i=n; i<FrameSamples; ++i) f->samples[i] = 0;
+    self->endFrame();
+    return false; // no task woken
+}
+
+} // namespace Audio
+#endif // ESP_PLATFORM
@@ -0,0 +1,39 @@
+#pragma once
+#include "audio_capture.h"
+
+#ifdef ESP_PLATFORM
+extern "C" {
+#include "driver/i2s_std.h"
+}
+
+namespace Audio {
+
+struct I2SPins {
+    gpio_num_t bclk;
+    gpio_num_t ws;
+    gpio_num_t din;
+};
+
+// I2S microphone capture. Each DMA buffer holds exactly one frame; the
+// receive ISR converts it from 32-bit slots straight into a ring slot, so
+// there is no blocking read, no intermediate buffer and no gap between reads.
+class I2SCapture : public AudioSource {
+public:
+    // shift: see slotToPcm; 14 matches the level of the original mic test
+    explicit I2SCapture(const I2SPins &pins, i2s_port_t port = I2S_NUM_0, int shift = 14);
+    ~I2SCapture() override;
+    bool start() override;
+    void stop() override;
+
+private:
+    static bool onReceive(i2s_chan_handle_t handle, i2s_event_data_t *event, void *ctx);
+
+    I2SPins pins;
+    i2s_port_t port;
+    int shift;
+    i2s_chan_handle_t rx = nullptr;
+    int64_t lastIsrUs = 0; // ISR only; detects DMA buffers that were overwritten
+};
+
+} // namespace Audio
+#endif // ESP_PLATFORM
@@ -0,0 +1,299 @@
+#include "journal.h"
+#include <algorithm>
+#include <cstring>
+
+#ifdef ESP_PLATFORM
+extern "C" {
+#include "esp_partition.h"
+}
+#endif
+
+namespace Chess {
+
+namespace {
+
+const uint8_t Magic[2] = {'W', 'J'};
+constexpr uint8_t Erased = 0xff;
+constexpr size_t MaxPayload = 31;
+
+// CRC-16/CCITT-FALSE
+uint16_t crc16(const uint8_t *p, size_t n, uint16_t crc = 0xffff) {
+    while (n--) {
+        crc ^= (uint16_t)(*p++ << 8);
+        for (int i=0; i<8; ++i) crc = (uint16_t)(crc & 0x8000 ? (crc << 1) ^ 0x1021 : crc << 1);
+    }
+    return crc;
+}
+
+void put32(uint8_t *p, uint32_t v) { for (int i=0; i<4; ++i) p[i] = (uint8_t)(v >> (8 * i)); }
+uint32_t get32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+
+bool isLegal(const Board &b, Move m) {
+    MoveList legal;
+    b.generateLegal(b.sideToMove, legal);
+    return std::find(legal.begin(), legal.end(), m) != legal.end();
+}
+
+} // namespace
+
+FileJournalStorage::FileJournalStorage(const std::string &path, uint32_t size)
+    : bytes(size / SectorSize * SectorSize) {
+    file = std::fopen(path.c_str(), "r+b");
+    if (!file) file = std::fopen(path.c_str(), "w+b");
+    if (!file) return;
+    std::fseek(file, 0, SEEK_END);
+    long have = std::ftell(file);
+    // a new or short file reads as erased flash
+    uint8_t blank[256];
+    std::memset(blank, Erased, sizeof(blank));
+    for (long at = have; at < (long)bytes; at += sizeof(blank))
+        std::fwrite(blank, 1, std::min<long>(sizeof(blank), bytes - at), file);
+    std::fflush(file);
+}
+
+FileJournalStorage::~FileJournalStorage() {
+    if (file) std::fclose(file);
+}
+
+bool FileJournalStorage::read(uint32_t offset, void *dst, size_t len) {
+    if (!file || offset + len > bytes) return false;
+    return std::fseek(file, offset, SEEK_SET) == 0 && std::fread(dst, 1, len, file) == len;
+}
+
+bool FileJournalStorage::write(uint32_t offset, const void *src, size_t len) {
+    if (!file || offset + len > bytes) return false;
+    if (std::fseek(file, offset, SEEK_SET) != 0 || std::fwrite(src, 1, len, file) != len) return false;
+    written += (uint32_t)len;
+    return std::fflush(file) == 0;
+}
+
+bool FileJournalStorage::eraseSector(uint32_t offset) {
+    uint8_t blank[SectorSize];
+    std::memset(blank, Erased, sizeof(blank));
+    if (!file || offset % SectorSize || offset >= bytes) return false;
+    if (std::fseek(file, offset, SEEK_SET) != 0 || std::fwrite(blank, 1, SectorSize, file) != SectorSize) return false;
+    ++erased;
+    return std::fflush(file) == 0;
+}
+
+#ifdef ESP_PLATFORM
+
+PartitionJournalStorage::PartitionJournalStorage(const char *label)
+    : partition(esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, label)) {}
+
+uint32_t PartitionJournalStorage::size() const {
+    return partition ? ((const esp_partition_t *)partition)->size / SectorSize * SectorSize : 0;
+}
+
+bool PartitionJournalStorage::read(uint32_t offset, void *dst, size_t len) {
+    return partition && esp_partition_read((const esp_partition_t *)partition, offset, dst, len) == ESP_OK;
+}
+
+bool PartitionJournalStorage::write(uint32_t offset, const void *src, size_t len) {
+    return partition && esp_partition_write((const esp_partition_t *)partition, offset, src, len) == ESP_OK;
+}
+
+bool PartitionJournalStorage::eraseSector(uint32_t offset) {
+    return partition && esp_partition_erase_range((const esp_partition_t *)partition, offset, SectorSize) == ESP_OK;
+}
+
+#endif
+
+Journal::Journal(JournalStorage &s, const JournalConfig &c)
+    : storage(s), cfg(c), sectors(s.size() / JournalStorage::SectorSize), counters() {}
+
+bool Journal::readRecord(uint32_t offset, Type &t, uint8_t *payload, size_t &len) {
+    uint8_t buf[1 + MaxPayload + 2];
+    if (offset + 3 > JournalStorage::SectorSize) return false;
+    uint32_t base = segment * JournalStorage::SectorSize;
+    if (!storage.read(base + offset, buf, 1) || buf[0] == Erased) return false;
+    len = buf[0] & 0x1f;
+    if (offset + 3 + len > JournalStorage::SectorSize || !storage.read(base + offset + 1, buf + 1, len + 2)) return false;
+    if (crc16(buf, 1 + len) != (uint16_t)(buf[1 + len] | (buf[2 + len] << 8))) return false;
+    t = (Type)(buf[0] >> 5);
+    std::memcpy(payload, buf + 1, len);
+    return true;
+}
+
+bool Journal::writeRecord(Type t, const uint8_t *payload, size_t len) {
+    uint8_t buf[1 + MaxPayload + 2];
+    size_t size = 3 + len;
+    if (torn || writeAt + size > JournalStorage::SectorSize) return false;
+    buf[0] = (uint8_t)(t << 5 | len);
+    std::memcpy(buf + 1, payload, len);
+    uint16_t crc = crc16(buf, 1 + len);
+    buf[1 + len] = (uint8_t)crc;
+    buf[2 + len] = (uint8_t)(crc >> 8);
+    if (!storage.write(segment * JournalStorage::SectorSize + writeAt, buf, size)) {
+        torn = true; // whatever reached the flash is unusable; roll on the next write
+        return false;
+    }
+    writeAt += (uint32_t)size;
+    ++counters.records;
+    counters.bytes += (uint32_t)size;
+    return true;
+}
+
+bool Journal::writeCheckpoint(Type t, const Board &b) {
+    uint8_t packed[Board::MaxPackedSize];
+    size_t n = b.pack(packed);
+    if (!writeRecord(t, packed, n)) return startSegment(t, b);
+    ++counters.checkpoints;
+    sinceCheckpoint = 0;
+    return true;
+}
+
+bool Journal::startSegment(Type first, const Board &b) {
+    segment = (segment + 1) % sectors;
+    ++sequence;
+    if (!storage.eraseSector(segment * JournalStorage::SectorSize)) return false;
+    uint8_t header[HeaderSize];
+    header[0] = Magic[0];
+    header[1] = Magic[1];
+    put32(header + 2, sequence);
+    uint16_t crc = crc16(header, 6);
+    header[6] = (uint8_t)crc;
+    header[7] = (uint8_t)(crc >> 8);
+    if (!storage.write(segment * JournalStorage::SectorSize, header, HeaderSize)) return false;
+    writeAt = HeaderSize;
+    torn = false;
+    ++counters.segments;
+    counters.bytes += HeaderSize;
+
+    uint8_t packed[Board::MaxPackedSize];
+    size_t n = b.pack(packed);
+    if (!writeRecord(first, packed, n)) return false;
+    ++counters.checkpoints;
+    sinceCheckpoint = 0;
+    // carry the DB's position over, or recovery would resend the whole game
+    if (!syncRestart) {
+        uint8_t p[4];
+        put32(p, syncPly);
+        return writeRecord(Sync, p, 4);
+    }
+    return true;
+}
+
+void Journal::setSyncBase(const Board &b, bool restart) {
+    syncRestart = restart;
+    syncStartSize = (uint8_t)b.pack(syncStart);
+    syncPly = plyOf(b);
+    pendingCount = 0;
+}
+
+bool Journal::recover(Board &b) {
+    if (sectors < 2) return false;
+    // newest segment first
+    uint32_t seqs[64], newest = 0;
+    bool valid[64] = {};
+    uint32_t n = std::min<uint32_t>(sectors, 64);
+    for (uint32_t s=0; s<n; ++s) {
+        uint8_t h[HeaderSize];
+        valid[s] = storage.read(s * JournalStorage::SectorSize, h, HeaderSize) && h[0] == Magic[0] &&
+                   h[1] == Magic[1] && crc16(h, 6) == (uint16_t)(h[6] | (h[7] << 8));
+        if (valid[s]) seqs[s] = get32(h + 2), newest = std::max(newest, seqs[s]);
+    }
+    while (true) {
+        int best = -1;
+        for (uint32_t s=0; s<n; ++s)
+            if (valid[s] && (best < 0 || seqs[s] > seqs[best])) best = (int)s;
+        if (best < 0) break;
+        valid[best] = false;
+        segment = (uint32_t)best;
+        sequence = newest; // a newer segment we could not use stays older than the next one
+
+        // pass 1: the last checkpoint and the DB's sync mark after the last game start
+        uint32_t at = HeaderSize, checkpointAt = 0, checkpointEnd = 0;
+        int64_t synced = -1;
+        Type t;
+        uint8_t payload[MaxPayload];
+        size_t len;
+        while (readRecord(at, t, payload, len)) {
+            if (t == Checkpoint || t == GameStart) checkpointAt = at, checkpointEnd = at + 3 + (uint32_t)len;
+            if (t == GameStart) synced = -1;
+            if (t == Sync && len == 4) synced = get32(payload);
+            at += 3 + (uint32_t)len;
+        }
+        if (!checkpointAt) continue;
+        uint8_t next = Erased;
+        torn = at + 1 <= JournalStorage::SectorSize && storage.read(segment * JournalStorage::SectorSize + at, &next, 1) &&
+               next != Erased;
+        writeAt = at;
+
+        // pass 2: the checkpoint, then its moves
+        readRecord(checkpointAt, t, payload, len);
+        if (!b.unpack(payload, len)) continue;
+        sinceCheckpoint = 0;
+        // the DB holds the game up to synced: moves before it are not resent,
+        // and if it is behind the checkpoint it gets the checkpoint instead
+        setSyncBase(b, !(synced >= 0 && (uint32_t)synced >= plyOf(b)));
+        for (at = checkpointEnd; at < writeAt; at += 3 + (uint32_t)len) {
+            readRecord(at, t, payload, len);
+            if (t != MoveRecord) continue;
+            Move m = Move::fromRaw((uint16_t)(payload[0] | (payload[1] << 8)));
+            if (len != 2 || !isLegal(b, m)) {
+                // a record with a good CRC that does not fit the game: stop
+                // trusting the segment here
+                writeAt = at;
+                torn = true;
+                break;
+            }
+            b.makeMove(m);
+            ++sinceCheckpoint;
+            if (!syncRestart && pendingCount == 0 && plyOf(b) <= (uint32_t)synced) setSyncBase(b, false);
+            else if (pendingCount < MaxPending) pending[pendingCount++] = m;
+            else setSyncBase(b, true);
+        }
+        plyNow = plyOf(b);
+        return true;
+    }
+    // nothing usable: a fresh journal
+    b.setupInitialPosition();
+    segment = sectors - 1;
+    sequence = newest; // stale headers, if any, must stay older
+    newGame(b);
+    return false;
+}
+
+bool Journal::newGame(const Board &start) {
+    setSyncBase(start, true);
+    plyNow = plyOf(start);
+    return startSegment(GameStart, start);
+}
+
+bool Journal::append(Move m, const Board &after) {
+    if (pendingCount < MaxPending) pending[pendingCount++] = m;
+    else setSyncBase(after, true);
+    plyNow = plyOf(after);
+    uint8_t p[2] = {(uint8_t)m.raw(), (uint8_t)(m.raw() >> 8)};
+    // out of room, or after a torn write: the new segment's checkpoint holds the move
+    if (!writeRecord(MoveRecord, p, 2)) return startSegment(Checkpoint, after);
+    if (++sinceCheckpoint >= cfg.checkpointEvery) return writeCheckpoint(Checkpoint, after);
+    return true;
+}
+
+bool Journal::nextBatch(SyncBatch &batch) const {
+    if (!syncRestart && pendingCount == 0) return false;
+    batch.restart = syncRestart;
+    std::memcpy(batch.start, syncStart, syncStartSize);
+    batch.startSize = syncStartSize;
+    batch.firstPly = syncPly;
+    batch.count = std::min(pendingCount, SyncBatch::MaxMoves);
+    std::copy(pending, pending + batch.count, batch.moves);
+    return true;
+}
+
+bool Journal::markSynced(const SyncBatch &batch) {
+    if (batch.firstPly != syncPly || batch.restart != syncRestart || batch.count > pendingCount) return false;
+    std::copy(pending + batch.count, pending + pendingCount, pending);
+    pendingCount -= batch.count;
+    syncPly += (uint32_t)batch.count;
+    syncRestart = false;
+    uint8_t p[4];
+    put32(p, syncPly);
+    // with no room the mark waits for the next segment, which starts with it
+    writeRecord(Sync, p, 4);
+    return true;
+}
+
+} // namespace Chess
@@ -0,0 +1,154 @@
+#pragma once
+#include "board.h"
+#include <cstdint>
+#include <cstdio>
+#include <string>
+
+// Append-only game journal for flash: a few bytes per move instead of
+// rewriting the whole game state, and a power cut loses at most the record
+// being written.
+//
+// Storage is split into 4 KB sectors, each holding one segment:
+//
+//   header   magic "WJ", u32 sequence number, CRC-16
+//   records  tag (type << 5 | payload length), payload, CRC-16 of both
+//
+// Records are a position checkpoint (Board::pack, 14 to 30 bytes), a move
+// (Move::raw, 2 bytes) or a DB sync mark (the ply synced up to). Every
+// segment starts with a checkpoint, so older segments can be erased when the
+// ring comes back round to them. Recovery takes the newest segment with a
+// valid checkpoint, finds the last checkpoint in it and replays the moves
+// after it through Board::makeMove, stopping at the first erased byte or bad
+// CRC. A torn tail cannot be rewritten in place on flash, so the next write
+// after one starts a fresh segment.
+namespace Chess {
+
+// Flash-like backing store: erased bytes read 0xff and are written once.
+class JournalStorage {
+public:
+    static constexpr uint32_t SectorSize = 4096;
+    virtual ~JournalStorage() = default;
+    virtual uint32_t size() const = 0; // a multiple of SectorSize, at least two sectors
+    virtual bool read(uint32_t offset, void *dst, size_t len) = 0;
+    virtual bool write(uint32_t offset, const void *src, size_t len) = 0;
+    virtual bool eraseSector(uint32_t offset) = 0;
+};
+
+// A plain file standing in for the partition, created erased if missing.
+class FileJournalStorage : public JournalStorage {
+public:
+    FileJournalStorage(const std::string &path, uint32_t size);
+    ~FileJournalStorage() override;
+    bool ok() const { return file != nullptr; }
+    uint32_t size() const override { return bytes; }
+    bool read(uint32_t offset, void *dst, size_t len) override;
+    bool write(uint32_t offset, const void *src, size_t len) override;
+    bool eraseSector(uint32_t offset) override;
+    uint32_t bytesWritten() const { return written; }
+    uint32_t sectorsErased() const { return erased; }
+
+private:
+    FILE *file = nullptr;
+    uint32_t bytes;
+    uint32_t written = 0, erased = 0;
+};
+
+#ifdef ESP_PLATFORM
+// A data partition found by label (see partitions.csv).
+class PartitionJournalStorage : public JournalStorage {
+public:
+    explicit PartitionJournalStorage(const char *label);
+    bool ok() const { return partition != nullptr; }
+    uint32_t size() const override;
+    bool read(uint32_t offset, void *dst, size_t len) override;
+    bool write(uint32_t offset, const void *src, size_t len) override;
+    bool eraseSector(uint32_t offset) override;
+
+private:
+    const void *partition; // esp_partition_t, kept out of this header
+};
+#endif
+
+struct JournalConfig {
+    uint16_t checkpointEvery = 64; // moves between checkpoints, bounding replay on recovery
+};
+
+struct JournalStats {
+    uint32_t records;
+    uint32_t bytes;      // written to storage, headers included
+    uint32_t checkpoints;
+    uint32_t segments;   // started, each costing a sector erase
+};
+
+// Moves not yet stored in the DB. restart asks the DB to replace its copy of
+// the game with start first: a new game, or sync fell so far behind that the
+// moves in between are only in a checkpoint now. A batch can be sent again
+// after a power cut, so the DB should ignore moves below the ply it holds.
+struct SyncBatch {
+    static constexpr int MaxMoves = 64;
+    bool restart;
+    uint8_t start[Board::MaxPackedSize];
+    uint8_t startSize;
+    uint32_t firstPly; // ply of the first move, counted as Board::fullmoveNumber does
+    int count;
+    Move moves[MaxMoves];
+};
+
+// Single writer. Call recover() once before anything else.
+class Journal {
+public:
+    explicit Journal(JournalStorage &storage, const JournalConfig &cfg = JournalConfig());
+
+    // rebuild the last journalled position into b; false (with b set to the
+    // initial position and a new game begun) if nothing valid was found
+    bool recover(Board &b);
+    // begin a new game from start
+    bool newGame(const Board &start);
+    // record m, already played; after is the position it led to
+    bool append(Move m, const Board &after);
+
+    // the oldest moves the DB has not acknowledged, up to MaxMoves; false if none
+    bool nextBatch(SyncBatch &batch) const;
+    // the DB stored batch; a sync mark is journalled so recovery does not resend it
+    bool markSynced(const SyncBatch &batch);
+
+    uint32_t ply() const { return plyNow; }
+    JournalStats stats() const { return counters; }
+
+    static uint32_t plyOf(const Board &b) {
+        return 2u * (b.fullmoveNumber ? b.fullmoveNumber - 1u : 0u) + (b.sideToMove == Color::Black);
+    }
+
+private:
+    enum Type : uint8_t { Checkpoint = 1, GameStart = 2, MoveRecord = 3, Sync = 4 };
+    static constexpr uint32_t HeaderSize = 8;
+    static constexpr int MaxPending = 256;
+
+    bool startSegment(Type first, const Board &b);
+    bool writeRecord(Type t, const uint8_t *payload, size_t len);
+    bool writeCheckpoint(Type t, const Board &b);
+    // next record at offset within the current segment; false at the end
+    bool readRecord(uint32_t offset, Type &t, uint8_t *payload, size_t &len);
+    void setSyncBase(const Board &b, bool restart);
+
+    JournalStorage &storage;
+    JournalConfig cfg;
+    uint32_t sectors;
+    uint32_t segment = 0;   // sector of the segment being written
+    uint32_t sequence = 0;
+    uint32_t writeAt = 0;   // offset within the segment
+    bool torn = false;      // bytes past writeAt are not erased
+    uint16_t sinceCheckpoint = 0;
+    uint32_t plyNow = 0;
+    JournalStats counters;
+
+    // unsynced moves, from the position in syncStart
+    bool syncRestart = false;
+    uint8_t syncStart[Board::MaxPackedSize];
+    uint8_t syncStartSize = 0;
+    uint32_t syncPly = 0;
+    int pendingCount = 0;
+    Move pending[MaxPending];
+};
+
+} // namespace Chess
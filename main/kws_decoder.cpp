@@ -0,0 +1,95 @@
+#include "kws_decoder.h"
+#include <algorithm>
+
+namespace Audio {
+
+using Chess::MoveGrammar;
+
+KwsDecoder::KwsDecoder(const KwsConfig &c) : cfg(c) {
+    tokens.reserve(1024);
+    live.reserve(1024);
+    active.reserve(1024);
+}
+
+void KwsDecoder::begin(const MoveGrammar &g) {
+    grammar = &g;
+    tokens.assign(g.size(), Tokens{{Dead, Dead, Dead}, Dead});
+    live.assign(g.size(), 0);
+    rootSilence = 0;
+    frameCount = peakActive = 0;
+    updates = 0;
+}
+
+void KwsDecoder::push(const int16_t *scores) {
+    if (!grammar) return;
+    const int32_t silence = scores[SilenceScore];
+    // a pruned token stays exactly Dead instead of drifting below it, so the
+    // enter == Dead test keeps skipping words below a pruned parent
+    auto step = [](int32_t from, int32_t score) { return from == Dead ? Dead : from + score; };
+    int32_t newBest = step(rootSilence, silence);
+    active.clear();
+    // children come after their parent, so walking backwards reads every
+    // parent's exit from the previous frame before it is overwritten
+    for (int n=grammar->size()-1; n>0; --n) {
+        const MoveGrammar::Node &node = grammar->node(n);
+        int32_t enter = node.parent == 0 ? rootSilence : tokens[node.parent].state[StatesPerWord-1];
+        if (!live[n] && enter == Dead) continue;
+        if (enter != Dead) enter -= cfg.wordPenalty;
+        Tokens &t = tokens[n];
+        const int16_t *s = scores + (int)node.word * StatesPerWord;
+        const int32_t exit = t.state[StatesPerWord-1];
+        for (int k=StatesPerWord-1; k>0; --k) t.state[k] = step(std::max(t.state[k], t.state[k-1]), s[k]);
+        t.state[0] = step(std::max(t.state[0], enter), s[0]);
+        if (node.moveCount) t.end = step(std::max(t.end, exit), silence);
+        for (int k=0; k<StatesPerWord; ++k) newBest = std::max(newBest, t.state[k]);
+        newBest = std::max(newBest, t.end);
+        active.push_back((uint16_t)n);
+    }
+    rootSilence = step(rootSilence, silence);
+
+    // beam: drop everything too far below this frame's best
+    const int32_t floor = newBest - cfg.beam;
+    if (rootSilence < floor) rootSilence = Dead;
+    for (uint16_t n : active) {
+        Tokens &t = tokens[n];
+        bool any = false;
+        for (int k=0; k<StatesPerWord; ++k) {
+            if (t.state[k] < floor) t.state[k] = Dead;
+            else any = true;
+        }
+        if (t.end < floor) t.end = Dead;
+        else any = true;
+        live[n] = any;
+    }
+    ++frameCount;
+    updates += active.size() * StatesPerWord;
+    int count = 0;
+    for (uint16_t n : active) count += live[n];
+    peakActive = std::max(peakActive, count);
+}
+
+int KwsDecoder::finish(KwsHypothesis *out, int max) const {
+    if (!grammar) return 0;
+    KwsHypothesis cand[Chess::MoveList::Capacity];
+    int n = 0;
+    for (int i=1; i<grammar->size(); ++i) {
+        const MoveGrammar::Node &node = grammar->node(i);
+        if (!node.moveCount || !live[i]) continue;
+        int32_t score = std::max(tokens[i].state[StatesPerWord-1], tokens[i].end);
+        if (score == Dead) continue;
+        const Chess::Move *m = grammar->moves(i);
+        for (int k=0; k<node.moveCount; ++k) {
+            int j = 0;
+            while (j < n && cand[j].move != m[k]) ++j;
+            if (j == n) cand[n++] = {m[k], score, (uint16_t)i};
+            else if (score > cand[j].score) cand[j] = {m[k], score, (uint16_t)i};
+        }
+    }
+    int count = std::min(n, max);
+    std::partial_sort(cand, cand + count, cand + n,
+                      [](const KwsHypothesis &a, const KwsHypothesis &b) { return a.score > b.score; });
+    std::copy(cand, cand + count, out);
+    return count;
+}
+
+} // namespace Audio
@@ -0,0 +1,63 @@
+#pragma once
+#include "move_grammar.h"
+#include <climits>
+#include <vector>
+
+namespace Audio {
+
+// Each word of the keyword model is a left-to-right HMM of this many states.
+// A score frame holds the model's log-likelihood for every state of every
+// word, word-major, then one for silence/filler; Q8 natural log units.
+constexpr int StatesPerWord = 3;
+constexpr int ScoreCount = Chess::SpokenWordCount * StatesPerWord + 1;
+constexpr int SilenceScore = ScoreCount - 1;
+inline int scoreIndex(Chess::SpokenWord w, int state) { return (int)w * StatesPerWord + state; }
+
+struct KwsConfig {
+    int beam = 40 * 256;        // tokens further than this below the best are dropped
+    int wordPenalty = 2 * 256;  // per word entered; favours shorter phrases on a tie
+};
+
+struct KwsHypothesis {
+    Chess::Move move;
+    int32_t score;   // total log-likelihood, Q8; only differences between hypotheses matter
+    uint16_t node;   // grammar node the phrase ended on, for MoveGrammar::phraseText
+};
+
+// Viterbi token passing over a MoveGrammar: every grammar node carries the
+// states of the word on its incoming edge, so the search space is exactly the
+// phrases of the current legal moves. Leading and trailing silence are
+// absorbed at the root and at phrase ends. Tokens outside the beam are
+// dropped and nodes with no live token cost one check per frame.
+class KwsDecoder {
+public:
+    explicit KwsDecoder(const KwsConfig &cfg = KwsConfig());
+    // starts an utterance; the grammar must outlive it and stay unchanged
+    void begin(const Chess::MoveGrammar &g);
+    // one frame of ScoreCount scores
+    void push(const int16_t *scores);
+    // n-best list of distinct moves, best first; returns the count (at most max)
+    int finish(KwsHypothesis *out, int max) const;
+
+    int frames() const { return frameCount; }
+    uint64_t stateUpdates() const { return updates; } // work done, summed over frames
+    int peakActiveNodes() const { return peakActive; }
+
+private:
+    static constexpr int32_t Dead = INT32_MIN / 4;
+    struct Tokens {
+        int32_t state[StatesPerWord];
+        int32_t end; // phrase finished, in trailing silence
+    };
+
+    KwsConfig cfg;
+    const Chess::MoveGrammar *grammar = nullptr;
+    std::vector<Tokens> tokens; // per grammar node
+    std::vector<uint8_t> live;  // per node: any token inside the beam
+    std::vector<uint16_t> active; // nodes updated this frame
+    int32_t rootSilence = Dead;
+    int frameCount = 0, peakActive = 0;
+    uint64_t updates = 0;
+};
+
+} // namespace Audio
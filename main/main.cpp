@@ -1,28 +1,193 @@
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
-#include "game.h"
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "adc_capture.h"
+#include "audio_recorder.h"
+#include "i2s_capture.h"
+#include "journal.h"
+#include "motion_planner.h"
+#include "opening_book.h"
+#include "pipeline.h"
+#include "trace.h"
+
+#define I2S_BCLK   GPIO_NUM_8
+#define I2S_LRCLK  GPIO_NUM_9
+#define I2S_DATA   GPIO_NUM_4
+
+// 1: an analog mic on GPIO4 sampled by the ADC instead of the I2S mic
+#define ANALOG_MIC 0
+
+static const char *TAG = "WIZARD";
+
+// large (rings, board, search tables); keep them off the task stacks
+#if ANALOG_MIC
+static Audio::AdcCapture mic; // ADC1 channel 3 (GPIO4)
+#else
+static Audio::I2SCapture mic({I2S_BCLK, I2S_LRCLK, I2S_DATA});
+#endif
+// engine replies from the book partition while in book (built on the host by book_builder)
+static Chess::OpeningBook book;
+// the latest 30 s of utterances, ADPCM in PSRAM, to hear what a misrecognized command sounded like
+static Audio::AudioRecorder recorder;
+static App::PipelineConfig pipelineConfig() {
+    App::PipelineConfig c;
+    c.book = &book;
+    c.recorder = &recorder;
+    return c;
+}
+// no keyword model yet: recognition runs the front end and moves are typed on the console
+static App::Pipeline pipeline(mic, nullptr, pipelineConfig());
+// the control stage's copy of the game, for planning each move from the position before it
+static Chess::Board boardMirror;
+static Motion::MotionPlanner planner;
+// every played move, appended to the journal partition so a reset resumes the game
+static Chess::PartitionJournalStorage journalFlash("journal");
+static Chess::Journal journal(journalFlash);
+
+static void logEvent(const App::EngineEvent &e) {
+    switch (e.kind) {
+    case App::EngineEvent::Kind::Played: {
+        // the gantry would start on the plan here
+        Trace::record(e.byEngine ? Trace::Point::ReplyMotionStart : Trace::Point::MotionStart, e.traceId);
+        static Motion::MotionPlan plan;
+        bool planned = planner.plan(boardMirror, e.move, plan);
+        boardMirror.makeMove(e.move);
+        if (journalFlash.ok() && !journal.append(e.move, boardMirror)) ESP_LOGW(TAG, "journal write failed");
+        if (e.byEngine) ESP_LOGI(TAG, "engine plays %s (score %d, depth %d, %u ms)", Chess::moveToUCI(e.move).c_str(),
+                                 e.score, e.depth, (unsigned)e.thinkMs);
+        else ESP_LOGI(TAG, "you play %s", Chess::moveToUCI(e.move).c_str());
+        if (!planned) ESP_LOGW(TAG, "no motion plan for %s", Chess::moveToUCI(e.move).c_str());
+        else ESP_LOGI(TAG, "motion: %d runs, %.1f s%s", plan.count, plan.seconds,
+                      plan.needsHand ? "; a piece needs moving by hand" : "");
+        break;
+    }
+    case App::EngineEvent::Kind::Rejected: ESP_LOGW(TAG, "not a legal move"); break;
+    case App::EngineEvent::Kind::GameOver:
+        // start over rather than leave the journal resuming a finished game at every reset
+        ESP_LOGI(TAG, "game over; set the pieces up again for a new game");
+        pipeline.newGame();
+        break;
+    case App::EngineEvent::Kind::NewGame:
+        boardMirror.setupInitialPosition();
+        planner.reset();
+        if (journalFlash.ok() && !journal.newGame(boardMirror)) ESP_LOGW(TAG, "journal write failed");
+        ESP_LOGI(TAG, "new game");
+        break;
+    }
+}
+
+// raw events for trace_report on the host, then the same report computed here
+static void dumpTrace() {
+    static Trace::Event events[Trace::Capacity];
+    int n = Trace::snapshot(events, Trace::Capacity);
+    Trace::dumpEvents(stdout, events, n);
+    Trace::printReport(stdout, events, n);
+}
+
+// "ADPCM <hex>" lines for host/adpcm_wav, which picks them out of a serial log
+static void dumpRecording() {
+    if (!recorder.ok()) {
+        ESP_LOGW(TAG, "no recording: no PSRAM for the recorder");
+        return;
+    }
+    static const char digits[] = "0123456789abcdef";
+    recorder.flush([](const void *data, size_t len) {
+        const uint8_t *p = static_cast<const uint8_t *>(data);
+        for (size_t off=0; off<len; off+=44) {
+            char line[6 + 2 * 44 + 1] = "ADPCM ";
+            size_t n = std::min<size_t>(44, len - off);
+            for (size_t i=0; i<n; ++i) {
+                line[6 + 2 * i] = digits[p[off + i] >> 4];
+                line[7 + 2 * i] = digits[p[off + i] & 15];
+            }
+            line[6 + 2 * n] = '\0';
+            std::puts(line);
+        }
+        return true;
+    });
+    ESP_LOGI(TAG, "recording: %u frames", (unsigned)recorder.framesHeld());
+}
+
+// into the recording partition, read back with parttool.py read_partition
+static void saveRecording() {
+    if (!recorder.ok()) {
+        ESP_LOGW(TAG, "no recording: no PSRAM for the recorder");
+        return;
+    }
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, "recording");
+    if (!part || esp_partition_erase_range(part, 0, part->size) != ESP_OK) {
+        ESP_LOGW(TAG, "no recording partition");
+        return;
+    }
+    size_t offset = 0;
+    bool ok = recorder.flush([&](const void *data, size_t len) {
+        if (offset + len > part->size || esp_partition_write(part, offset, data, len) != ESP_OK) return false;
+        offset += len;
+        return true;
+    });
+    if (ok) ESP_LOGI(TAG, "recording: %u bytes saved to flash", (unsigned)offset);
+    else ESP_LOGW(TAG, "recording truncated at %u bytes", (unsigned)offset);
+}
 
 extern "C" void app_main() {
-    // printf("Starting full-legality chess engine (embedded) on ESP32-S3\n");
-    // Chess::Game game;
-    // game.newGame();
-
-    // while (true) {
-    //     game.debugPrintBoard();
-    //     // Example: list legal moves for side to move
-    //     std::vector<Chess::Move> moves;
-    //     game.legalMoves(moves);
-    //     printf("Legal moves: %zu\n", moves.size());
-    //     // For demonstration: if any move exists, play the first one
-    //     if (!moves.empty()) {
-    //         game.playMoveUCI(Chess::moveToUCI(moves[0]));
-    //     }
-    //     vTaskDelay(2000 / portTICK_PERIOD_MS);
-    // }
+    if (!recorder.ok()) ESP_LOGW(TAG, "no PSRAM for the utterance recorder; \"record\" is off");
+    if (!book.open("book")) ESP_LOGW(TAG, "no opening book; the engine searches from move one");
+    else ESP_LOGI(TAG, "opening book: %u entries", (unsigned)book.size());
+    if (!journalFlash.ok()) ESP_LOGW(TAG, "no journal partition; the game will not survive a reset");
+    else if (journal.recover(boardMirror)) {
+        Chess::MoveList moves;
+        boardMirror.generateLegal(boardMirror.sideToMove, moves);
+        if (moves.empty()) {
+            // ended before the reset, before the new game was journalled
+            boardMirror.setupInitialPosition();
+            journal.newGame(boardMirror);
+            ESP_LOGI(TAG, "the journalled game had ended; new game");
+        } else if (pipeline.setPosition(boardMirror)) {
+            planner.resume();
+            ESP_LOGI(TAG, "resumed at ply %u: %s", (unsigned)journal.ply(), boardMirror.toFEN().c_str());
+        }
+    }
+    if (!pipeline.start()) {
+        ESP_LOGE(TAG, "pipeline failed to start");
+        return;
+    }
+    ESP_LOGI(TAG, "listening; type a move (e4, Nf3, e2e4) and press enter, \"new\" to start over, \"trace\" for latencies, \"record\" or \"record flash\" for the last utterances");
 
+    // this task is the control stage: console in, engine events out
+    char line[24];
+    int len = 0;
+    uint32_t lastStats = Util::nowMs();
     while (true) {
-        printf("Hello World from Wizards Chess!\n");
-        vTaskDelay(1000 / portTICK_PERIOD_MS); // wait 1 second
+        for (int c; (c = getchar()) != EOF; ) {
+            if (c == '\n' || c == '\r') {
+                line[len] = '\0';
+                if (!std::strcmp(line, "new")) pipeline.newGame();
+                else if (!std::strcmp(line, "trace")) dumpTrace();
+                else if (!std::strcmp(line, "record")) dumpRecording();
+                else if (!std::strcmp(line, "record flash")) saveRecording();
+                else if (len) pipeline.submitText(line);
+                len = 0;
+            } else if (len < (int)sizeof(line) - 1) {
+                line[len++] = (char)c;
+            }
+        }
+        App::EngineEvent e;
+        while (pipeline.pollEvent(e, 0)) logEvent(e);
+
+        if (Util::nowMs() - lastStats >= 5000) {
+            lastStats = Util::nowMs();
+            App::PipelineStats s = pipeline.stats();
+            ESP_LOGI(TAG, "frames %u gaps %u overruns %u/%u  speech drops %u  utterances %u  features %u  moves %u",
+                     (unsigned)s.capture.frames, (unsigned)s.captureGaps, (unsigned)s.capture.ringOverruns,
+                     (unsigned)s.capture.dmaOverruns, (unsigned)s.speech.dropped, (unsigned)s.utterances,
+                     (unsigned)s.featureFrames, (unsigned)s.movesPlayed);
+            ESP_LOGI(TAG, "stack free: capture %u  recognition %u  engine %u bytes", (unsigned)s.captureStackFree,
+                     (unsigned)s.recognitionStackFree, (unsigned)s.engineStackFree);
+        }
+        vTaskDelay(pdMS_TO_TICKS(20));
     }
 }
@@ -0,0 +1,304 @@
+#include "motion_planner.h"
+#include <algorithm>
+#include <cmath>
+
+using namespace Chess;
+
+namespace Motion {
+
+namespace {
+
+const int8_t DirX[8] = {1, 1, 0, -1, -1, -1, 0, 1};
+const int8_t DirY[8] = {0, 1, 1, 1, 0, -1, -1, -1};
+constexpr int Start = 8; // no incoming direction yet
+constexpr uint32_t Far = UINT32_MAX;
+constexpr uint16_t None = 0xFFFF;
+
+// costs in thousandths of the time a half-square takes at carrying speed
+constexpr uint32_t StraightCost = 1000, DiagonalCost = 1414;
+
+bool onBoard(Point p) { return p.x > 0 && p.x < 16 && p.y > 0 && p.y < 16; }
+int squareAt(Point p) { return (p.x >> 1) + 8 * (p.y >> 1); }
+float length(Point a, Point b) { return std::hypot((float)(a.x - b.x), (float)(a.y - b.y)); }
+
+// the squares of the rectangle with corners a and b
+Bitboard boxMask(int a, int b) {
+    int f0 = std::min(a & 7, b & 7), f1 = std::max(a & 7, b & 7);
+    int r0 = std::min(a >> 3, b >> 3), r1 = std::max(a >> 3, b >> 3);
+    Bitboard m = 0;
+    for (int r=r0; r<=r1; ++r)
+        for (int f=f0; f<=f1; ++f) m |= Bitboards::bit(f + 8 * r);
+    return m;
+}
+
+// true if a and b share a rank, file or diagonal and everything between is empty
+bool openLine(Bitboard occ, int a, int b) {
+    int df = (b & 7) - (a & 7), dr = (b >> 3) - (a >> 3);
+    if (df && dr && std::abs(df) != std::abs(dr)) return false;
+    int sf = (df > 0) - (df < 0), sr = (dr > 0) - (dr < 0), step = sf + 8 * sr;
+    for (int s = a + step; s != b; s += step)
+        if (occ & Bitboards::bit(s)) return false;
+    return true;
+}
+
+} // namespace
+
+MotionPlanner::MotionPlanner(const MotionConfig &c) : cfg(c), counters() {
+    for (CacheEntry &e : cache) e.valid = 0;
+    reset();
+}
+
+void MotionPlanner::reset() {
+    at = {0, 0};
+    for (auto &side : grave) std::fill(std::begin(side), std::end(side), PieceType::Empty);
+    graveKnown = true;
+}
+
+void MotionPlanner::resume() {
+    reset();
+    graveKnown = false;
+}
+
+float MotionPlanner::runSeconds(float len, bool magnet) const {
+    float d = len * cfg.squareMm * 0.5f, v = magnet ? cfg.carryMmPerS : cfg.travelMmPerS, a = cfg.accelMmPerS2;
+    // trapezoidal profile, or triangular when the run is too short to reach v
+    if (d >= v * v / a) return d / v + v / a;
+    return 2 * std::sqrt(d / a);
+}
+
+Point MotionPlanner::gravePoint(Color c, int slot) {
+    int8_t inner = c == Color::White ? -1 : 17, outer = c == Color::White ? -3 : 19;
+    return {(int8_t)(slot < 8 ? inner : outer), (int8_t)(2 * (slot & 7) + 1)};
+}
+
+bool MotionPlanner::graveOccupied(Point p) const {
+    if (p.y < 1 || p.y > 15) return false;
+    int side = p.x < 0 ? 0 : 1;
+    int column = (p.x == -1 || p.x == 17) ? 0 : (p.x == -3 || p.x == 19) ? 1 : -1;
+    if (column < 0) return false;
+    // after resume() any slot may hold a piece
+    return !graveKnown || grave[side][column * 8 + (p.y >> 1)] != PieceType::Empty;
+}
+
+bool MotionPlanner::addStep(MotionPlan &out, Point to, bool magnet) {
+    if (to == at) return true;
+    if (out.count == MotionPlan::MaxSteps) return false;
+    float len = length(at, to);
+    out.steps[out.count++] = {to, magnet};
+    out.seconds += runSeconds(len, magnet);
+    (magnet ? out.carryMm : out.travelMm) += len * cfg.squareMm * 0.5f;
+    at = to;
+    return true;
+}
+
+bool MotionPlanner::search(Bitboard blocked, Point from, Point to, Route &r) {
+    ++counters.searches;
+    // the rectangle of the two squares out to the lines around it
+    int x0 = std::min(from.x, to.x) - 1, x1 = std::max(from.x, to.x) + 1;
+    int y0 = std::min(from.y, to.y) - 1, y1 = std::max(from.y, to.y) + 1;
+    // each stop costs the time lost braking and accelerating again, v/a,
+    // in the same units as the steps
+    float halfMm = cfg.squareMm * 0.5f, v = cfg.carryMmPerS;
+    uint32_t stopCost = (uint32_t)(v * v / (cfg.accelMmPerS2 * halfMm) * 1000);
+
+    auto nodeOf = [](int x, int y) { return (x - MinX) + y * Width; };
+    auto free = [&](int x, int y) {
+        if (!(x & 1) || !(y & 1)) return true; // lines are always open
+        Point p{(int8_t)x, (int8_t)y};
+        if (p == from || p == to) return true;
+        if (onBoard(p)) return !(blocked & Bitboards::bit(squareAt(p)));
+        return !graveOccupied(p);
+    };
+
+    std::fill(std::begin(dist), std::end(dist), Far);
+    std::fill(std::begin(heapPos), std::end(heapPos), None);
+    int heapSize = 0;
+    auto siftUp = [&](int i) {
+        uint16_t s = heap[i];
+        while (i > 0) {
+            int parent = (i - 1) >> 1;
+            if (dist[heap[parent]] <= dist[s]) break;
+            heap[i] = heap[parent];
+            heapPos[heap[i]] = (uint16_t)i;
+            i = parent;
+        }
+        heap[i] = s;
+        heapPos[s] = (uint16_t)i;
+    };
+    auto popMin = [&]() {
+        uint16_t top = heap[0];
+        heapPos[top] = None;
+        uint16_t last = heap[--heapSize];
+        int i = 0;
+        while (heapSize) {
+            int child = 2 * i + 1;
+            if (child >= heapSize) break;
+            if (child + 1 < heapSize && dist[heap[child + 1]] < dist[heap[child]]) ++child;
+            if (dist[heap[child]] >= dist[last]) break;
+            heap[i] = heap[child];
+            heapPos[heap[i]] = (uint16_t)i;
+            i = child;
+        }
+        if (heapSize) { heap[i] = last; heapPos[last] = (uint16_t)i; }
+        return top;
+    };
+    auto relax = [&](uint16_t s, uint32_t d, uint16_t parent) {
+        if (d >= dist[s]) return;
+        dist[s] = d;
+        prev[s] = parent;
+        if (heapPos[s] == None) heap[heapSize++] = s, heapPos[s] = (uint16_t)(heapSize - 1);
+        siftUp(heapPos[s]);
+    };
+
+    uint16_t start = (uint16_t)(nodeOf(from.x, from.y) * 9 + Start);
+    int goal = nodeOf(to.x, to.y);
+    relax(start, 0, None);
+    uint16_t best = None;
+    while (heapSize) {
+        uint16_t s = popMin();
+        int node = s / 9, dir = s % 9;
+        if (node == goal) { best = s; break; }
+        int x = node % Width + MinX, y = node / Width;
+        bool aligned = (x & 1) == (y & 1); // centres and corners: diagonals allowed
+        for (int d=0; d<8; ++d) {
+            bool diagonal = d & 1;
+            if (diagonal && !aligned) continue; // would clip the corner of a square
+            int nx = x + DirX[d], ny = y + DirY[d];
+            if (nx < x0 || nx > x1 || ny < y0 || ny > y1 || !free(nx, ny)) continue;
+            uint32_t cost = diagonal ? DiagonalCost : StraightCost;
+            if (dir != Start && dir != d) cost += stopCost;
+            relax((uint16_t)(nodeOf(nx, ny) * 9 + d), dist[s] + cost, s);
+        }
+    }
+    if (best == None) return false;
+
+    // walk back, keeping the last point of each straight run
+    Point rev[MaxRoute];
+    int n = 0, runDir = -1;
+    for (uint16_t s = best; prev[s] != None; s = prev[s]) {
+        int node = s / 9, dir = s % 9;
+        if (dir != runDir) {
+            if (n == MaxRoute) return false;
+            rev[n++] = {(int8_t)(node % Width + MinX), (int8_t)(node / Width)};
+            runDir = dir;
+        }
+    }
+    r.count = (uint8_t)n;
+    for (int i=0; i<n; ++i) r.points[i] = rev[n - 1 - i];
+    return true;
+}
+
+bool MotionPlanner::route(Bitboard blocked, Point from, Point to, Route &r) {
+    if (!onBoard(from) || !onBoard(to)) return search(blocked, from, to, r);
+    int a = squareAt(from), b = squareAt(to);
+    if (openLine(blocked, a, b)) {
+        ++counters.directRoutes;
+        r.points[0] = to;
+        r.count = 1;
+        return true;
+    }
+    if (!cfg.cachePaths) return search(blocked, from, to, r);
+    uint64_t key = blocked & boxMask(a, b);
+    uint64_t h = (key ^ ((uint64_t)a << 6 | (uint64_t)b)) * 0x9E3779B97F4A7C15ULL;
+    CacheEntry &e = cache[(h >> 40) & (CacheSize - 1)];
+    if (e.valid && e.from == a && e.to == b && e.occupancy == key) {
+        ++counters.cacheHits;
+        r = e.route;
+        return true;
+    }
+    if (!search(blocked, from, to, r)) return false;
+    e.occupancy = key;
+    e.from = (uint8_t)a;
+    e.to = (uint8_t)b;
+    e.route = r;
+    e.valid = 1;
+    return true;
+}
+
+bool MotionPlanner::carry(Bitboard blocked, Point from, Point to, MotionPlan &out) {
+    Route r;
+    if (!route(blocked, from, to, r)) return false;
+    if (!addStep(out, from, false)) return false;
+    // magnet on at the start of the carry and off at the end
+    out.seconds += 2 * cfg.magnetMs / 1000.0f;
+    for (int i=0; i<r.count; ++i)
+        if (!addStep(out, r.points[i], true)) return false;
+    return true;
+}
+
+bool MotionPlanner::toGrave(Bitboard blocked, int sq, Color c, PieceType t, MotionPlan &out) {
+    Point from = squareCentre(sq);
+    int best = -1;
+    float bestLen = 0;
+    for (int slot=0; slot<GraveSlots; ++slot) {
+        if (grave[(int)c][slot] != PieceType::Empty) continue;
+        float len = length(from, gravePoint(c, slot));
+        if (best < 0 || len < bestLen) best = slot, bestLen = len;
+    }
+    if (best < 0 || !graveKnown) { out.needsHand = true; return true; }
+    if (!carry(blocked, from, gravePoint(c, best), out)) return false;
+    grave[(int)c][best] = t;
+    return true;
+}
+
+int MotionPlanner::findGrave(Color c, PieceType t, Point near) const {
+    int best = -1;
+    float bestLen = 0;
+    for (int slot=0; slot<GraveSlots; ++slot) {
+        if (grave[(int)c][slot] != t) continue;
+        float len = length(near, gravePoint(c, slot));
+        if (best < 0 || len < bestLen) best = slot, bestLen = len;
+    }
+    return best;
+}
+
+bool MotionPlanner::plan(const Board &b, Move m, MotionPlan &out) {
+    out = MotionPlan();
+    ++counters.plans;
+    Color us = b.sideToMove, them = us == Color::White ? Color::Black : Color::White;
+    int from = m.from(), to = m.to();
+    Bitboard occ = b.occupied;
+
+    // the captured piece goes first, so the target square is free
+    int victim = m.isEnPassant() ? (from & ~7) | (to & 7) : b.squares[to].type != PieceType::Empty ? to : -1;
+    if (victim >= 0) {
+        occ &= ~Bitboards::bit(victim);
+        if (!toGrave(occ, victim, them, b.squares[victim].type, out)) return false;
+    }
+    occ &= ~Bitboards::bit(from);
+
+    if (m.isCastling()) {
+        // king and rook in whichever order is quicker: the rook first slides
+        // past the king's target square while it is still empty, the king
+        // first saves travel when the head is nearer to it
+        int rank = from & ~7, rookFrom = rank + ((to & 7) == 6 ? 7 : 0), rookTo = rank + ((to & 7) == 6 ? 5 : 3);
+        Bitboard withoutRook = occ & ~Bitboards::bit(rookFrom);
+        Point start = at;
+        MotionPlan kingFirst = out, rookFirst = out;
+        bool ok1 = carry(withoutRook, squareCentre(from), squareCentre(to), kingFirst) &&
+                   carry(withoutRook | Bitboards::bit(to), squareCentre(rookFrom), squareCentre(rookTo), kingFirst);
+        Point end1 = at;
+        at = start;
+        bool ok2 = carry(withoutRook, squareCentre(rookFrom), squareCentre(rookTo), rookFirst) &&
+                   carry(withoutRook | Bitboards::bit(rookTo), squareCentre(from), squareCentre(to), rookFirst);
+        if (ok1 && (!ok2 || kingFirst.seconds <= rookFirst.seconds)) { out = kingFirst; at = end1; }
+        else out = rookFirst;
+        return ok1 || ok2;
+    }
+
+    if (m.isPromotion()) {
+        // the pawn leaves straight for the graveyard and the promoted piece,
+        // if one was captured, comes back in its place
+        int slot = graveKnown ? findGrave(us, m.promotion(), squareCentre(to)) : -1;
+        if (slot >= 0) {
+            if (!toGrave(occ, from, us, PieceType::Pawn, out)) return false;
+            if (!carry(occ, gravePoint(us, slot), squareCentre(to), out)) return false;
+            grave[(int)us][slot] = PieceType::Empty;
+            return true;
+        }
+        out.needsHand = true; // the player swaps the pawn
+    }
+    return carry(occ, squareCentre(from), squareCentre(to), out);
+}
+
+} // namespace Motion
@@ -0,0 +1,135 @@
+#pragma once
+#include "board.h"
+#include <cstdint>
+
+// Turns a move into gantry waypoints for the electromagnet under the board.
+//
+// Positions are in half-square units: square centres sit on odd coordinates
+// ((2*file+1, 2*rank+1)), the lines between squares on even ones, so the
+// board spans 0..16 on both axes. Each side has a graveyard of two columns
+// just off the board, left of the a-file for White's captured pieces and
+// right of the h-file for Black's, one slot per rank and column.
+namespace Motion {
+
+struct Point {
+    int8_t x, y;
+    bool operator==(const Point &o) const { return x == o.x && y == o.y; }
+    bool operator!=(const Point &o) const { return !(*this == o); }
+};
+
+inline Point squareCentre(int sq) { return {(int8_t)(2 * (sq & 7) + 1), (int8_t)(2 * (sq >> 3) + 1)}; }
+
+// One straight run of the head, ending with a stop. With the magnet on a
+// piece is dragged along; with it off the head passes under pieces freely.
+struct Step {
+    Point to;
+    bool magnet;
+};
+
+struct MotionConfig {
+    float squareMm = 50;
+    float carryMmPerS = 80;   // dragging a piece; slower so it does not slip
+    float travelMmPerS = 200; // magnet off
+    float accelMmPerS2 = 400;
+    uint32_t magnetMs = 60;   // settle time each time the magnet switches on or off
+    bool cachePaths = true;
+};
+
+struct MotionPlan {
+    static constexpr int MaxSteps = 64;
+    Step steps[MaxSteps];
+    int count = 0;
+    float seconds = 0;   // execution time estimate, acceleration and magnet settling included
+    float carryMm = 0, travelMm = 0;
+    // a piece is left for the player to handle: a promotion with no captured
+    // piece of that kind to bring back, or a full or unknown graveyard
+    bool needsHand = false;
+};
+
+struct PlannerStats {
+    uint32_t plans;
+    uint32_t directRoutes; // straight slides along an open line, no search
+    uint32_t searches;
+    uint32_t cacheHits;
+};
+
+// Plans moves one at a time, keeping track of where the head stopped and
+// what lies in each graveyard slot, so it must see every move of the game in
+// order (reset() for a new one, resume() for one picked up part way through).
+// Cached routes and the stats outlive both.
+//
+// A piece slides straight to its target when the squares in between are
+// empty. Otherwise, knights included, it is routed over the grid of centres
+// and lines with a Dijkstra search that charges each stop for the time lost
+// braking and accelerating; a route may cross empty squares and run along
+// any line, keeping half a square from every other piece. A search stays
+// inside the rectangle with the two squares at its corners, out to the lines
+// around it, which are always open; so the occupancy of that rectangle is all
+// a route depends on, and routes are cached under it.
+class MotionPlanner {
+public:
+    explicit MotionPlanner(const MotionConfig &cfg = MotionConfig());
+    // head parked at (0,0), graveyards empty
+    void reset();
+    // a game resumed after a restart: the head has homed to (0,0), but which
+    // graveyard slots hold what is unknown, so until the next reset() captured
+    // pieces and promotions are left to the player (needsHand)
+    void resume();
+
+    // plan m, legal in b (the position before the move); false only if the
+    // plan did not fit in MotionPlan::MaxSteps
+    bool plan(const Chess::Board &b, Chess::Move m, MotionPlan &out);
+
+    Point head() const { return at; }
+    PlannerStats stats() const { return counters; }
+    const MotionConfig &config() const { return cfg; }
+
+    // time for one straight run of len half-squares from rest to rest
+    float runSeconds(float len, bool magnet) const;
+
+    static constexpr int GraveSlots = 16;
+
+private:
+    // grid with the graveyards: x in -4..20, y in 0..16
+    static constexpr int MinX = -4, Width = 25, Height = 17;
+    static constexpr int Nodes = Width * Height;
+    static constexpr int MaxRoute = 16;
+
+    struct Route {
+        Point points[MaxRoute]; // stops after the start
+        uint8_t count;
+    };
+    struct CacheEntry {
+        uint64_t occupancy;
+        uint8_t from, to, valid;
+        Route route;
+    };
+    static constexpr int CacheSize = 256;
+
+    // head to from, then drag the piece there to to; blocked holds the
+    // occupied board squares other than the moving piece
+    bool carry(Chess::Bitboard blocked, Point from, Point to, MotionPlan &out);
+    bool route(Chess::Bitboard blocked, Point from, Point to, Route &r);
+    bool search(Chess::Bitboard blocked, Point from, Point to, Route &r);
+    bool addStep(MotionPlan &out, Point to, bool magnet);
+    bool toGrave(Chess::Bitboard blocked, int sq, Chess::Color c, Chess::PieceType t, MotionPlan &out);
+    // the slot holding a t of colour c nearest to near, or -1
+    int findGrave(Chess::Color c, Chess::PieceType t, Point near) const;
+    bool graveOccupied(Point p) const;
+    static Point gravePoint(Chess::Color c, int slot);
+
+    MotionConfig cfg;
+    Point at;
+    Chess::PieceType grave[2][GraveSlots];
+    bool graveKnown;
+    CacheEntry cache[CacheSize];
+    PlannerStats counters;
+
+    // search scratch, kept here rather than on the caller's stack
+    uint32_t dist[Nodes * 9];
+    uint16_t prev[Nodes * 9];
+    uint16_t heap[Nodes * 9];
+    uint16_t heapPos[Nodes * 9];
+};
+
+} // namespace Motion
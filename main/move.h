@@ -1,15 +1,63 @@
 #pragma once
+#include "chess_types.h"
 #include <cstdint>
 #include <string>
+#include <cassert>
 
 namespace Chess {
 
-struct Move {
-    uint8_t from;      // 0..63
-    uint8_t to;        // 0..63
-    uint8_t promotion; // 0 = none, else PieceType as integer
-    uint8_t flags;     // bitflags: bit0 = capture, bit1 = enpassant, bit2 = castling
-    Move(uint8_t f=0,uint8_t t=0,uint8_t p=0,uint8_t fl=0) : from(f), to(t), promotion(p), flags(fl) {}
+// Packed 16-bit move: bits 0-5 from, 6-11 to, 12-13 promotion piece
+// (knight..queen), 14-15 kind. Captures are not encoded; ask the board.
+class Move {
+public:
+    enum Kind : uint8_t { Normal = 0, Promotion = 1, EnPassant = 2, Castling = 3 };
+
+    Move() = default; // left uninitialized so MoveList storage costs nothing to create
+    constexpr Move(int from, int to, Kind kind = Normal, PieceType promo = PieceType::Knight)
+        : data((uint16_t)(from | (to << 6) | (((int)promo - (int)PieceType::Knight) << 12) | (kind << 14))) {}
+    static constexpr Move none() { return Move(0, 0); }
+    static constexpr Move fromRaw(uint16_t raw) { Move m(0, 0); m.data = raw; return m; }
+
+    constexpr int from() const { return data & 63; }
+    constexpr int to() const { return (data >> 6) & 63; }
+    constexpr Kind kind() const { return (Kind)(data >> 14); }
+    constexpr bool isPromotion() const { return kind() == Promotion; }
+    constexpr bool isEnPassant() const { return kind() == EnPassant; }
+    constexpr bool isCastling() const { return kind() == Castling; }
+    // promoted-to piece, or Empty
+    constexpr PieceType promotion() const {
+        return isPromotion() ? (PieceType)(((data >> 12) & 3) + (int)PieceType::Knight) : PieceType::Empty;
+    }
+    constexpr bool isNone() const { return data == 0; }
+    constexpr uint16_t raw() const { return data; }
+    constexpr bool operator==(const Move &o) const { return data == o.data; }
+    constexpr bool operator!=(const Move &o) const { return data != o.data; }
+
+private:
+    uint16_t data;
+};
+static_assert(sizeof(Move) == 2, "Move must stay packed");
+
+// Fixed-capacity move list that lives on the stack; no legal position has more
+// than 218 moves.
+class MoveList {
+public:
+    static constexpr int Capacity = 256;
+    void clear() { n = 0; }
+    int size() const { return n; }
+    bool empty() const { return n == 0; }
+    void push_back(const Move &m) { assert(n < Capacity); moves[n++] = m; }
+    template<typename... Args> void emplace_back(Args... args) { push_back(Move(args...)); }
+    void resize(int size) { n = size; } // shrink only
+    Move &operator[](int i) { return moves[i]; }
+    const Move &operator[](int i) const { return moves[i]; }
+    Move *begin() { return moves; }
+    Move *end() { return moves + n; }
+    const Move *begin() const { return moves; }
+    const Move *end() const { return moves + n; }
+private:
+    Move moves[Capacity];
+    int n = 0;
 };
 
 inline std::string moveToUCI(const Move &m) {
@@ -20,17 +68,13 @@ inline std::string moveToUCI(const Move &m) {
         buf[2] = '\0';
         return std::string(buf);
     };
-    std::string s = sq(m.from) + sq(m.to);
-    if (m.promotion) {
-        char pc='q';
-        switch((int)m.promotion){
-            case 1: pc='n'; break;
-            case 2: pc='b'; break;
-            case 3: pc='r'; break;
-            case 4: pc='q'; break;
-            default: pc='q'; break;
-        }
-        s.push_back(pc);
+    std::string s = sq(m.from()) + sq(m.to());
+    switch (m.promotion()) {
+        case PieceType::Knight: s.push_back('n'); break;
+        case PieceType::Bishop: s.push_back('b'); break;
+        case PieceType::Rook: s.push_back('r'); break;
+        case PieceType::Queen: s.push_back('q'); break;
+        default: break;
     }
     return s;
 }
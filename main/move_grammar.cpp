@@ -0,0 +1,130 @@
+#include "move_grammar.h"
+#include <algorithm>
+
+namespace Chess {
+
+static const char *const WordText[SpokenWordCount] = {
+    "pawn", "knight", "bishop", "rook", "queen", "king",
+    "alpha", "bravo", "charlie", "delta", "echo", "foxtrot", "golf", "hotel",
+    "one", "two", "three", "four", "five", "six", "seven", "eight",
+    "to", "takes", "castle", "kingside", "queenside",
+};
+
+const char *spokenWordText(SpokenWord w) { return (int)w < SpokenWordCount ? WordText[(int)w] : "?"; }
+
+static SpokenWord pieceWord(PieceType t) { return (SpokenWord)((int)SpokenWord::Pawn + (int)t - (int)PieceType::Pawn); }
+static SpokenWord fileWord(int sq) { return (SpokenWord)((int)SpokenWord::FileA + (sq & 7)); }
+static SpokenWord rankWord(int sq) { return (SpokenWord)((int)SpokenWord::Rank1 + (sq >> 3)); }
+
+MoveGrammar::MoveGrammar() {
+    // a middlegame position with ~40 legal moves needs a few hundred nodes
+    nodes.reserve(1024);
+    moveRefs.reserve(1024);
+    ends.reserve(1024);
+    nodes.push_back({NoNode, NoNode, NoNode, 0, 0, SpokenWord::Count});
+}
+
+int MoveGrammar::child(int parent, SpokenWord w) const {
+    for (int c=nodes[parent].firstChild; c!=NoNode; c=nodes[c].nextSibling)
+        if (nodes[c].word == w) return c;
+    return -1;
+}
+
+void MoveGrammar::add(const SpokenWord *words, int count, int moveIndex) {
+    int at = 0;
+    for (int i=0; i<count; ++i) {
+        int c = child(at, words[i]);
+        if (c < 0) {
+            c = (int)nodes.size();
+            nodes.push_back({(uint16_t)at, NoNode, nodes[at].firstChild, 0, 0, words[i]});
+            nodes[at].firstChild = (uint16_t)c;
+        }
+        at = c;
+    }
+    ends.push_back({(uint16_t)at, (uint8_t)moveIndex});
+}
+
+void MoveGrammar::rebuild(const Board &b, const MoveList &legal) {
+    nodes.resize(1);
+    nodes[0].firstChild = NoNode;
+    moveRefs.clear();
+    ends.clear();
+
+    SpokenWord w[8];
+    for (int i=0; i<legal.size(); ++i) {
+        const Move &m = legal[i];
+        int from = m.from(), to = m.to();
+        if (m.isCastling()) {
+            w[0] = SpokenWord::Castle;
+            w[1] = (to & 7) == 6 ? SpokenWord::KingSide : SpokenWord::QueenSide;
+            add(w, 2, i);
+            add(w, 1, i); // bare "castle" is ambiguous when both sides are legal
+            continue;
+        }
+        PieceType t = b.squares[from].type;
+        bool pawn = t == PieceType::Pawn, capture = b.isCapture(m);
+        // underpromotions must be named; an unnamed promotion is the queen, as in MoveResolver
+        PieceType promo = m.promotion();
+        for (int named=pawn ? 0 : 1; named<2; ++named) {
+            for (int source=0; source<3; ++source) { // none, file, square
+                if (source == 1 && pawn && !capture) continue;
+                for (int link=0; link<3; ++link) {   // none, "to", "takes"
+                    if (link == 2 && !capture) continue;
+                    for (int promoNamed=0; promoNamed<2; ++promoNamed) {
+                        if (promoNamed == 0 && promo != PieceType::Empty && promo != PieceType::Queen) continue;
+                        if (promoNamed == 1 && promo == PieceType::Empty) continue;
+                        int n = 0;
+                        if (named) w[n++] = pieceWord(t);
+                        if (source >= 1) w[n++] = fileWord(from);
+                        if (source == 2) w[n++] = rankWord(from);
+                        if (link == 1) w[n++] = SpokenWord::To;
+                        if (link == 2) w[n++] = SpokenWord::Takes;
+                        w[n++] = fileWord(to);
+                        w[n++] = rankWord(to);
+                        if (promoNamed) w[n++] = pieceWord(promo);
+                        add(w, n, i);
+                    }
+                }
+            }
+        }
+    }
+
+    // group the moves by end node; a phrase can reach the same move only once
+    std::sort(ends.begin(), ends.end());
+    ends.erase(std::unique(ends.begin(), ends.end()), ends.end());
+    for (const auto &e : ends) {
+        Node &n = nodes[e.first];
+        if (!n.moveCount) n.firstMove = (uint16_t)moveRefs.size();
+        moveRefs.push_back(legal[e.second]);
+        ++n.moveCount;
+    }
+}
+
+int MoveGrammar::find(const SpokenWord *words, int count) const {
+    int at = 0;
+    for (int i=0; i<count && at>=0; ++i) at = child(at, words[i]);
+    return at;
+}
+
+int MoveGrammar::phrase(int i, SpokenWord *out, int max) const {
+    int depth = 0;
+    for (int n=i; n>0; n=nodes[n].parent) ++depth;
+    int count = std::min(depth, max);
+    // walk up from the end node, skipping words that do not fit
+    for (int n=i, d=depth; n>0; n=nodes[n].parent, --d)
+        if (d <= count) out[d-1] = nodes[n].word;
+    return count;
+}
+
+std::string MoveGrammar::phraseText(int i) const {
+    SpokenWord words[8];
+    int n = phrase(i, words, 8);
+    std::string s;
+    for (int k=0; k<n; ++k) {
+        if (k) s.push_back(' ');
+        s += spokenWordText(words[k]);
+    }
+    return s;
+}
+
+} // namespace Chess
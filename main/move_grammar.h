@@ -0,0 +1,66 @@
+#pragma once
+#include "board.h"
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace Chess {
+
+// Words of the keyword model: piece names, files (NATO alphabet, which the
+// model separates far better than letter names), ranks and the connectives.
+enum class SpokenWord : uint8_t {
+    Pawn, Knight, Bishop, Rook, Queen, King,
+    FileA, FileB, FileC, FileD, FileE, FileF, FileG, FileH,
+    Rank1, Rank2, Rank3, Rank4, Rank5, Rank6, Rank7, Rank8,
+    To, Takes, Castle, KingSide, QueenSide,
+    Count
+};
+constexpr int SpokenWordCount = (int)SpokenWord::Count;
+
+// "knight", "alpha", "four", ...; these parse with MoveResolver::parseSpoken
+const char *spokenWordText(SpokenWord w);
+
+// Prefix tree of every phrase that names a legal move in one position:
+//   [piece] [from file | from square] [to | takes] file rank [promotion]
+//   castle [kingside | queenside]
+// The piece is optional only for pawns, "takes" only appears on captures and a
+// bare from file only for pieces and pawn captures. A node where a phrase ends
+// lists the moves it names; more than one means the phrase is ambiguous. Any
+// path from the root is the prefix of some legal move, so a decoder walking
+// the tree never spends work on phrases that cannot complete.
+class MoveGrammar {
+public:
+    static constexpr uint16_t NoNode = 0xffff;
+    struct Node {
+        uint16_t parent;
+        uint16_t firstChild;  // NoNode if none
+        uint16_t nextSibling; // NoNode if none
+        uint16_t firstMove;   // into moves(), valid when moveCount > 0
+        uint8_t moveCount;
+        SpokenWord word;      // word on the edge from the parent; unused for the root
+    };
+
+    MoveGrammar();
+    void rebuild(const Board &b, const MoveList &legal);
+
+    // node 0 is the root; children always have larger indices than their parent
+    int size() const { return (int)nodes.size(); }
+    const Node &node(int i) const { return nodes[i]; }
+    const Move *moves(int i) const { return moveRefs.data() + nodes[i].firstMove; }
+
+    // node reached by a word sequence from the root, or -1 if no legal move starts so
+    int find(const SpokenWord *words, int count) const;
+    // words on the path to node i, root first; returns the count (at most max)
+    int phrase(int i, SpokenWord *out, int max) const;
+    std::string phraseText(int i) const;
+
+private:
+    int child(int parent, SpokenWord w) const;
+    void add(const SpokenWord *words, int count, int moveIndex);
+
+    std::vector<Node> nodes;
+    std::vector<Move> moveRefs;                       // moves per end node, grouped
+    std::vector<std::pair<uint16_t, uint8_t>> ends;   // (end node, legal index) while building
+};
+
+} // namespace Chess
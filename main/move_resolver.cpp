@@ -0,0 +1,267 @@
+#include "move_resolver.h"
+#include <cctype>
+#include <cstring>
+
+namespace Chess {
+
+static constexpr char PieceLetters[] = " PNBRQK"; // by PieceType
+static constexpr char PromoLetters[] = "NBRQ";
+
+MoveResolver::MoveResolver() { clearIndex(); }
+
+void MoveResolver::clearIndex() { std::memset(head, 0, sizeof(head)); }
+
+void MoveResolver::rebuild(const Board &b, const MoveList &legal) {
+    clearIndex();
+    moves = &legal;
+    // push in reverse so each chain lists moves in generation order (queen promotion first)
+    for (int i=legal.size()-1; i>=0; --i) {
+        const Move &m = legal[i];
+        int t = (int)b.squares[m.from()].type;
+        next[i] = head[t][m.to()];
+        head[t][m.to()] = (uint8_t)(i + 1);
+        capture[i] = b.isCapture(m);
+    }
+}
+
+bool MoveResolver::matches(const MoveQuery &q, int i) const {
+    const Move &m = (*moves)[i];
+    if (q.fromFile >= 0 && (m.from() & 7) != q.fromFile) return false;
+    if (q.fromRank >= 0 && (m.from() >> 3) != q.fromRank) return false;
+    if (q.capture >= 0 && capture[i] != (q.capture == 1)) return false;
+    // an unspecified promotion means the queen
+    if (m.isPromotion() && m.promotion() != (q.promotion != PieceType::Empty ? q.promotion : PieceType::Queen)) return false;
+    if (!m.isPromotion() && q.promotion != PieceType::Empty) return false;
+    return true;
+}
+
+Resolution MoveResolver::resolve(const MoveQuery &q) const {
+    Resolution r;
+    if (!moves) return r;
+    r.status = Resolution::Status::NoMatch;
+    auto add = [&](int i) {
+        if (r.count < Resolution::MaxOptions) r.options[r.count] = (*moves)[i];
+        ++r.count;
+    };
+    if (q.castle) {
+        // castling is the only king move of two files; both colours' targets are safe to probe
+        const int kingSide[2] = {6, 62}, queenSide[2] = {2, 58};
+        for (int c=0; c<2; ++c) {
+            if (q.castle & 1) for (int i=head[(int)PieceType::King][kingSide[c]]; i; i=next[i-1]) if ((*moves)[i-1].isCastling()) add(i-1);
+            if (q.castle & 2) for (int i=head[(int)PieceType::King][queenSide[c]]; i; i=next[i-1]) if ((*moves)[i-1].isCastling()) add(i-1);
+        }
+    } else if (q.dest >= 0) {
+        int lo = (int)PieceType::Pawn, hi = (int)PieceType::King;
+        if (q.piece != PieceType::Empty) lo = hi = (int)q.piece;
+        for (int t=lo; t<=hi; ++t)
+            for (int i=head[t][q.dest]; i; i=next[i-1]) if (matches(q, i-1)) add(i-1);
+    } else {
+        r.status = Resolution::Status::Unparsed;
+        return r;
+    }
+    if (r.count == 1) { r.status = Resolution::Status::Ok; r.move = r.options[0]; }
+    else if (r.count > 1) r.status = Resolution::Status::Ambiguous;
+    return r;
+}
+
+static int fileOfChar(char c) { return (c>='a' && c<='h') ? c - 'a' : -1; }
+static int rankOfChar(char c) { return (c>='1' && c<='8') ? c - '1' : -1; }
+
+bool MoveResolver::parseSAN(const std::string &text, MoveQuery &q) {
+    q = MoveQuery();
+    std::string s = text;
+    while (!s.empty() && std::strchr("+#!?", s.back())) s.pop_back();
+    if (s.empty() || s.find(' ') != std::string::npos) return false;
+    if (s=="O-O" || s=="0-0") { q.castle = 1; return true; }
+    if (s=="O-O-O" || s=="0-0-0") { q.castle = 2; return true; }
+
+    size_t i = 0;
+    if (const char *p = std::strchr(PieceLetters + 1, s[0])) { q.piece = (PieceType)(p - PieceLetters); ++i; }
+    // promotion suffix: "e8=Q", "e8Q" or UCI "e7e8q"
+    size_t end = s.size();
+    char last = (char)std::toupper((unsigned char)s[end-1]);
+    if (end >= 3 && std::strchr(PromoLetters, last)) {
+        size_t before = end - 1;
+        if (s[before-1] == '=') --before;
+        if (before >= 1 && rankOfChar(s[before-1]) >= 0) {
+            q.promotion = (PieceType)(std::strchr(PieceLetters, last) - PieceLetters);
+            end = before;
+        }
+    }
+    if (end < i + 2) return false;
+    int df = fileOfChar(s[end-2]), dr = rankOfChar(s[end-1]);
+    if (df < 0 || dr < 0) return false;
+    q.dest = (int8_t)(dr*8 + df);
+    // anything between the piece letter and the destination: disambiguator, 'x', '-'
+    for (size_t k=i; k<end-2; ++k) {
+        char c = s[k];
+        if (c=='x' || c==':') q.capture = 1;
+        else if (c=='-') continue;
+        else if (fileOfChar(c) >= 0 && q.fromFile < 0) q.fromFile = (int8_t)fileOfChar(c);
+        else if (rankOfChar(c) >= 0 && q.fromRank < 0) q.fromRank = (int8_t)rankOfChar(c);
+        else return false;
+    }
+    // no piece letter: a pawn, unless a full from-square was given (UCI / long algebraic)
+    if (i == 0 && !(q.fromFile >= 0 && q.fromRank >= 0)) q.piece = PieceType::Pawn;
+    return true;
+}
+
+namespace {
+
+enum class Tok : uint8_t { Piece, File, Rank, Square, Capture, Promote, Castle, KingSide, QueenSide, Other };
+
+struct Token {
+    Tok kind;
+    int8_t value; // piece type, file, rank or square
+};
+
+struct Word { const char *text; Tok kind; int8_t value; };
+
+const Word Vocabulary[] = {
+    {"pawn", Tok::Piece, (int8_t)PieceType::Pawn}, {"knight", Tok::Piece, (int8_t)PieceType::Knight},
+    {"bishop", Tok::Piece, (int8_t)PieceType::Bishop}, {"rook", Tok::Piece, (int8_t)PieceType::Rook},
+    {"queen", Tok::Piece, (int8_t)PieceType::Queen}, {"king", Tok::Piece, (int8_t)PieceType::King},
+    {"alpha", Tok::File, 0}, {"bravo", Tok::File, 1}, {"charlie", Tok::File, 2}, {"delta", Tok::File, 3},
+    {"echo", Tok::File, 4}, {"foxtrot", Tok::File, 5}, {"golf", Tok::File, 6}, {"hotel", Tok::File, 7},
+    {"one", Tok::Rank, 0}, {"two", Tok::Rank, 1}, {"three", Tok::Rank, 2}, {"four", Tok::Rank, 3},
+    {"five", Tok::Rank, 4}, {"six", Tok::Rank, 5}, {"seven", Tok::Rank, 6}, {"eight", Tok::Rank, 7},
+    {"takes", Tok::Capture, 0}, {"take", Tok::Capture, 0}, {"captures", Tok::Capture, 0},
+    {"capture", Tok::Capture, 0}, {"x", Tok::Capture, 0},
+    {"promote", Tok::Promote, 0}, {"promotes", Tok::Promote, 0}, {"promoting", Tok::Promote, 0},
+    {"promotion", Tok::Promote, 0}, {"equals", Tok::Promote, 0},
+    {"castle", Tok::Castle, 0}, {"castles", Tok::Castle, 0}, {"castling", Tok::Castle, 0},
+    {"kingside", Tok::KingSide, 0}, {"short", Tok::KingSide, 0},
+    {"queenside", Tok::QueenSide, 0}, {"long", Tok::QueenSide, 0},
+};
+
+Token classify(const std::string &w) {
+    for (const Word &v : Vocabulary) if (w == v.text) return {v.kind, v.value};
+    if (w.size()==1 && fileOfChar(w[0]) >= 0) return {Tok::File, (int8_t)fileOfChar(w[0])};
+    if (w.size()==1 && rankOfChar(w[0]) >= 0) return {Tok::Rank, (int8_t)rankOfChar(w[0])};
+    if (w.size()==2 && fileOfChar(w[0]) >= 0 && rankOfChar(w[1]) >= 0)
+        return {Tok::Square, (int8_t)(rankOfChar(w[1])*8 + fileOfChar(w[0]))};
+    return {Tok::Other, 0}; // filler such as "to", "on", "move"
+}
+
+} // namespace
+
+bool MoveResolver::parseSpoken(const std::string &text, MoveQuery &q) {
+    q = MoveQuery();
+    std::string phrase = text;
+    for (char &c : phrase) c = (char)std::tolower((unsigned char)c);
+    constexpr int MaxTokens = 16;
+    Token toks[MaxTokens];
+    int n = 0;
+    std::string word;
+    for (size_t i=0; i<=phrase.size() && n<MaxTokens; ++i) {
+        char c = i<phrase.size() ? phrase[i] : ' ';
+        if (std::isalnum((unsigned char)c)) { word.push_back(c); continue; }
+        if (word.empty()) continue;
+        Token t = classify(word);
+        word.clear();
+        if (t.kind == Tok::Other) continue;
+        // "king side" / "queen side"
+        if (t.kind == Tok::Piece && n > 0 && i < phrase.size()) {
+            size_t j = i;
+            while (j < phrase.size() && !std::isalnum((unsigned char)phrase[j])) ++j;
+            if (phrase.compare(j, 4, "side") == 0 && (t.value == (int8_t)PieceType::King || t.value == (int8_t)PieceType::Queen)) {
+                t.kind = t.value == (int8_t)PieceType::King ? Tok::KingSide : Tok::QueenSide;
+                i = j + 3;
+            }
+        }
+        // a file followed by a rank is a square: "e four"
+        if (t.kind == Tok::Rank && n > 0 && toks[n-1].kind == Tok::File) {
+            toks[n-1] = {Tok::Square, (int8_t)(t.value*8 + toks[n-1].value)};
+            continue;
+        }
+        toks[n++] = t;
+    }
+
+    for (int i=0; i<n; ++i) {
+        if (toks[i].kind != Tok::Castle) continue;
+        q.castle = 3;
+        for (int j=0; j<n; ++j) {
+            if (toks[j].kind == Tok::KingSide) q.castle = 1;
+            if (toks[j].kind == Tok::QueenSide) q.castle = 2;
+        }
+        return true;
+    }
+
+    int destTok = -1;
+    for (int i=0; i<n; ++i) if (toks[i].kind == Tok::Square) destTok = i;
+    if (destTok < 0) return false;
+    q.dest = toks[destTok].value;
+    for (int i=0; i<n; ++i) {
+        const Token &t = toks[i];
+        if (t.kind == Tok::Capture) q.capture = 1;
+        else if (i < destTok) {
+            if (t.kind == Tok::Piece && q.piece == PieceType::Empty) q.piece = (PieceType)t.value;
+            else if (t.kind == Tok::Square) { q.fromFile = t.value & 7; q.fromRank = t.value >> 3; }
+            else if (t.kind == Tok::File) q.fromFile = t.value;
+            else if (t.kind == Tok::Rank) q.fromRank = t.value;
+        } else if (i > destTok && t.kind == Tok::Piece) {
+            if (t.value >= (int8_t)PieceType::Knight && t.value <= (int8_t)PieceType::Queen)
+                q.promotion = (PieceType)t.value;
+        }
+    }
+    return true;
+}
+
+Resolution MoveResolver::resolve(const std::string &text) const {
+    MoveQuery q;
+    if (parseSAN(text, q)) return resolve(q);
+    if (!parseSpoken(text, q)) return Resolution();
+    if (q.piece != PieceType::Empty || q.castle) return resolve(q);
+    // no piece named: players mean a pawn ("e four"), but fall back to any piece ("takes d5")
+    q.piece = PieceType::Pawn;
+    Resolution r = resolve(q);
+    if (r.status != Resolution::Status::NoMatch) return r;
+    q.piece = PieceType::Empty;
+    return resolve(q);
+}
+
+std::string MoveResolver::toSAN(Board &b, const Move &m) const {
+    std::string s;
+    int from = m.from(), to = m.to();
+    if (m.isCastling()) s = (to & 7) == 6 ? "O-O" : "O-O-O";
+    else {
+        PieceType t = b.squares[from].type;
+        bool capture = b.isCapture(m);
+        if (t == PieceType::Pawn) {
+            if (capture) s.push_back((char)('a' + (from & 7)));
+        } else {
+            s.push_back(PieceLetters[(int)t]);
+            // disambiguate against other pieces of the same type reaching the same square
+            bool other = false, sameFile = false, sameRank = false;
+            if (moves) {
+                for (int i=head[(int)t][to]; i; i=next[i-1]) {
+                    int of = (*moves)[i-1].from();
+                    if (of == from) continue;
+                    other = true;
+                    sameFile |= (of & 7) == (from & 7);
+                    sameRank |= (of >> 3) == (from >> 3);
+                }
+            }
+            if (other) {
+                if (!sameFile) s.push_back((char)('a' + (from & 7)));
+                else if (!sameRank) s.push_back((char)('1' + (from >> 3)));
+                else { s.push_back((char)('a' + (from & 7))); s.push_back((char)('1' + (from >> 3))); }
+            }
+        }
+        if (capture) s.push_back('x');
+        s.push_back((char)('a' + (to & 7)));
+        s.push_back((char)('1' + (to >> 3)));
+        if (m.isPromotion()) { s.push_back('='); s.push_back(PieceLetters[(int)m.promotion()]); }
+    }
+    b.makeMove(m);
+    Color us = b.sideToMove, them = us==Color::White ? Color::Black : Color::White;
+    if (b.isSquareAttacked(b.findKing(us), them)) {
+        MoveList replies;
+        b.generateLegal(us, replies);
+        s.push_back(replies.empty() ? '#' : '+');
+    }
+    b.undoMove();
+    return s;
+}
+
+} // namespace Chess
@@ -0,0 +1,57 @@
+#pragma once
+#include "board.h"
+#include <string>
+
+namespace Chess {
+
+// What a SAN string or spoken phrase says about a move. Unset fields are -1 /
+// Empty and match anything.
+struct MoveQuery {
+    PieceType piece = PieceType::Empty;
+    int8_t dest = -1;
+    int8_t fromFile = -1, fromRank = -1; // disambiguator
+    int8_t capture = -1;                 // -1 unspecified, 0 quiet, 1 capture
+    PieceType promotion = PieceType::Empty;
+    uint8_t castle = 0;                  // 0 none, 1 king side, 2 queen side, 3 either
+};
+
+struct Resolution {
+    enum class Status : uint8_t { Ok, Ambiguous, NoMatch, Unparsed };
+    static constexpr int MaxOptions = 8;
+    Status status = Status::Unparsed;
+    Move move = Move::none(); // the match when status is Ok
+    int count = 0;            // number of matching legal moves
+    Move options[MaxOptions]; // first matches, for asking the player to choose
+};
+
+// Index over one position's legal moves keyed by (moving piece, destination),
+// so SAN and spoken queries resolve by walking a handful of entries instead of
+// scanning the list. Rebuild it whenever the position changes.
+class MoveResolver {
+public:
+    MoveResolver();
+    void rebuild(const Board &b, const MoveList &legal);
+
+    // SAN ("Nbd7", "exd5", "e8=Q+", "O-O") or UCI ("g1f3")
+    static bool parseSAN(const std::string &san, MoveQuery &q);
+    // spoken phrase: "knight to f3", "bishop takes e5", "castle kingside", "pawn e four"
+    static bool parseSpoken(const std::string &phrase, MoveQuery &q);
+
+    Resolution resolve(const MoveQuery &q) const;
+    // tries SAN/UCI first, then the spoken grammar
+    Resolution resolve(const std::string &text) const;
+    // SAN with minimal disambiguation and +/# suffix; b must be the indexed
+    // position and is restored before returning
+    std::string toSAN(Board &b, const Move &m) const;
+
+private:
+    void clearIndex();
+    bool matches(const MoveQuery &q, int i) const;
+
+    const MoveList *moves = nullptr;
+    uint8_t head[7][64]; // [piece][dest] -> first move index + 1, 0 = none
+    uint8_t next[MoveList::Capacity]; // chain to the next move with the same key, + 1
+    bool capture[MoveList::Capacity]; // per move, since Move does not encode captures
+};
+
+} // namespace Chess
@@ -0,0 +1,145 @@
+#include "opening_book.h"
+#include <algorithm>
+
+#ifdef ESP_PLATFORM
+extern "C" {
+#include "esp_partition.h"
+}
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Chess {
+
+namespace {
+
+uint16_t get16(const uint8_t *p) { return (uint16_t)(p[0] << 8 | p[1]); }
+
+void put(uint8_t *p, uint64_t v, int bytes) {
+    for (int i=bytes-1; i>=0; --i, v >>= 8) p[i] = (uint8_t)v;
+}
+
+} // namespace
+
+uint64_t OpeningBook::keyAt(const uint8_t *image, size_t i) {
+    const uint8_t *p = image + i * EntrySize;
+    uint64_t k = 0;
+    for (int b=0; b<8; ++b) k = k << 8 | p[b];
+    return k;
+}
+
+void OpeningBook::writeEntry(uint8_t *out, uint64_t key, uint16_t move, uint16_t weight) {
+    put(out, key, 8);
+    put(out + 8, move, 2);
+    put(out + 10, weight, 2);
+    put(out + 12, 0, 4); // learn, unused
+}
+
+uint16_t OpeningBook::encodeMove(const Move &m) {
+    int from = m.from(), to = m.to();
+    if (m.isCastling()) to = (to & 7) == 6 ? (from | 7) : (from & ~7); // onto the rook
+    int promo = m.isPromotion() ? (int)m.promotion() - (int)PieceType::Knight + 1 : 0;
+    return (uint16_t)(to | from << 6 | promo << 12);
+}
+
+bool OpeningBook::open(const char *name) {
+    close();
+#ifdef ESP_PLATFORM
+    const esp_partition_t *part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, name);
+    if (!part) return false;
+    const void *ptr;
+    esp_partition_mmap_handle_t handle;
+    // reads go through the flash cache; nothing is copied into SRAM
+    if (esp_partition_mmap(part, 0, part->size, ESP_PARTITION_MMAP_DATA, &ptr, &handle) != ESP_OK) return false;
+    mapHandle = handle;
+    mappedBytes = part->size;
+    data = static_cast<const uint8_t *>(ptr);
+    count = part->size / EntrySize;
+    // the partition is larger than the book; its erased tail reads as keys of all ones
+    count = lowerBound(UINT64_MAX);
+    return true;
+#else
+    int fd = ::open(name, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)EntrySize) { ::close(fd); return false; }
+    void *ptr = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (ptr == MAP_FAILED) return false;
+    mappedBytes = (size_t)st.st_size;
+    data = static_cast<const uint8_t *>(ptr);
+    count = mappedBytes / EntrySize;
+    return true;
+#endif
+}
+
+void OpeningBook::openMemory(const uint8_t *image, size_t bytes) {
+    close();
+    data = image;
+    count = bytes / EntrySize;
+}
+
+void OpeningBook::close() {
+    if (data && mappedBytes) {
+#ifdef ESP_PLATFORM
+        esp_partition_munmap((esp_partition_mmap_handle_t)mapHandle);
+#else
+        munmap(const_cast<uint8_t *>(data), mappedBytes);
+#endif
+    }
+    data = nullptr;
+    count = 0;
+    mappedBytes = 0;
+}
+
+size_t OpeningBook::lowerBound(uint64_t key) const {
+    size_t lo = 0, hi = count;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo) / 2;
+        if (keyAt(data, mid) < key) lo = mid + 1;
+        else hi = mid;
+    }
+    return lo;
+}
+
+int OpeningBook::lookup(const Board &b, BookMove *out, int max) const {
+    if (!data || max <= 0) return 0;
+    size_t i = lowerBound(b.key);
+    if (i == count || keyAt(data, i) != b.key) return 0;
+    MoveList legal;
+    b.generateLegal(b.sideToMove, legal);
+    int n = 0;
+    for (; i < count && keyAt(data, i) == b.key; ++i) {
+        const uint8_t *e = data + i * EntrySize;
+        uint16_t code = get16(e + 8), weight = get16(e + 10);
+        if (!weight) continue;
+        // only moves legal here: a key collision or a stale book must not play nonsense
+        for (const Move &m : legal) {
+            if (encodeMove(m) != code) continue;
+            if (n < max) out[n++] = {m, weight};
+            else if (weight > out[max - 1].weight) out[max - 1] = {m, weight};
+            std::sort(out, out + n, [](const BookMove &x, const BookMove &y) { return x.weight > y.weight; });
+            break;
+        }
+    }
+    return n;
+}
+
+Move OpeningBook::pick(const Board &b, uint32_t random) const {
+    BookMove moves[16];
+    int n = lookup(b, moves, 16);
+    uint32_t total = 0;
+    for (int i=0; i<n; ++i) total += moves[i].weight;
+    if (!total) return Move::none();
+    uint32_t r = random % total;
+    for (int i=0; i<n; ++i) {
+        if (r < moves[i].weight) return moves[i].move;
+        r -= moves[i].weight;
+    }
+    return moves[0].move;
+}
+
+} // namespace Chess
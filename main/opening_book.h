@@ -0,0 +1,63 @@
+#pragma once
+#include "board.h"
+#include <cstddef>
+#include <cstdint>
+
+// Opening book read in place from a memory-mapped file or flash partition,
+// so it costs no SRAM however large it is.
+//
+// The file is a Polyglot book: 16-byte big-endian records of key (u64),
+// move (u16), weight (u16) and learn (u32), sorted by key. The key is
+// Board::key rather than the Polyglot Zobrist numbers, so books come from
+// book_builder, not from other tools. Moves use the Polyglot encoding: to
+// square in bits 0-5, from square in bits 6-11 (file in the low three bits of
+// each), promotion piece in bits 12-14 (1 knight .. 4 queen), castling as
+// the king taking its own rook.
+namespace Chess {
+
+struct BookMove {
+    Move move;
+    uint16_t weight;
+};
+
+class OpeningBook {
+public:
+    static constexpr size_t EntrySize = 16;
+
+    OpeningBook() = default;
+    ~OpeningBook() { close(); }
+    OpeningBook(const OpeningBook&) = delete;
+    OpeningBook &operator=(const OpeningBook&) = delete;
+
+    // a file path on the host, a data partition label on the device
+    bool open(const char *name);
+    // an image already in memory, e.g. embedded in the binary
+    void openMemory(const uint8_t *image, size_t bytes);
+    void close();
+    bool isOpen() const { return data != nullptr; }
+    size_t size() const { return count; }
+
+    // legal book moves for b, heaviest first; returns how many were written
+    int lookup(const Board &b, BookMove *out, int max) const;
+    // a book move chosen with probability proportional to its weight, given
+    // a uniform random number; Move::none() when out of book
+    Move pick(const Board &b, uint32_t random) const;
+
+    static uint16_t encodeMove(const Move &m);
+    // record i of a book image
+    static uint64_t keyAt(const uint8_t *image, size_t i);
+    static void writeEntry(uint8_t *out, uint64_t key, uint16_t move, uint16_t weight);
+
+private:
+    // first record with a key not below key
+    size_t lowerBound(uint64_t key) const;
+
+    const uint8_t *data = nullptr;
+    size_t count = 0;
+    size_t mappedBytes = 0; // nonzero when this object owns a mapping
+#ifdef ESP_PLATFORM
+    uint32_t mapHandle = 0; // esp_partition_mmap_handle_t
+#endif
+};
+
+} // namespace Chess
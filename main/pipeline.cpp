@@ -0,0 +1,218 @@
+#include "pipeline.h"
+#include <climits>
+#include <cstring>
+
+namespace App {
+
+using namespace Chess;
+
+static void bump(std::atomic<uint32_t> &c) { c.fetch_add(1, std::memory_order_relaxed); }
+
+Pipeline::Pipeline(Audio::AudioSource &src, Audio::KeywordModel *model, const PipelineConfig &c)
+    : cfg(c), source(src), gate(speech), recognizer(model), search(c.ttBytes) {
+    gate.setRecorder(c.recorder);
+    speech.wakeOnData(recognitionWake);
+    positions.wakeOnData(recognitionWake);
+    commands.wakeOnData(engineWake);
+    text.wakeOnData(engineWake);
+}
+
+Pipeline::~Pipeline() { stop(); }
+
+bool Pipeline::start() {
+    if (running.load()) return true;
+    if (!source.start()) return false;
+    running.store(true);
+    bookRandom = Trace::nowUs() | 1;
+    publishPosition();
+    bool ok = captureTask.start(cfg.capture, [this]() { captureLoop(); }) &&
+              recognitionTask.start(cfg.recognition, [this]() { recognitionLoop(); }) &&
+              engineTask.start(cfg.engine, [this]() { engineLoop(); });
+    if (!ok) stop();
+    return ok;
+}
+
+void Pipeline::stop() {
+    if (!running.exchange(false)) return;
+    search.stop();
+    engineWake.notify();
+    captureTask.join();
+    recognitionTask.join();
+    engineTask.join();
+    source.stop();
+}
+
+bool Pipeline::setPosition(const Board &b) {
+    if (running.load()) return false;
+    return game.loadFEN(b.toFEN());
+}
+
+void Pipeline::newGame() {
+    newGameRequested.store(true, std::memory_order_release);
+    engineWake.notify();
+}
+
+bool Pipeline::submitText(const char *s) {
+    TextCommand t;
+    std::strncpy(t.text, s, sizeof(t.text) - 1);
+    t.text[sizeof(t.text) - 1] = '\0';
+    t.traceId = Trace::typedId(typedCommands++);
+    return text.push(t, cfg.blockMs);
+}
+
+bool Pipeline::pollEvent(EngineEvent &e, int timeoutMs) { return events.pop(e, timeoutMs); }
+
+PipelineStats Pipeline::stats() const {
+    PipelineStats s;
+    s.capture = source.stats();
+    s.captureGaps = gaps.load(std::memory_order_relaxed);
+    s.speech = speech.stats();
+    s.commands = commands.stats();
+    s.text = text.stats();
+    s.positions = positions.stats();
+    s.events = events.stats();
+    s.utterances = utterances.load(std::memory_order_relaxed);
+    s.featureFrames = featureFrames.load(std::memory_order_relaxed);
+    s.movesPlayed = moves.load(std::memory_order_relaxed);
+    s.captureStackFree = captureTask.stackFree();
+    s.recognitionStackFree = recognitionTask.stackFree();
+    s.engineStackFree = engineTask.stackFree();
+    return s;
+}
+
+void Pipeline::captureLoop() {
+    Audio::FrameRing &ring = source.frames();
+    uint32_t expected = 0;
+    bool first = true;
+    while (running.load(std::memory_order_relaxed)) {
+        Audio::Frame *f = ring.readSlot();
+        if (!f) {
+            // the source ring holds 320 ms; a few ms of sleep costs nothing
+            Util::sleepMs(5);
+            continue;
+        }
+        if (!first && f->sequence != expected) bump(gaps);
+        first = false;
+        expected = f->sequence + 1;
+        // forwards speech to recognition, dropping if it is full; the clock is
+        // read first so recognition can't stamp the utterance before we do
+        uint32_t now = Trace::nowUs();
+        if (gate.push(*f) == Audio::Vad::Event::End) {
+            uint16_t id = Trace::voiceId(f->sequence);
+            const uint32_t frameUs = 1000000u * Audio::FrameSamples / Audio::SampleRate;
+            Trace::recordAt(Trace::Point::SpeechEnd, id, now - gate.detector().trailingFrames() * frameUs);
+            Trace::recordAt(Trace::Point::VadEnd, id, now);
+        }
+        ring.releaseRead();
+    }
+}
+
+void Pipeline::recognitionLoop() {
+    while (running.load(std::memory_order_relaxed)) {
+        PositionUpdate p;
+        while (positions.tryPop(p)) recognizer.setPosition(p.packed, p.size);
+        Audio::SpeechFrame *sf = speech.readSlot();
+        if (!sf) {
+            recognitionWake.wait(100); // bounded so stop() is noticed
+            continue;
+        }
+        bool done = recognizer.push(*sf);
+        uint32_t sequence = sf->frame.sequence;
+        speech.releaseRead();
+        featureFrames.store(recognizer.featureFrames(), std::memory_order_relaxed);
+        if (!done) continue;
+        bump(utterances);
+        int n = recognizer.resultCount();
+        if (!n) continue;
+        const Audio::KwsHypothesis *r = recognizer.results();
+        MoveCommand c{r[0].move, n > 1 ? r[0].score - r[1].score : INT32_MAX, Trace::voiceId(sequence)};
+        commands.push(c, cfg.blockMs);
+    }
+}
+
+void Pipeline::publishPosition() {
+    PositionUpdate p;
+    p.size = (uint8_t)game.position().pack(p.packed);
+    positions.push(p, cfg.blockMs);
+}
+
+void Pipeline::play(const Move &m, bool byEngine, const SearchResult *r, uint16_t traceId) {
+    EngineEvent e{};
+    e.byEngine = byEngine;
+    e.move = m;
+    e.traceId = traceId;
+    if (!game.playMove(m)) {
+        e.kind = EngineEvent::Kind::Rejected;
+        events.push(e, cfg.blockMs);
+        return;
+    }
+    bump(moves);
+    if (!byEngine) Trace::record(Trace::Point::MoveResolved, traceId);
+    e.kind = EngineEvent::Kind::Played;
+    if (r) { e.score = (int16_t)r->score; e.depth = (uint8_t)r->depth; e.thinkMs = r->timeMs; }
+    events.push(e, cfg.blockMs);
+    publishPosition();
+    if (game.legalMoves().empty()) {
+        EngineEvent over{};
+        over.kind = EngineEvent::Kind::GameOver;
+        over.traceId = traceId;
+        events.push(over, cfg.blockMs);
+    }
+}
+
+void Pipeline::engineLoop() {
+    while (running.load(std::memory_order_relaxed)) {
+        engineWake.wait(100);
+        if (newGameRequested.exchange(false, std::memory_order_acquire)) {
+            game.newGame();
+            search.clear();
+            publishPosition();
+            EngineEvent e{};
+            e.kind = EngineEvent::Kind::NewGame;
+            events.push(e, cfg.blockMs);
+        }
+        // one shared wake-up, so both inputs are drained after every one
+        for (;;) {
+            Move m = Move::none();
+            uint16_t id;
+            MoveCommand c;
+            TextCommand t;
+            if (commands.tryPop(c)) {
+                id = c.traceId;
+                Trace::record(Trace::Point::CommandReceived, id);
+                m = c.move;
+            } else if (text.tryPop(t)) {
+                id = t.traceId;
+                Trace::record(Trace::Point::CommandReceived, id);
+                Resolution r = game.resolveMove(t.text);
+                if (r.status != Resolution::Status::Ok) {
+                    EngineEvent e{};
+                    e.kind = EngineEvent::Kind::Rejected;
+                    e.move = r.count ? r.options[0] : Move::none();
+                    e.traceId = id;
+                    events.push(e, cfg.blockMs);
+                    continue;
+                }
+                m = r.move;
+            } else break;
+
+            int before = game.movesPlayed();
+            play(m, false, nullptr, id);
+            if (!cfg.engineReplies || game.movesPlayed() == before || game.legalMoves().empty()) continue;
+            Trace::record(Trace::Point::SearchStart, id);
+            SearchResult r{};
+            if (cfg.book) {
+                bookRandom ^= bookRandom << 13;
+                bookRandom ^= bookRandom >> 17;
+                bookRandom ^= bookRandom << 5;
+                r.best = cfg.book->pick(game.position(), bookRandom);
+            }
+            if (r.best.isNone()) r = search.think(game.position(), cfg.limits);
+            Trace::record(Trace::Point::SearchDone, id);
+            if (!running.load(std::memory_order_relaxed) || r.best.isNone()) break;
+            play(r.best, true, &r, id);
+        }
+    }
+}
+
+} // namespace App
@@ -0,0 +1,134 @@
+#pragma once
+#include "audio_recorder.h"
+#include "channel.h"
+#include "game.h"
+#include "opening_book.h"
+#include "recognizer.h"
+#include "search.h"
+#include "task.h"
+#include "trace.h"
+#include <atomic>
+
+namespace App {
+
+// Engine -> recognition: the position to build the next grammar from.
+struct PositionUpdate {
+    uint8_t size;
+    uint8_t packed[Chess::Board::MaxPackedSize];
+};
+
+// Recognition -> engine: the best hypothesis of an utterance.
+struct MoveCommand {
+    Chess::Move move;
+    int32_t margin;   // score lead over the runner-up, Q8; large when only one move fit
+    uint16_t traceId; // Trace::voiceId of the utterance
+};
+
+// Control -> engine: a typed move (SAN, UCI or a spoken phrase), e.g. from a
+// serial console or a host tool.
+struct TextCommand {
+    char text[24];
+    uint16_t traceId; // Trace::typedId
+};
+
+// Engine -> control/motion.
+struct EngineEvent {
+    enum class Kind : uint8_t { Played, Rejected, GameOver, NewGame };
+    Kind kind;
+    bool byEngine;
+    Chess::Move move;    // Played: the move; Rejected: what was asked for, if known
+    int16_t score;       // engine moves: centipawns for the engine
+    uint8_t depth;
+    uint32_t thinkMs;
+    uint16_t traceId;    // of the command that led to it; the control stage stamps motion with it
+};
+
+struct PipelineConfig {
+    // capture is alone on core 0 so nothing else can delay draining the DMA
+    // ring; recognition preempts the engine's search on core 1
+    Util::TaskConfig capture{"capture", 0, 10, 4096};
+    Util::TaskConfig recognition{"recognize", 1, 6, 12288};
+    // search frames are ~200 B a ply (per-ply lists live in Search::Worker),
+    // so MaxPly plies take ~13 KB on top of think(); measured ~11 KB used at
+    // depth 20+ on the host. engineStackFree in the stats shows the margin left
+    Util::TaskConfig engine{"engine", 1, 4, 32768};
+    size_t ttBytes = 256 * 1024;
+    Chess::SearchLimits limits; // per engine reply
+    bool engineReplies = true;  // play the other side after each accepted move
+    const Chess::OpeningBook *book = nullptr; // replies come from it while the game is in book
+    Audio::AudioRecorder *recorder = nullptr; // keeps the latest utterances for replay
+    int blockMs = 50;           // how long commands and events wait for a full queue
+    PipelineConfig() { limits.timeMs = 1500; }
+};
+
+struct PipelineStats {
+    Audio::CaptureStats capture;
+    uint32_t captureGaps;       // frame sequence jumps seen when draining the capture ring
+    Util::ChannelStats speech;  // VAD-gated frames to recognition; drops mean it fell behind
+    Util::ChannelStats commands, text, positions, events;
+    uint32_t utterances;
+    uint32_t featureFrames;
+    uint32_t movesPlayed;
+    // least free stack of each task so far, bytes; the headroom their TaskConfigs leave
+    uint32_t captureStackFree, recognitionStackFree, engineStackFree;
+};
+
+// Capture, recognition and the engine as three tasks joined by SPSC
+// channels:
+//
+//   capture (core 0) --speech--> recognition (core 1) --commands--> engine (core 1) --events--> pollEvent
+//                                      ^-------------------positions-----------'  ^-- text -- submitText
+//
+// Capture only drains the source and runs the VAD, so it never waits on
+// compute; a search can take seconds without losing a frame. Audio is dropped
+// and counted if recognition falls 640 ms behind; commands and events wait
+// up to blockMs for space instead.
+class Pipeline {
+public:
+    Pipeline(Audio::AudioSource &source, Audio::KeywordModel *model, const PipelineConfig &cfg = PipelineConfig());
+    ~Pipeline();
+    bool start();
+    void stop();
+    // continue a game, e.g. one recovered from the journal; before start() only
+    bool setPosition(const Chess::Board &b);
+    // start over from the initial position, any time; the engine task does it
+    // between commands and reports it with a NewGame event
+    void newGame();
+
+    // single producer: the control task
+    bool submitText(const char *text);
+    // single consumer: the control task (later the motion planner)
+    bool pollEvent(EngineEvent &e, int timeoutMs);
+    PipelineStats stats() const;
+
+private:
+    void captureLoop();
+    void recognitionLoop();
+    void engineLoop();
+    void publishPosition();
+    void play(const Chess::Move &m, bool byEngine, const Chess::SearchResult *r, uint16_t traceId);
+
+    PipelineConfig cfg;
+    Audio::AudioSource &source;
+    Audio::SpeechRing speech;
+    Audio::VadGate gate;
+    Audio::Recognizer recognizer;
+    Chess::Game game;     // engine task only once started
+    Chess::Search search;
+
+    Util::Channel<MoveCommand, 4> commands;
+    Util::Channel<TextCommand, 4> text;
+    Util::Channel<PositionUpdate, 4> positions;
+    Util::Channel<EngineEvent, 16> events;
+    Util::Signal recognitionWake; // speech and positions share it
+    Util::Signal engineWake;      // commands and text share it
+
+    Util::Task captureTask, recognitionTask, engineTask;
+    std::atomic<bool> running{false};
+    std::atomic<bool> newGameRequested{false};
+    uint32_t typedCommands = 0; // control task only
+    uint32_t bookRandom = 1;    // engine task only; xorshift state for weighted book picks
+    std::atomic<uint32_t> gaps{0}, utterances{0}, featureFrames{0}, moves{0};
+};
+
+} // namespace App
@@ -0,0 +1,128 @@
+#pragma once
+#include "chess_types.h"
+#include <cstdint>
+
+namespace Chess {
+namespace Psqt {
+
+// midgame and endgame halves of a score, tapered by game phase in evaluate()
+struct Score {
+    int16_t mg = 0, eg = 0;
+    constexpr bool operator==(const Score &o) const { return mg == o.mg && eg == o.eg; }
+};
+
+// phase contributed by each piece by PieceType; the opening total is MaxPhase
+constexpr int PhaseWeight[7] = {0, 0, 1, 1, 2, 4, 0};
+constexpr int MaxPhase = 24;
+
+constexpr int MaterialMg[7] = {0, 82, 337, 365, 477, 1025, 0};
+constexpr int MaterialEg[7] = {0, 94, 281, 297, 512, 936, 0};
+
+// Bonuses from White's side, written as the board is drawn: a8 first, h1 last.
+// Knights, bishops, rooks and queens use one table for both phases.
+constexpr int8_t PawnMg[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     50,  50,  50,  50,  50,  50,  50,  50,
+     10,  10,  20,  30,  30,  20,  10,  10,
+      5,   5,  10,  25,  25,  10,   5,   5,
+      0,   0,   0,  20,  20,   0,   0,   0,
+      5,  -5, -10,   0,   0, -10,  -5,   5,
+      5,  10,  10, -20, -20,  10,  10,   5,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+constexpr int8_t PawnEg[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+     90,  90,  85,  80,  80,  85,  90,  90,
+     50,  50,  45,  40,  40,  45,  50,  50,
+     25,  25,  20,  15,  15,  20,  25,  25,
+     10,  10,   5,   5,   5,   5,  10,  10,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+      0,   0,   0,   0,   0,   0,   0,   0,
+};
+constexpr int8_t Knight[64] = {
+    -50, -40, -30, -30, -30, -30, -40, -50,
+    -40, -20,   0,   0,   0,   0, -20, -40,
+    -30,   0,  10,  15,  15,  10,   0, -30,
+    -30,   5,  15,  20,  20,  15,   5, -30,
+    -30,   0,  15,  20,  20,  15,   0, -30,
+    -30,   5,  10,  15,  15,  10,   5, -30,
+    -40, -20,   0,   5,   5,   0, -20, -40,
+    -50, -40, -30, -30, -30, -30, -40, -50,
+};
+constexpr int8_t Bishop[64] = {
+    -20, -10, -10, -10, -10, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,  10,  10,   5,   0, -10,
+    -10,   5,   5,  10,  10,   5,   5, -10,
+    -10,   0,  10,  10,  10,  10,   0, -10,
+    -10,  10,  10,  10,  10,  10,  10, -10,
+    -10,   5,   0,   0,   0,   0,   5, -10,
+    -20, -10, -10, -10, -10, -10, -10, -20,
+};
+constexpr int8_t Rook[64] = {
+      0,   0,   0,   0,   0,   0,   0,   0,
+      5,  10,  10,  10,  10,  10,  10,   5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+     -5,   0,   0,   0,   0,   0,   0,  -5,
+      0,   0,   0,   5,   5,   0,   0,   0,
+};
+constexpr int8_t Queen[64] = {
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+    -10,   0,   0,   0,   0,   0,   0, -10,
+    -10,   0,   5,   5,   5,   5,   0, -10,
+     -5,   0,   5,   5,   5,   5,   0,  -5,
+      0,   0,   5,   5,   5,   5,   0,  -5,
+    -10,   5,   5,   5,   5,   5,   0, -10,
+    -10,   0,   5,   0,   0,   0,   0, -10,
+    -20, -10, -10,  -5,  -5, -10, -10, -20,
+};
+constexpr int8_t KingMg[64] = {
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -30, -40, -40, -50, -50, -40, -40, -30,
+    -20, -30, -30, -40, -40, -30, -30, -20,
+    -10, -20, -20, -20, -20, -20, -20, -10,
+     20,  20,   0,   0,   0,   0,  20,  20,
+     20,  30,  10,   0,   0,  10,  30,  20,
+};
+constexpr int8_t KingEg[64] = {
+    -50, -40, -30, -20, -20, -30, -40, -50,
+    -30, -20, -10,   0,   0, -10, -20, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  30,  40,  40,  30, -10, -30,
+    -30, -10,  20,  30,  30,  20, -10, -30,
+    -30, -30,   0,   0,   0,   0, -30, -30,
+    -50, -30, -30, -30, -30, -30, -30, -50,
+};
+
+// material plus square bonus per [color][PieceType][square], negated for
+// Black so a position's score is a plain sum, White minus Black
+struct Tables {
+    Score piece[2][7][64];
+};
+
+constexpr Tables makeTables() {
+    const int8_t *mg[7] = {nullptr, PawnMg, Knight, Bishop, Rook, Queen, KingMg};
+    const int8_t *eg[7] = {nullptr, PawnEg, Knight, Bishop, Rook, Queen, KingEg};
+    Tables t{};
+    for (int type=(int)PieceType::Pawn; type<=(int)PieceType::King; ++type)
+        for (int sq=0; sq<64; ++sq) {
+            // tables are drawn rank 8 first: White's a1 is entry 56, Black's a1 mirrors to entry 0
+            int w = sq ^ 56, b = sq;
+            t.piece[0][type][sq] = {(int16_t)(MaterialMg[type] + mg[type][w]), (int16_t)(MaterialEg[type] + eg[type][w])};
+            t.piece[1][type][sq] = {(int16_t)-(MaterialMg[type] + mg[type][b]), (int16_t)-(MaterialEg[type] + eg[type][b])};
+        }
+    return t;
+}
+
+// evaluated at compile time so the tables live in flash/rodata
+inline constexpr Tables tables = makeTables();
+
+} // namespace Psqt
+} // namespace Chess
@@ -0,0 +1,48 @@
+#include "recognizer.h"
+#include "trace.h"
+
+namespace Audio {
+
+Recognizer::Recognizer(KeywordModel *m, const KwsConfig &cfg) : model(m), decoder(cfg) {
+    board.setupInitialPosition();
+}
+
+bool Recognizer::setPosition(const uint8_t *packed, size_t size) {
+    grammarValid = false;
+    return board.unpack(packed, size) != 0;
+}
+
+bool Recognizer::push(const SpeechFrame &sf) {
+    if (sf.flags & SpeechFrame::First) {
+        features.reset();
+        if (model && !grammarValid) {
+            Chess::MoveList legal;
+            board.generateLegal(board.sideToMove, legal);
+            grammar.rebuild(board, legal);
+            grammarValid = true;
+        }
+        if (model) decoder.begin(grammar);
+        inUtterance = true;
+        count = 0;
+    }
+    if (!inUtterance) return false; // joined mid-utterance; wait for the next one
+
+    Features f;
+    if (features.push(sf.frame, f)) {
+        ++hops;
+        if (model) {
+            int16_t scores[ScoreCount];
+            model->score(f, scores);
+            decoder.push(scores);
+        }
+    }
+    if (!(sf.flags & SpeechFrame::Last)) return false;
+    const uint16_t id = Trace::voiceId(sf.frame.sequence);
+    Trace::record(Trace::Point::FeaturesDone, id);
+    inUtterance = false;
+    count = model ? decoder.finish(nbest, NBest) : 0;
+    Trace::record(Trace::Point::DecodeDone, id);
+    return true;
+}
+
+} // namespace Audio
@@ -0,0 +1,46 @@
+#pragma once
+#include "feature_extractor.h"
+#include "kws_decoder.h"
+#include "vad.h"
+
+namespace Audio {
+
+// Acoustic model of the keyword spotter: one feature frame to the
+// log-likelihood of every word state (see KwsDecoder).
+class KeywordModel {
+public:
+    virtual ~KeywordModel() = default;
+    virtual void score(const Features &f, int16_t *scores) = 0; // ScoreCount values
+};
+
+// Recognition stage: VAD-gated speech frames in, n-best legal moves out at
+// the end of each utterance. Keeps its own copy of the position so it can run
+// on another task than the game; the grammar is rebuilt at the next utterance
+// after the position changes. Without a model it only runs the front end.
+class Recognizer {
+public:
+    static constexpr int NBest = 4;
+
+    explicit Recognizer(KeywordModel *model, const KwsConfig &cfg = KwsConfig());
+    // position as Board::pack wrote it; false if malformed
+    bool setPosition(const uint8_t *packed, size_t size);
+    // true when f closed an utterance; its hypotheses are then in results()
+    bool push(const SpeechFrame &f);
+    int resultCount() const { return count; }
+    const KwsHypothesis *results() const { return nbest; }
+    uint32_t featureFrames() const { return hops; }
+
+private:
+    KeywordModel *model;
+    FeatureExtractor features;
+    KwsDecoder decoder;
+    Chess::Board board;
+    Chess::MoveGrammar grammar;
+    bool grammarValid = false;
+    bool inUtterance = false;
+    KwsHypothesis nbest[NBest];
+    int count = 0;
+    uint32_t hops = 0;
+};
+
+} // namespace Audio
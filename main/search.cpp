@@ -0,0 +1,266 @@
+#include "search.h"
+#include "eval.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#ifndef ESP_PLATFORM
+#include <thread>
+#endif
+
+namespace Chess {
+
+constexpr int Infinity = 32000;
+
+static Color opposite(Color c) { return c==Color::White ? Color::Black : Color::White; }
+
+static bool isTactical(const Board &b, const Move &m) { return m.isPromotion() || b.isCapture(m); }
+
+// mate scores are stored relative to the node, not the root
+static int scoreToTT(int s, int ply) { return s > MateScore - MaxPly ? s + ply : s < -MateScore + MaxPly ? s - ply : s; }
+static int scoreFromTT(int s, int ply) { return s > MateScore - MaxPly ? s - ply : s < -MateScore + MaxPly ? s + ply : s; }
+
+// moves the highest-scored remaining move to index i
+static void pickNext(MoveList &moves, int *scores, int i) {
+    int best = i;
+    for (int j=i+1; j<moves.size(); ++j) if (scores[j] > scores[best]) best = j;
+    std::swap(moves[i], moves[best]);
+    std::swap(scores[i], scores[best]);
+}
+
+Search::Search(size_t ttBytes) : tt(ttBytes) {
+    main.id = 0;
+    clear();
+}
+
+Search::~Search() = default;
+
+void Search::clear() {
+    tt.clear();
+    std::memset(main.history, 0, sizeof(main.history));
+    for (auto &k : main.killers) k[0] = k[1] = Move::none();
+    for (auto &h : helpers) std::memset(h->history, 0, sizeof(h->history));
+}
+
+void Search::setThreads(int n) {
+#ifdef ESP_PLATFORM
+    (void)n;
+#else
+    n = std::max(1, std::min(n, 256));
+    helpers.resize(n - 1);
+    for (size_t i=0; i<helpers.size(); ++i) {
+        if (helpers[i]) continue;
+        helpers[i].reset(new Worker());
+        helpers[i]->id = (int)i + 1;
+        std::memset(helpers[i]->history, 0, sizeof(helpers[i]->history));
+    }
+#endif
+}
+
+void Search::prepare(Worker &w, const Board &position) {
+    w.board = position;
+    w.nodes = 0;
+    w.rootBest = Move::none();
+    for (auto &k : w.killers) k[0] = k[1] = Move::none();
+    // keep some ordering knowledge from the previous move, but let it fade
+    for (auto &side : w.history) for (auto &from : side) for (int &h : from) h /= 2;
+}
+
+void Search::countNode(Worker &w) {
+    if ((++w.nodes & 1023) == 0) {
+        sharedNodes.fetch_add(1024, std::memory_order_relaxed);
+        if (outOfTime()) stopped.store(true, std::memory_order_relaxed);
+    }
+}
+
+bool Search::outOfTime() {
+    if (limits.maxNodes && sharedNodes.load(std::memory_order_relaxed) >= limits.maxNodes) return true;
+    if (!limits.timeMs) return false;
+    auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+    return elapsed.count() >= limits.timeMs;
+}
+
+SearchResult Search::think(const Board &position, const SearchLimits &searchLimits) {
+    start = std::chrono::steady_clock::now();
+    limits = searchLimits;
+    sharedNodes.store(0, std::memory_order_relaxed);
+    stopped.store(false, std::memory_order_relaxed);
+    prepare(main, position);
+    Board &board = main.board;
+
+    SearchResult result;
+    MoveList rootMoves;
+    board.generateLegal(board.sideToMove, rootMoves);
+    if (rootMoves.empty()) {
+        bool inCheck = board.isSquareAttacked(board.findKing(board.sideToMove), opposite(board.sideToMove));
+        result.score = inCheck ? -MateScore : 0;
+        return result;
+    }
+    result.best = rootMoves[0];
+
+#ifndef ESP_PLATFORM
+    std::vector<std::thread> pool;
+    pool.reserve(helpers.size());
+    for (auto &h : helpers) {
+        prepare(*h, position);
+        Worker *w = h.get();
+        pool.emplace_back([this, w]() { helperLoop(*w); });
+    }
+#endif
+
+    for (int depth=1; depth<=limits.maxDepth && depth<MaxPly; ++depth) {
+        main.rootBest = Move::none();
+        int score = negamax(main, depth, 0, -Infinity, Infinity);
+        if (stopped.load(std::memory_order_relaxed)) {
+            // an unfinished iteration is only trusted if nothing better exists
+            if (result.depth==0 && !main.rootBest.isNone()) result.best = main.rootBest;
+            break;
+        }
+        result.best = main.rootBest;
+        result.score = score;
+        result.depth = depth;
+        if (std::abs(score) >= MateScore - depth) break; // forced mate found, deeper won't change it
+        // the next iteration typically costs several times this one; don't start what can't finish
+        if (limits.timeMs) {
+            auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start);
+            if (elapsed.count() * 2 >= limits.timeMs) break;
+        }
+    }
+    result.nodes = main.nodes;
+#ifndef ESP_PLATFORM
+    stopped.store(true, std::memory_order_relaxed); // the helpers' results are only in the TT
+    for (std::thread &t : pool) t.join();
+    for (auto &h : helpers) result.nodes += h->nodes;
+#endif
+    result.timeMs = (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - start).count();
+    return result;
+}
+
+// helpers start every other one a ply deeper so the threads spread over depths
+void Search::helperLoop(Worker &w) {
+    for (int depth = 1 + (w.id & 1); depth<=limits.maxDepth && depth<MaxPly; ++depth) {
+        negamax(w, depth, 0, -Infinity, Infinity);
+        if (stopped.load(std::memory_order_relaxed)) break;
+    }
+}
+
+void Search::scoreMoves(const Worker &w, const MoveList &moves, int *scores, Move ttMove, int ply) const {
+    const Board &board = w.board;
+    int side = (int)board.sideToMove;
+    for (int i=0; i<moves.size(); ++i) {
+        const Move &m = moves[i];
+        if (m == ttMove) scores[i] = 1 << 30;
+        else if (isTactical(board, m)) {
+            // MVV-LVA: most valuable victim first, cheapest attacker as tie-break
+            int victim = m.isEnPassant() ? PieceValue[(int)PieceType::Pawn] : PieceValue[(int)board.squares[m.to()].type];
+            if (m.isPromotion()) victim += PieceValue[(int)m.promotion()];
+            scores[i] = (1 << 24) + victim * 16 - (int)board.squares[m.from()].type;
+        }
+        else if (m == w.killers[ply][0]) scores[i] = (1 << 23);
+        else if (m == w.killers[ply][1]) scores[i] = (1 << 23) - 1;
+        else scores[i] = w.history[side][m.from()][m.to()];
+    }
+}
+
+int Search::negamax(Worker &w, int depth, int ply, int alpha, int beta) {
+    Board &board = w.board;
+    if (ply > 0 && (board.isFiftyMoveDraw() || board.repetitions() > 0)) return 0;
+    if (depth <= 0) return quiesce(w, ply, alpha, beta);
+    countNode(w);
+    if (stopped.load(std::memory_order_relaxed)) return 0;
+    if (ply >= MaxPly - 1) return evaluate(board);
+
+    Move ttMove = Move::none();
+    TTEntry e;
+    if (tt.probe(board.key, e)) {
+        ttMove = e.move;
+        int s = scoreFromTT(e.score, ply);
+        if (ply > 0 && e.depth >= depth) {
+            if (e.bound == Bound::Exact) return s;
+            if (e.bound == Bound::Lower && s >= beta) return s;
+            if (e.bound == Bound::Upper && s <= alpha) return s;
+        }
+    }
+
+    Color us = board.sideToMove;
+    bool inCheck = board.isSquareAttacked(board.findKing(us), opposite(us));
+    MoveList &moves = w.moves[ply];
+    board.generateLegal(us, moves);
+    if (moves.empty()) return inCheck ? -MateScore + ply : 0;
+    if (inCheck) ++depth; // check extension
+
+    int *scores = w.scores[ply];
+    scoreMoves(w, moves, scores, ttMove, ply);
+    int origAlpha = alpha;
+    int best = -Infinity;
+    Move bestMove = moves[0];
+    for (int i=0; i<moves.size(); ++i) {
+        pickNext(moves, scores, i);
+        const Move m = moves[i];
+        board.makeMove(m);
+        int score = -negamax(w, depth - 1, ply + 1, -beta, -alpha);
+        board.undoMove();
+        if (stopped.load(std::memory_order_relaxed)) return 0;
+        if (score > best) {
+            best = score;
+            bestMove = m;
+            if (ply == 0) w.rootBest = m;
+            if (score > alpha) alpha = score;
+            if (alpha >= beta) {
+                if (!isTactical(board, m)) {
+                    if (w.killers[ply][0] != m) { w.killers[ply][1] = w.killers[ply][0]; w.killers[ply][0] = m; }
+                    int &h = w.history[(int)us][m.from()][m.to()];
+                    h = std::min(h + depth * depth, 1 << 20);
+                }
+                break;
+            }
+        }
+    }
+    Bound bound = best >= beta ? Bound::Lower : best > origAlpha ? Bound::Exact : Bound::Upper;
+    tt.store(board.key, bestMove, scoreToTT(best, ply), depth, bound);
+    return best;
+}
+
+int Search::quiesce(Worker &w, int ply, int alpha, int beta) {
+    Board &board = w.board;
+    countNode(w);
+    if (stopped.load(std::memory_order_relaxed)) return 0;
+    if (ply >= MaxPly - 1) return evaluate(board);
+
+    Color us = board.sideToMove;
+    bool inCheck = board.isSquareAttacked(board.findKing(us), opposite(us));
+    int best = -Infinity;
+    if (!inCheck) {
+        // stand pat: the side to move can usually do at least as well as doing nothing
+        best = evaluate(board);
+        if (best >= beta) return best;
+        if (best > alpha) alpha = best;
+    }
+
+    MoveList &moves = w.moves[ply];
+    board.generateLegal(us, moves);
+    if (inCheck && moves.empty()) return -MateScore + ply;
+    if (!inCheck) {
+        // only captures and promotions; all evasions are searched when in check
+        int kept = 0;
+        for (int i=0; i<moves.size(); ++i) if (isTactical(board, moves[i])) moves[kept++] = moves[i];
+        moves.resize(kept);
+    }
+
+    int *scores = w.scores[ply];
+    scoreMoves(w, moves, scores, Move::none(), ply);
+    for (int i=0; i<moves.size(); ++i) {
+        pickNext(moves, scores, i);
+        board.makeMove(moves[i]);
+        int score = -quiesce(w, ply + 1, -beta, -alpha);
+        board.undoMove();
+        if (stopped.load(std::memory_order_relaxed)) return 0;
+        if (score > best) {
+            best = score;
+            if (score > alpha) alpha = score;
+            if (alpha >= beta) break;
+        }
+    }
+    return best;
+}
+
+} // namespace Chess
@@ -0,0 +1,83 @@
+#pragma once
+#include "board.h"
+#include "tt.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace Chess {
+
+constexpr int MateScore = 30000;
+constexpr int MaxPly = 64;
+
+struct SearchLimits {
+    int maxDepth = MaxPly - 1;
+    uint32_t timeMs = 0;   // hard budget for the whole search; 0 = unlimited
+    uint64_t maxNodes = 0; // 0 = unlimited
+};
+
+struct SearchResult {
+    Move best = Move::none(); // none only when the side to move has no legal moves
+    int score = 0;            // centipawns from the side to move's point of view
+    int depth = 0;            // last fully completed iteration
+    uint64_t nodes = 0;
+    uint32_t timeMs = 0;
+};
+
+// Iterative-deepening negamax alpha-beta with quiescence search, a
+// transposition table and killer/history move ordering. The TT size is fixed
+// when the Search is created.
+//
+// With more than one thread the search is Lazy SMP: helper threads run the
+// same iterative deepening on their own copy of the board, half of them a
+// ply ahead, and share only the TT, so each mostly finds work the others
+// have not done yet. The result is the calling thread's.
+class Search {
+public:
+    explicit Search(size_t ttBytes);
+    ~Search();
+    SearchResult think(const Board &position, const SearchLimits &limits);
+    // safe to call from another task/thread while think() runs
+    void stop() { stopped.store(true, std::memory_order_relaxed); }
+    // forget TT contents and ordering statistics, e.g. between games
+    void clear();
+    // threads think() searches with, the caller included; not while it runs.
+    // The device build always uses one.
+    void setThreads(int n);
+    int threads() const { return 1 + (int)helpers.size(); }
+
+private:
+    // per-thread search state
+    struct Worker {
+        Board board; // working copy of the root position
+        Move rootBest; // best move of the iteration in progress
+        Move killers[MaxPly][2];
+        int history[2][64][64];
+        // moves and ordering scores of each ply being searched, kept here
+        // rather than in the recursive frames so the search fits a task stack
+        MoveList moves[MaxPly];
+        int scores[MaxPly][MoveList::Capacity];
+        uint64_t nodes;
+        int id; // 0 for the calling thread
+    };
+
+    void prepare(Worker &w, const Board &position);
+    void helperLoop(Worker &w);
+    int negamax(Worker &w, int depth, int ply, int alpha, int beta);
+    int quiesce(Worker &w, int ply, int alpha, int beta);
+    void scoreMoves(const Worker &w, const MoveList &moves, int *scores, Move ttMove, int ply) const;
+    void countNode(Worker &w);
+    bool outOfTime();
+
+    TranspositionTable tt;
+    Worker main;
+    std::vector<std::unique_ptr<Worker>> helpers; // host only
+    std::atomic<bool> stopped{false};
+    std::atomic<uint64_t> sharedNodes{0}; // all threads, in steps of 1024, for the node limit
+    SearchLimits limits;
+    std::chrono::steady_clock::time_point start;
+};
+
+} // namespace Chess
@@ -0,0 +1,59 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+namespace Util {
+
+// Lock-free single-producer/single-consumer ring of fixed-size slots. The
+// producer may be an ISR. Slots are filled and drained in place
+// (writeSlot/commitWrite, readSlot/releaseRead), so large items such as audio
+// frames are never copied through the queue.
+template<typename T, uint32_t Capacity>
+class SpscRing {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+public:
+    // producer: the next free slot, or nullptr if the ring is full
+    T *writeSlot() {
+        uint32_t h = head.load(std::memory_order_relaxed);
+        if (h - tail.load(std::memory_order_acquire) == Capacity) return nullptr;
+        return &slots[h & (Capacity - 1)];
+    }
+    // producer: publish the slot returned by writeSlot
+    void commitWrite() { head.store(head.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+    bool push(const T &v) {
+        T *s = writeSlot();
+        if (!s) return false;
+        *s = v;
+        commitWrite();
+        return true;
+    }
+
+    // consumer: the oldest published slot, or nullptr if the ring is empty
+    T *readSlot() {
+        uint32_t t = tail.load(std::memory_order_relaxed);
+        if (head.load(std::memory_order_acquire) == t) return nullptr;
+        return &slots[t & (Capacity - 1)];
+    }
+    // consumer: hand the slot returned by readSlot back to the producer
+    void releaseRead() { tail.store(tail.load(std::memory_order_relaxed) + 1, std::memory_order_release); }
+    bool pop(T &v) {
+        T *s = readSlot();
+        if (!s) return false;
+        v = *s;
+        releaseRead();
+        return true;
+    }
+
+    // approximate when called from neither side
+    uint32_t size() const { return head.load(std::memory_order_acquire) - tail.load(std::memory_order_acquire); }
+    static constexpr uint32_t capacity() { return Capacity; }
+
+private:
+    // indices run freely and are masked on access; kept on separate cache
+    // lines so the two sides don't contend
+    alignas(64) std::atomic<uint32_t> head{0};
+    alignas(64) std::atomic<uint32_t> tail{0};
+    alignas(64) T slots[Capacity];
+};
+
+} // namespace Util
@@ -0,0 +1,158 @@
+#include "task.h"
+#include <utility>
+
+#ifdef ESP_PLATFORM
+extern "C" {
+#include "esp_timer.h"
+}
+#else
+#include <algorithm>
+#include <chrono>
+#include <climits>
+#include <cstring>
+#include <sys/mman.h>
+#include <thread>
+#include <unistd.h>
+#ifdef __linux__
+#include <sched.h>
+#endif
+#endif
+
+namespace Util {
+
+#ifdef ESP_PLATFORM
+
+void Task::trampoline(void *self) {
+    Task *t = static_cast<Task *>(self);
+    t->body();
+    xSemaphoreGive(t->finished);
+    vTaskDelete(nullptr);
+}
+
+bool Task::start(const TaskConfig &cfg, std::function<void()> fn) {
+    if (started) return false;
+    if (!finished) finished = xSemaphoreCreateBinary();
+    if (!finished) return false;
+    body = std::move(fn);
+    BaseType_t core = cfg.core < 0 ? tskNO_AFFINITY : cfg.core;
+    // FreeRTOS on the S3 takes the stack depth in bytes
+    if (xTaskCreatePinnedToCore(&Task::trampoline, cfg.name, cfg.stackBytes, this, cfg.priority, &handle, core) != pdPASS)
+        return false;
+    started = true;
+    return true;
+}
+
+void Task::join() {
+    if (!started) return;
+    xSemaphoreTake(finished, portMAX_DELAY);
+    started = false;
+    handle = nullptr;
+}
+
+// in bytes on the S3, like the stack depth given at creation
+uint32_t Task::stackFree() const { return started && handle ? (uint32_t)uxTaskGetStackHighWaterMark(handle) : 0; }
+
+Signal::Signal() : sem(xSemaphoreCreateBinary()) {}
+Signal::~Signal() { vSemaphoreDelete(sem); }
+void Signal::notify() { xSemaphoreGive(sem); }
+bool Signal::wait(int timeoutMs) {
+    return xSemaphoreTake(sem, timeoutMs < 0 ? portMAX_DELAY : pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+}
+
+void sleepMs(uint32_t ms) {
+    // at least one tick, so a short sleep never degenerates into a busy yield
+    TickType_t ticks = pdMS_TO_TICKS(ms);
+    vTaskDelay(ticks ? ticks : 1);
+}
+uint32_t nowMs() { return (uint32_t)(esp_timer_get_time() / 1000); }
+
+#else
+
+void *Task::trampoline(void *self) {
+    static_cast<Task *>(self)->body();
+    return nullptr;
+}
+
+constexpr uint8_t StackPaint = 0xa5;
+
+bool Task::start(const TaskConfig &cfg, std::function<void()> fn) {
+    if (started) return false;
+    body = std::move(fn);
+    // our own mapping rather than the default stack: a guard page below it so
+    // an overflow faults, and painted so stackFree can find the high-water mark
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    size_t stack = (std::max<size_t>(cfg.stackBytes, PTHREAD_STACK_MIN) + page - 1) / page * page;
+    mappingBytes = page + stack;
+    mapping = mmap(nullptr, mappingBytes, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (mapping == MAP_FAILED) { mapping = nullptr; return false; }
+    mprotect(mapping, page, PROT_NONE);
+    std::memset(static_cast<uint8_t *>(mapping) + page, StackPaint, stack);
+    pthread_attr_t attr;
+    pthread_attr_init(&attr);
+    pthread_attr_setstack(&attr, static_cast<uint8_t *>(mapping) + page, stack);
+    int err = pthread_create(&thread, &attr, &Task::trampoline, this);
+    pthread_attr_destroy(&attr);
+    if (err) {
+        munmap(mapping, mappingBytes);
+        mapping = nullptr;
+        return false;
+    }
+#ifdef __linux__
+    if (cfg.core >= 0 && (unsigned)cfg.core < std::thread::hardware_concurrency()) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cfg.core, &set);
+        pthread_setaffinity_np(thread, sizeof(set), &set);
+    }
+    pthread_setname_np(thread, cfg.name);
+#else
+    (void)cfg;
+#endif
+    started = true;
+    return true;
+}
+
+void Task::join() {
+    if (!started) return;
+    pthread_join(thread, nullptr);
+    munmap(mapping, mappingBytes);
+    mapping = nullptr;
+    started = false;
+}
+
+// stacks grow down, so the paint left at the bottom has never been touched
+uint32_t Task::stackFree() const {
+    if (!started) return 0;
+    const uint8_t *p = static_cast<const uint8_t *>(mapping) + sysconf(_SC_PAGESIZE);
+    const uint8_t *end = static_cast<const uint8_t *>(mapping) + mappingBytes;
+    const uint8_t *q = p;
+    while (q < end && *q == StackPaint) ++q;
+    return (uint32_t)(q - p);
+}
+
+Signal::Signal() = default;
+Signal::~Signal() = default;
+
+void Signal::notify() {
+    { std::lock_guard<std::mutex> lock(m); set = true; }
+    cv.notify_one();
+}
+
+bool Signal::wait(int timeoutMs) {
+    std::unique_lock<std::mutex> lock(m);
+    if (timeoutMs < 0) cv.wait(lock, [this]() { return set; });
+    else if (!cv.wait_for(lock, std::chrono::milliseconds(timeoutMs), [this]() { return set; })) return false;
+    set = false;
+    return true;
+}
+
+void sleepMs(uint32_t ms) { std::this_thread::sleep_for(std::chrono::milliseconds(ms)); }
+
+uint32_t nowMs() {
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<milliseconds>(steady_clock::now().time_since_epoch()).count();
+}
+
+#endif
+
+} // namespace Util
@@ -0,0 +1,87 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+
+#ifdef ESP_PLATFORM
+extern "C" {
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+}
+#else
+#include <condition_variable>
+#include <mutex>
+#include <pthread.h>
+#endif
+
+namespace Util {
+
+// FreeRTOS task pinned to a core on target, a pthread on the host (pinned
+// too on Linux; priority is ignored there). Both get stackBytes of stack, so
+// a host run overflows where the device would, give or take the difference
+// in frame sizes; the host stack is painted and guarded so its high-water
+// mark can be read as on the device. The body runs once; a long-lived stage
+// loops until it is told to stop by its owner.
+struct TaskConfig {
+    const char *name = "task";
+    int core = -1;             // -1: any core
+    int priority = 5;          // FreeRTOS priority, higher preempts lower
+    uint32_t stackBytes = 8192;
+};
+
+class Task {
+public:
+    Task() = default;
+    Task(const Task &) = delete;
+    Task &operator=(const Task &) = delete;
+    ~Task() { join(); }
+
+    bool start(const TaskConfig &cfg, std::function<void()> body);
+    // waits for the body to return
+    void join();
+    bool running() const { return started; }
+    // least free stack so far in bytes, while the body runs
+    uint32_t stackFree() const;
+
+private:
+    std::function<void()> body;
+    bool started = false;
+#ifdef ESP_PLATFORM
+    static void trampoline(void *self);
+    SemaphoreHandle_t finished = nullptr;
+    TaskHandle_t handle = nullptr;
+#else
+    static void *trampoline(void *self);
+    pthread_t thread;
+    void *mapping = nullptr; // guard page, then the stack
+    size_t mappingBytes = 0;
+#endif
+};
+
+// Binary event: notify() sets it, wait() takes it. Notifications before the
+// wait are not lost and several collapse into one, which is what a consumer
+// that rechecks its queue after waking needs.
+class Signal {
+public:
+    Signal();
+    ~Signal();
+    Signal(const Signal &) = delete;
+    Signal &operator=(const Signal &) = delete;
+    void notify();
+    // false on timeout; timeoutMs < 0 waits forever
+    bool wait(int timeoutMs);
+
+private:
+#ifdef ESP_PLATFORM
+    SemaphoreHandle_t sem;
+#else
+    std::mutex m;
+    std::condition_variable cv;
+    bool set = false;
+#endif
+};
+
+void sleepMs(uint32_t ms);
+uint32_t nowMs(); // monotonic
+
+} // namespace Util
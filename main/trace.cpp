@@ -0,0 +1,205 @@
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <vector>
+
+#ifdef ESP_PLATFORM
+extern "C" {
+#include "esp_timer.h"
+}
+#else
+#include <chrono>
+#endif
+
+namespace Trace {
+
+static const char *const PointNames[PointCount] = {
+    "speech_end", "vad_end", "features", "decode", "command", "resolved",
+    "motion", "search_start", "search_done", "reply_motion",
+};
+
+const char *pointName(Point p) { return (int)p < PointCount ? PointNames[(int)p] : "?"; }
+
+uint32_t nowUs() {
+#ifdef ESP_PLATFORM
+    return (uint32_t)esp_timer_get_time();
+#else
+    using namespace std::chrono;
+    return (uint32_t)duration_cast<microseconds>(steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+namespace {
+
+static_assert((Capacity & (Capacity - 1)) == 0, "Capacity must be a power of two");
+
+// Any task may record, so slots are claimed with one fetch_add and guarded
+// seqlock-style: seq is 0 while a slot is being written and the claim index
+// + 1 once it is complete, so a reader can skip torn or overwritten slots.
+struct Slot {
+    std::atomic<uint32_t> seq{0};
+    std::atomic<uint32_t> time{0};
+    std::atomic<uint32_t> tag{0}; // id << 8 | point
+};
+
+Slot ring[Capacity];
+std::atomic<uint32_t> head{0};
+
+} // namespace
+
+void recordAt(Point p, uint16_t id, uint32_t timeUs) {
+    uint32_t i = head.fetch_add(1, std::memory_order_relaxed);
+    Slot &s = ring[i & (Capacity - 1)];
+    s.seq.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    s.time.store(timeUs, std::memory_order_relaxed);
+    s.tag.store((uint32_t)id << 8 | (uint32_t)p, std::memory_order_relaxed);
+    s.seq.store(i + 1, std::memory_order_release);
+}
+
+void record(Point p, uint16_t id) { recordAt(p, id, nowUs()); }
+
+int snapshot(Event *out, int max) {
+    uint32_t h = head.load(std::memory_order_acquire);
+    uint32_t first = h > (uint32_t)Capacity ? h - Capacity : 0;
+    int n = 0;
+    for (uint32_t i=first; i!=h && n<max; ++i) {
+        const Slot &s = ring[i & (Capacity - 1)];
+        uint32_t before = s.seq.load(std::memory_order_acquire);
+        uint32_t time = s.time.load(std::memory_order_relaxed), tag = s.tag.load(std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (before != i + 1 || s.seq.load(std::memory_order_relaxed) != before) continue;
+        out[n++] = {time, (uint16_t)(tag >> 8), (Point)(tag & 0xff)};
+    }
+    return n;
+}
+
+void clear() {
+    for (Slot &s : ring) s.seq.store(0, std::memory_order_relaxed);
+}
+
+void dumpEvents(FILE *f, const Event *events, int count) {
+    for (int i=0; i<count; ++i)
+        std::fprintf(f, "TRACE %u %s %u\n", (unsigned)events[i].id, pointName(events[i].point), (unsigned)events[i].timeUs);
+}
+
+bool parseEvent(const char *line, Event &e) {
+    const char *p = std::strstr(line, "TRACE ");
+    if (!p) return false;
+    unsigned id, time;
+    char name[32];
+    if (std::sscanf(p + 6, "%u %31s %u", &id, name, &time) != 3) return false;
+    for (int k=0; k<PointCount; ++k) {
+        if (std::strcmp(name, PointNames[k])) continue;
+        e = {(uint32_t)time, (uint16_t)id, (Point)k};
+        return true;
+    }
+    return false;
+}
+
+void Histogram::clear() { *this = Histogram(); }
+
+int Histogram::bucketOf(uint32_t v) {
+    if (v < (1u << SubBits)) return (int)v;
+    int msb = 31 - __builtin_clz(v);
+    return ((msb - SubBits + 1) << SubBits) | (int)((v >> (msb - SubBits)) & ((1u << SubBits) - 1));
+}
+
+uint32_t Histogram::bucketTop(int b) {
+    if (b < (1 << SubBits)) return (uint32_t)b;
+    int msb = (b >> SubBits) - 1 + SubBits;
+    uint64_t low = (uint64_t)((1 << SubBits) | (b & ((1 << SubBits) - 1))) << (msb - SubBits);
+    return (uint32_t)std::min<uint64_t>(low + ((uint64_t)1 << (msb - SubBits)) - 1, UINT32_MAX);
+}
+
+void Histogram::add(uint32_t us) {
+    ++buckets[bucketOf(us)];
+    ++total;
+    largest = std::max(largest, us);
+}
+
+void Histogram::merge(const Histogram &o) {
+    for (int b=0; b<(int)(sizeof(buckets) / sizeof(buckets[0])); ++b) buckets[b] += o.buckets[b];
+    total += o.total;
+    largest = std::max(largest, o.largest);
+}
+
+uint32_t Histogram::percentile(double q) const {
+    if (!total) return 0;
+    uint32_t rank = (uint32_t)(q * total + 0.5);
+    if (rank < 1) rank = 1;
+    uint32_t seen = 0;
+    for (int b=0; b<(int)(sizeof(buckets) / sizeof(buckets[0])); ++b) {
+        seen += buckets[b];
+        if (seen >= rank) return std::min(bucketTop(b), largest);
+    }
+    return largest;
+}
+
+namespace {
+
+struct Stage {
+    const char *name;
+    Point from, to;
+};
+
+// consecutive stages first, then the end-to-end spans
+const Stage Stages[] = {
+    {"vad hangover", Point::SpeechEnd, Point::VadEnd},
+    {"features", Point::VadEnd, Point::FeaturesDone},
+    {"decode", Point::FeaturesDone, Point::DecodeDone},
+    {"command queue", Point::DecodeDone, Point::CommandReceived},
+    {"resolve + play", Point::CommandReceived, Point::MoveResolved},
+    {"event to motion", Point::MoveResolved, Point::MotionStart},
+    {"search", Point::SearchStart, Point::SearchDone},
+    {"reply to motion", Point::SearchDone, Point::ReplyMotionStart},
+    {"speech end > motion", Point::SpeechEnd, Point::MotionStart},
+    {"vad end > motion", Point::VadEnd, Point::MotionStart},
+    {"command > motion", Point::CommandReceived, Point::MotionStart},
+    {"command > reply", Point::CommandReceived, Point::ReplyMotionStart},
+};
+constexpr int StageCount = sizeof(Stages) / sizeof(Stages[0]);
+
+} // namespace
+
+void printReport(FILE *f, const Event *events, int count) {
+    std::vector<Event> sorted(events, events + count);
+    // by command, keeping each command's events in time order
+    std::stable_sort(sorted.begin(), sorted.end(), [](const Event &a, const Event &b) { return a.id < b.id; });
+    std::vector<Histogram> hist(StageCount);
+    int commands = 0;
+    for (size_t i=0; i<sorted.size(); ) {
+        size_t j = i;
+        uint32_t at[PointCount];
+        bool seen[PointCount] = {};
+        for (; j<sorted.size() && sorted[j].id == sorted[i].id; ++j) {
+            int p = (int)sorted[j].point;
+            if (p < PointCount && !seen[p]) { seen[p] = true; at[p] = sorted[j].timeUs; }
+        }
+        ++commands;
+        for (int s=0; s<StageCount; ++s) {
+            int a = (int)Stages[s].from, b = (int)Stages[s].to;
+            if (!seen[a] || !seen[b]) continue;
+            int32_t d = (int32_t)(at[b] - at[a]); // wraps cleanly every 71 minutes
+            if (d >= 0) hist[s].add((uint32_t)d);
+        }
+        i = j;
+    }
+    std::fprintf(f, "latency over %d commands (%d events), ms\n", commands, count);
+    std::fprintf(f, "%-22s %6s %9s %9s %9s %9s\n", "stage", "count", "p50", "p95", "p99", "max");
+    for (int s=0; s<StageCount; ++s) {
+        const Histogram &h = hist[s];
+        if (!h.count()) continue;
+        std::fprintf(f, "%-22s %6u %9.3f %9.3f %9.3f %9.3f\n", Stages[s].name, (unsigned)h.count(),
+                     h.percentile(0.50) / 1000.0, h.percentile(0.95) / 1000.0, h.percentile(0.99) / 1000.0, h.max() / 1000.0);
+    }
+}
+
+void printReport(FILE *f) {
+    std::vector<Event> events(Capacity);
+    int n = snapshot(events.data(), Capacity);
+    printReport(f, events.data(), n);
+}
+
+} // namespace Trace
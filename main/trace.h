@@ -0,0 +1,83 @@
+#pragma once
+#include <cstdint>
+#include <cstdio>
+
+// Latency tracing from the end of a spoken command to the board acting on it.
+// Stages stamp events into a fixed lock-free ring; a report groups them by
+// command and prints per-stage percentiles. Recording costs a clock read and
+// one atomic increment, so it stays on in release builds.
+namespace Trace {
+
+// Stage boundaries, in pipeline order. A command's events share an id: the
+// low 15 bits of its utterance's last frame sequence number, or a control-
+// assigned id with the top bit set for typed commands (see voiceId/typedId).
+enum class Point : uint8_t {
+    SpeechEnd,       // last speech-level frame (stamped back from VadEnd by the hangover)
+    VadEnd,          // VAD closed the utterance (capture task)
+    FeaturesDone,    // features of the last frame computed (recognition)
+    DecodeDone,      // n-best ready (recognition)
+    CommandReceived, // engine task dequeued the command
+    MoveResolved,    // resolved and played in the game
+    MotionStart,     // control picked up the player's move for the board
+    SearchStart,
+    SearchDone,
+    ReplyMotionStart, // control picked up the engine's reply
+    Count
+};
+constexpr int PointCount = (int)Point::Count;
+const char *pointName(Point p);
+
+inline uint16_t voiceId(uint32_t frameSequence) { return (uint16_t)(frameSequence & 0x7fff); }
+inline uint16_t typedId(uint32_t counter) { return (uint16_t)(0x8000 | (counter & 0x7fff)); }
+
+struct Event {
+    uint32_t timeUs;
+    uint16_t id;
+    Point point;
+};
+
+// Microseconds from a clock shared by both cores: the system timer on target
+// (each core's cycle counter runs on its own), steady_clock on the host.
+uint32_t nowUs();
+
+void record(Point p, uint16_t id);
+void recordAt(Point p, uint16_t id, uint32_t timeUs);
+
+constexpr int Capacity = 1024; // most recent events kept
+// consistent copy of the ring, oldest first; returns the count
+int snapshot(Event *out, int max);
+void clear();
+
+// one line per event, "TRACE <id> <point> <time-us>"; trace_report reads it back
+void dumpEvents(FILE *f, const Event *events, int count);
+// parses one dumpEvents line, ignoring any prefix (such as an ESP log header)
+bool parseEvent(const char *line, Event &e);
+
+// Latency of each pipeline stage and end to end, over every command whose
+// events bound it, as count/p50/p95/p99/max in ms.
+void printReport(FILE *f, const Event *events, int count);
+// snapshot the ring and report it
+void printReport(FILE *f);
+
+// Log-bucketed latency histogram: 8 buckets per octave, so a percentile is
+// within 12.5% of the true value, in a fixed 1 KB.
+class Histogram {
+public:
+    void clear();
+    void add(uint32_t us);
+    // add another histogram's samples, e.g. one kept per thread
+    void merge(const Histogram &o);
+    uint32_t count() const { return total; }
+    uint32_t max() const { return largest; }
+    // upper bound of the bucket holding the q-th quantile (0..1)
+    uint32_t percentile(double q) const;
+
+private:
+    static constexpr int SubBits = 3;
+    static int bucketOf(uint32_t v);
+    static uint32_t bucketTop(int b);
+    uint32_t buckets[(32 - SubBits + 1) << SubBits] = {};
+    uint32_t total = 0, largest = 0;
+};
+
+} // namespace Trace
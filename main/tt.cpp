@@ -0,0 +1,86 @@
+#include "tt.h"
+#include <cstdlib>
+#include <cstring>
+#ifdef ESP_PLATFORM
+#include "esp_heap_caps.h"
+#endif
+
+namespace Chess {
+
+static void *allocateTable(size_t bytes) {
+#ifdef ESP_PLATFORM
+    // prefer PSRAM so the table does not eat internal SRAM
+    if (void *p = heap_caps_malloc(bytes, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT)) return p;
+#endif
+    return std::malloc(bytes);
+}
+
+static void freeTable(void *p) {
+#ifdef ESP_PLATFORM
+    heap_caps_free(p);
+#else
+    std::free(p);
+#endif
+}
+
+#ifdef ESP_PLATFORM
+static uint64_t load(const uint64_t &w) { return w; }
+static void put(uint64_t &w, uint64_t v) { w = v; }
+#else
+// relaxed is enough: the XOR check catches a slot whose two words disagree
+static uint64_t load(const std::atomic<uint64_t> &w) { return w.load(std::memory_order_relaxed); }
+static void put(std::atomic<uint64_t> &w, uint64_t v) { w.store(v, std::memory_order_relaxed); }
+static_assert(sizeof(std::atomic<uint64_t>) == 8, "TT slots must stay two words");
+#endif
+
+TranspositionTable::TranspositionTable(size_t bytes) {
+    size_t count = 1;
+    while (count * 2 * sizeof(Slot) <= bytes) count *= 2;
+    slots = static_cast<Slot*>(allocateTable(count * sizeof(Slot)));
+    if (!slots) { // fall back to a single slot rather than failing outright
+        count = 1;
+        slots = static_cast<Slot*>(allocateTable(sizeof(Slot)));
+    }
+    mask = count - 1;
+    clear();
+}
+
+TranspositionTable::~TranspositionTable() { freeTable(slots); }
+
+void TranspositionTable::clear() { std::memset(static_cast<void*>(slots), 0, size() * sizeof(Slot)); }
+
+// bits 0-15 move, 16-31 score, 32-39 depth, 40-47 bound; all zero is an empty slot
+uint64_t TranspositionTable::pack(Move move, int score, int depth, Bound bound) {
+    return move.raw() | (uint64_t)(uint16_t)score << 16 | (uint64_t)(uint8_t)depth << 32 | (uint64_t)bound << 40;
+}
+
+void TranspositionTable::unpack(uint64_t data, TTEntry &e) {
+    e.move = Move::fromRaw((uint16_t)data);
+    e.score = (int16_t)(data >> 16);
+    e.depth = (int8_t)(data >> 32);
+    e.bound = (Bound)(data >> 40);
+}
+
+bool TranspositionTable::probe(uint64_t key, TTEntry &out) const {
+    const Slot &s = slots[key & mask];
+    uint64_t data = load(s.data);
+    if ((load(s.check) ^ data) != key) return false;
+    unpack(data, out);
+    out.key = key;
+    return out.bound != Bound::None;
+}
+
+void TranspositionTable::store(uint64_t key, Move move, int score, int depth, Bound bound) {
+    Slot &s = slots[key & mask];
+    TTEntry old;
+    if (probe(key, old)) {
+        // keep a deeper result for the same position; anything else is replaced
+        if (old.depth > depth && bound != Bound::Exact) return;
+        if (move.isNone()) move = old.move; // keep the old best move if we have none
+    }
+    uint64_t data = pack(move, score, depth, bound);
+    put(s.data, data);
+    put(s.check, key ^ data);
+}
+
+} // namespace Chess
@@ -0,0 +1,58 @@
+#pragma once
+#include "move.h"
+#include <cstddef>
+#include <cstdint>
+#ifndef ESP_PLATFORM
+#include <atomic>
+#endif
+
+namespace Chess {
+
+enum class Bound : uint8_t { None = 0, Exact, Lower, Upper };
+
+struct TTEntry {
+    uint64_t key;
+    Move move;
+    int16_t score;
+    int8_t depth;
+    Bound bound;
+};
+
+// Fixed-size table of search results, one entry per slot. The size is chosen
+// once at construction and never grows.
+//
+// Search threads share it without locks: a slot is two 64-bit words, the
+// packed entry and the key XORed with it, so a slot torn by two threads
+// storing at once fails the key check rather than returning one thread's
+// move with the other's score.
+class TranspositionTable {
+public:
+    explicit TranspositionTable(size_t bytes);
+    ~TranspositionTable();
+    TranspositionTable(const TranspositionTable&) = delete;
+    TranspositionTable &operator=(const TranspositionTable&) = delete;
+
+    void clear();
+    // copies out the entry for key; false if that slot holds another position
+    bool probe(uint64_t key, TTEntry &out) const;
+    void store(uint64_t key, Move move, int score, int depth, Bound bound);
+    size_t size() const { return mask + 1; }
+
+private:
+#ifdef ESP_PLATFORM
+    using Word = uint64_t; // one search task on the device
+#else
+    using Word = std::atomic<uint64_t>;
+#endif
+    struct Slot {
+        Word check; // key ^ data
+        Word data;  // move, score, depth and bound, see pack()
+    };
+    static uint64_t pack(Move move, int score, int depth, Bound bound);
+    static void unpack(uint64_t data, TTEntry &e);
+
+    Slot *slots;
+    size_t mask; // slot count - 1 (power of two)
+};
+
+} // namespace Chess
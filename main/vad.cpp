@@ -0,0 +1,102 @@
+#include "vad.h"
+#include "audio_recorder.h"
+#include "dsp_kernels.h"
+
+namespace Audio {
+
+constexpr int CrossingDeadband = 16; // ignore sign flips in low-level hiss around zero
+
+Vad::Vad(const VadConfig &c) : cfg(c) { reset(); }
+
+void Vad::reset() {
+    floor = cfg.minFloor;
+    frames = run = utterance = 0;
+    speech = false;
+}
+
+Vad::Event Vad::process(const Frame &f) {
+    // remove the frame's DC so microphone offset doesn't read as energy
+    int32_t sum = 0;
+    for (int16_t s : f.samples) sum += s;
+    const int32_t mean = sum / FrameSamples;
+    uint32_t energy = 0; // sum of squares >> 6: 160 full-scale samples still fit
+    int crossings = 0, sign = 0;
+    for (int16_t s : f.samples) {
+        int32_t d = s - mean;
+        if (d > 32767) d = 32767;
+        if (d < -32768) d = -32768;
+        energy += (uint32_t)(d * d) >> 6;
+        int sg = d > CrossingDeadband ? 1 : d < -CrossingDeadband ? -1 : 0;
+        if (sg && sg != sign) { crossings += sign != 0; sign = sg; }
+    }
+    const int level = Dsp::log2Q8(energy);
+    lastLevel = level;
+    lastCrossings = crossings;
+
+    Event ev = Event::None;
+    if (frames < cfg.warmupFrames) {
+        floor = frames == 0 ? level : floor + (level - floor) / 2;
+        ++frames;
+    } else if (!speech) {
+        bool candidate = level > floor + cfg.onsetMargin &&
+                         (crossings <= cfg.maxOnsetCrossings || level > floor + cfg.loudMargin);
+        if (!candidate) {
+            run = 0;
+            // falls quickly to quieter noise, rises slowly so speech can't drag it up
+            floor += level < floor ? (level - floor) / 4 : (level - floor) / 32;
+        } else if (++run >= cfg.onsetFrames) {
+            speech = true;
+            run = 0;
+            utterance = cfg.onsetFrames;
+            ev = Event::Start;
+        }
+    } else {
+        ++utterance;
+        if (level > floor) ++floor; // creep, in case the room got louder mid-utterance
+        run = level > floor + cfg.holdMargin ? 0 : run + 1;
+        if (run >= cfg.hangoverFrames || utterance >= cfg.maxUtteranceFrames) {
+            trailing = run;
+            speech = false;
+            run = 0;
+            ev = Event::End;
+        }
+    }
+    if (floor < cfg.minFloor) floor = cfg.minFloor;
+    return ev;
+}
+
+VadGate::VadGate(SpeechRing &o, const VadConfig &cfg) : vad(cfg), out(o) {}
+
+void VadGate::forward(const Frame &f, uint8_t flags) {
+    if (recorder) recorder->push(f, flags);
+    SpeechFrame *s = out.writeSlot();
+    if (!s) { ++droppedFrames; return; }
+    s->flags = flags;
+    s->frame = f;
+    out.commitWrite();
+}
+
+Vad::Event VadGate::push(const Frame &f) {
+    Vad::Event ev = vad.process(f);
+    if (ev == Vad::Event::Start) {
+        // replay the buffered onset, oldest first
+        uint8_t flags = SpeechFrame::First;
+        for (int i=0; i<onsetCount; ++i) {
+            forward(onset[(onsetNext - onsetCount + i + MaxOnset) % MaxOnset], flags);
+            flags = 0;
+        }
+        onsetCount = 0;
+        forward(f, flags);
+    } else if (ev == Vad::Event::End) {
+        forward(f, SpeechFrame::Last);
+    } else if (vad.inSpeech()) {
+        forward(f, 0);
+    } else {
+        onset[onsetNext] = f;
+        onsetNext = (onsetNext + 1) % MaxOnset;
+        if (onsetCount < MaxOnset) ++onsetCount;
+    }
+    return ev;
+}
+
+} // namespace Audio
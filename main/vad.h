@@ -0,0 +1,86 @@
+#pragma once
+#include "audio_capture.h"
+#include "channel.h"
+
+namespace Audio {
+
+class AudioRecorder;
+
+// Levels are log2 of frame energy in Q8: 256 is a factor of two in energy, ~3 dB.
+struct VadConfig {
+    int onsetMargin = 2 * 256;      // above the noise floor to start an utterance (~6 dB)
+    int holdMargin = 2 * 256;       // above the floor to count as speech inside one
+    int loudMargin = 6 * 256;       // onset regardless of zero crossings (~18 dB)
+    int minFloor = 12 * 256;        // floor never drops below this (digital silence)
+    int maxOnsetCrossings = 60;     // per frame; white noise is ~80, voiced speech 10-40
+    int onsetFrames = 3;            // consecutive speech frames to confirm a start
+    int hangoverFrames = 30;        // non-speech frames before an utterance ends
+    int maxUtteranceFrames = 500;   // force an end so recognition stays bounded
+    int warmupFrames = 10;          // frames spent learning the floor before any decision
+};
+
+// Streaming voice activity detector in integer arithmetic: per-frame energy
+// and zero crossings, an asymmetric noise-floor tracker, an onset counter and
+// a hangover. One call per frame.
+class Vad {
+public:
+    enum class Event : uint8_t { None, Start, End };
+
+    explicit Vad(const VadConfig &cfg = VadConfig());
+    void reset();
+    // Start is returned on the frame that confirms speech, so the
+    // onsetFrames - 1 frames before it were speech too. End is returned on
+    // the utterance's last frame.
+    Event process(const Frame &f);
+    bool inSpeech() const { return speech; }
+    int level() const { return lastLevel; }     // Q8 log2 energy of the last frame
+    int noiseFloor() const { return floor; }    // Q8 log2
+    int crossings() const { return lastCrossings; }
+    // on End: frames since the last one at speech level, i.e. how far the
+    // actual end of speech lies behind the event (the hangover, unless forced)
+    int trailingFrames() const { return trailing; }
+
+private:
+    VadConfig cfg;
+    int floor;
+    int lastLevel = 0, lastCrossings = 0;
+    int frames;       // processed since reset, saturating
+    int run;          // consecutive frames on the other side of the decision
+    int utterance;    // frames in the current utterance
+    int trailing = 0;
+    bool speech;
+};
+
+struct SpeechFrame {
+    enum : uint8_t { First = 1, Last = 2 };
+    uint8_t flags; // utterance boundaries
+    Frame frame;
+};
+
+using SpeechRing = Util::Channel<SpeechFrame, 64>; // crosses from the capture task to recognition
+
+// Sits between capture and recognition and forwards only utterances, each
+// opened with its onset frames so the first phoneme isn't clipped.
+class VadGate {
+public:
+    explicit VadGate(SpeechRing &out, const VadConfig &cfg = VadConfig());
+    // returns the detector's event for this frame
+    Vad::Event push(const Frame &f);
+    const Vad &detector() const { return vad; }
+    // also hand every forwarded frame to recorder, even ones dropped for a full ring
+    void setRecorder(AudioRecorder *r) { recorder = r; }
+    uint32_t dropped() const { return droppedFrames; } // output ring was full
+
+private:
+    static constexpr int MaxOnset = 8;
+    void forward(const Frame &f, uint8_t flags);
+
+    Vad vad;
+    SpeechRing &out;
+    AudioRecorder *recorder = nullptr;
+    Frame onset[MaxOnset]; // recent frames, kept until an onset is confirmed or ruled out
+    int onsetCount = 0, onsetNext = 0;
+    uint32_t droppedFrames = 0;
+};
+
+} // namespace Audio
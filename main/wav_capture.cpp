@@ -0,0 +1,120 @@
+#include "wav_capture.h"
+#include <chrono>
+#include <cstring>
+
+namespace Audio {
+
+static uint32_t le32(const uint8_t *p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+static uint16_t le16(const uint8_t *p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+WavCapture::WavCapture(const std::string &p, double s) : path(p), speed(s) {}
+
+WavCapture::~WavCapture() { stop(); }
+
+// Checks the header and leaves f positioned at the first sample.
+static bool seekToSamples(FILE *f, uint32_t &dataBytes, std::string &err) {
+    uint8_t riff[12];
+    if (std::fread(riff, 1, 12, f) != 12 || std::memcmp(riff, "RIFF", 4) || std::memcmp(riff + 8, "WAVE", 4)) {
+        err = "not a WAV file";
+        return false;
+    }
+    bool haveFormat = false;
+    uint8_t hdr[8];
+    while (std::fread(hdr, 1, 8, f) == 8) {
+        uint32_t size = le32(hdr + 4);
+        if (!std::memcmp(hdr, "fmt ", 4)) {
+            uint8_t fmt[16];
+            if (size < 16 || std::fread(fmt, 1, 16, f) != 16) break;
+            uint16_t format = le16(fmt), channels = le16(fmt + 2), bits = le16(fmt + 14);
+            uint32_t rate = le32(fmt + 4);
+            if (format != 1 || channels != 1 || bits != 16 || rate != (uint32_t)SampleRate) {
+                err = "need 16 kHz mono 16-bit PCM";
+                return false;
+            }
+            haveFormat = true;
+            std::fseek(f, (long)(size - 16 + (size & 1)), SEEK_CUR);
+        } else if (!std::memcmp(hdr, "data", 4)) {
+            if (!haveFormat) break;
+            dataBytes = size;
+            return true;
+        } else {
+            std::fseek(f, (long)(size + (size & 1)), SEEK_CUR); // chunks are word aligned
+        }
+    }
+    err = "missing fmt or data chunk";
+    return false;
+}
+
+bool loadWav(const std::string &path, std::vector<int16_t> &pcm, std::string &err) {
+    FILE *f = std::fopen(path.c_str(), "rb");
+    if (!f) { err = "cannot open " + path; return false; }
+    uint32_t bytes = 0;
+    bool ok = seekToSamples(f, bytes, err);
+    if (ok) {
+        pcm.resize(bytes / sizeof(int16_t));
+        pcm.resize(std::fread(pcm.data(), sizeof(int16_t), pcm.size(), f));
+    }
+    std::fclose(f);
+    return ok;
+}
+
+static void put32(FILE *f, uint32_t v) { uint8_t b[4] = {(uint8_t)v, (uint8_t)(v >> 8), (uint8_t)(v >> 16), (uint8_t)(v >> 24)}; std::fwrite(b, 1, 4, f); }
+static void put16(FILE *f, uint16_t v) { uint8_t b[2] = {(uint8_t)v, (uint8_t)(v >> 8)}; std::fwrite(b, 1, 2, f); }
+
+bool saveWav(const std::string &path, const int16_t *pcm, size_t count) {
+    FILE *f = std::fopen(path.c_str(), "wb");
+    if (!f) return false;
+    uint32_t bytes = (uint32_t)(count * sizeof(int16_t));
+    std::fwrite("RIFF", 1, 4, f); put32(f, 36 + bytes); std::fwrite("WAVE", 1, 4, f);
+    std::fwrite("fmt ", 1, 4, f); put32(f, 16); put16(f, 1); put16(f, 1);
+    put32(f, SampleRate); put32(f, SampleRate * 2); put16(f, 2); put16(f, 16);
+    std::fwrite("data", 1, 4, f); put32(f, bytes);
+    std::fwrite(pcm, sizeof(int16_t), count, f);
+    return std::fclose(f) == 0;
+}
+
+bool WavCapture::start() {
+    if (worker.joinable()) return true;
+    err.clear();
+    file = std::fopen(path.c_str(), "rb");
+    if (!file) { err = "cannot open " + path; return false; }
+    if (!seekToSamples(file, dataBytes, err)) {
+        std::fclose(file);
+        file = nullptr;
+        return false;
+    }
+    resetCounters();
+    stopping.store(false);
+    done.store(false);
+    worker = std::thread(&WavCapture::run, this);
+    return true;
+}
+
+void WavCapture::stop() {
+    stopping.store(true);
+    if (worker.joinable()) worker.join();
+    if (file) { std::fclose(file); file = nullptr; }
+}
+
+void WavCapture::run() {
+    using Clock = std::chrono::steady_clock;
+    const auto framePeriod = std::chrono::duration<double>(speed > 0 ? FrameSamples / (SampleRate * speed) : 0);
+    const auto begin = Clock::now();
+    uint32_t remaining = dataBytes / sizeof(int16_t);
+    for (uint64_t i=0; remaining && !stopping.load(std::memory_order_relaxed); ++i) {
+        if (speed > 0) std::this_thread::sleep_until(begin + std::chrono::duration_cast<Clock::duration>(framePeriod * (double)i));
+        else while (ring.size() == ring.capacity() && !stopping.load(std::memory_order_relaxed)) std::this_thread::yield();
+        int n = remaining < (uint32_t)FrameSamples ? (int)remaining : FrameSamples;
+        remaining -= n;
+        Frame *f = beginFrame();
+        if (!f) { std::fseek(file, n * (long)sizeof(int16_t), SEEK_CUR); continue; } // a real mic would lose it too
+        // samples are read straight into the ring slot; the host is little endian like the target
+        size_t got = std::fread(f->samples, sizeof(int16_t), n, file);
+        if (got < (size_t)n) remaining = 0; // truncated file
+        std::memset(f->samples + got, 0, (FrameSamples - got) * sizeof(int16_t));
+        endFrame();
+    }
+    done.store(true, std::memory_order_release);
+}
+
+} // namespace Audio
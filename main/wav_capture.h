@@ -0,0 +1,44 @@
+#pragma once
+#include "audio_capture.h"
+#include <atomic>
+#include <cstdio>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace Audio {
+
+// reads a whole 16 kHz mono 16-bit PCM WAV file
+bool loadWav(const std::string &path, std::vector<int16_t> &pcm, std::string &err);
+// writes 16 kHz mono 16-bit PCM as a WAV file
+bool saveWav(const std::string &path, const int16_t *pcm, size_t count);
+
+// Host stand-in for the microphone: streams a 16 kHz mono 16-bit PCM WAV file
+// into the frame ring from a thread. speed 1 paces frames in real time, 4
+// runs four times faster, and 0 runs unthrottled. When unthrottled the
+// producer waits for ring space instead of dropping, so a replay is lossless
+// however slow the consumer is.
+class WavCapture : public AudioSource {
+public:
+    explicit WavCapture(const std::string &path, double speed = 1.0);
+    ~WavCapture() override;
+    bool start() override; // false if the file is missing or not 16 kHz mono 16-bit PCM
+    void stop() override;
+    // the whole file has been delivered (or dropped)
+    bool finished() const { return done.load(std::memory_order_acquire); }
+    const std::string &error() const { return err; }
+
+private:
+    void run();
+
+    std::string path;
+    double speed;
+    std::string err;
+    FILE *file = nullptr;
+    uint32_t dataBytes = 0;
+    std::thread worker;
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> done{false};
+};
+
+} // namespace Audio
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstdint>
+
+namespace Chess {
+namespace Zobrist {
+
+struct Keys {
+    uint64_t piece[2][7][64]; // [color][PieceType][square]; type 0 unused
+    uint64_t castling[16];    // indexed by the castlingRights bitmask
+    uint64_t enpassant[8];    // by file of the en-passant square
+    uint64_t side;            // xored in when black is to move
+};
+
+// splitmix64, evaluated at compile time so the keys live in flash/rodata
+constexpr uint64_t splitmix(uint64_t &state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+constexpr Keys makeKeys() {
+    Keys k{};
+    uint64_t state = 0x5749'5A41'5244'5321ULL; // fixed seed: keys must match across builds
+    for (auto &color : k.piece)
+        for (auto &type : color)
+            for (auto &sq : type) sq = splitmix(state);
+    // castling keys are the xor of one key per right, so removing a right is one xor
+    uint64_t rights[4] = {splitmix(state), splitmix(state), splitmix(state), splitmix(state)};
+    for (int mask=0; mask<16; ++mask)
+        for (int b=0; b<4; ++b)
+            if (mask & (1 << b)) k.castling[mask] ^= rights[b];
+    for (auto &f : k.enpassant) f = splitmix(state);
+    k.side = splitmix(state);
+    return k;
+}
+
+inline constexpr Keys keys = makeKeys();
+
+} // namespace Zobrist
+} // namespace Chess